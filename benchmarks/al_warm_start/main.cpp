@@ -0,0 +1,144 @@
+#include <hedra/AugmentedLagrangianTraits.h>
+#include <hedra/LMSolver.h>
+#include <hedra/EigenSolverWrapper.h>
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <cmath>
+#include <Eigen/Core>
+#include <Eigen/Sparse>
+
+
+//Compares cold and warm starts of the AugmentedLagrangianTraits, with the default and with the Conn-Gould-Toint penalty schedule (useCGTSchedule), on a series of slightly different problems, as in an interactive deformation:
+//a chain of 2D points follows a moving target, with a smoothness term between neighbours, where every point is constrained to the unit circle. Every frame moves the target by a small rotation.
+
+typedef hedra::optimization::EigenSolverWrapper<Eigen::SimplicialLLT<Eigen::SparseMatrix<double> > > LinearSolver;
+typedef std::chrono::high_resolution_clock Clock;
+
+class CircleChainTraits{
+public:
+    Eigen::VectorXi JERows, JECols;
+    Eigen::VectorXd JEVals;
+    Eigen::VectorXi JCRows, JCCols;
+    Eigen::VectorXd JCVals;
+    int xSize;
+    Eigen::VectorXd EVec, CVec;
+
+    Eigen::VectorXd target;     //xy of every point
+    double smoothCoeff;
+    int numPoints;
+
+    void init(const int _numPoints, const double _smoothCoeff)
+    {
+        numPoints=_numPoints;
+        smoothCoeff=_smoothCoeff;
+        xSize=2*numPoints;
+        target.resize(xSize);
+
+        //position rows, then smoothness rows
+        JERows.resize(2*numPoints+4*(numPoints-1));
+        JECols.resize(JERows.size());
+        JEVals.resize(JERows.size());
+        for (int i=0;i<2*numPoints;i++){
+            JERows(i)=i;
+            JECols(i)=i;
+        }
+        for (int i=0;i<numPoints-1;i++){
+            for (int c=0;c<2;c++){
+                JERows(2*numPoints+4*i+2*c)=JERows(2*numPoints+4*i+2*c+1)=2*numPoints+2*i+c;
+                JECols(2*numPoints+4*i+2*c)=2*i+c;
+                JECols(2*numPoints+4*i+2*c+1)=2*(i+1)+c;
+            }
+        }
+        EVec.resize(2*numPoints+2*(numPoints-1));
+
+        JCRows.resize(2*numPoints);
+        JCCols.resize(2*numPoints);
+        JCVals.resize(2*numPoints);
+        for (int i=0;i<2*numPoints;i++){
+            JCRows(i)=i/2;
+            JCCols(i)=i;
+        }
+        CVec.resize(numPoints);
+    }
+
+    //the targets on a wavy curve around the circle, rotated by the given angle
+    void set_target(const double angle)
+    {
+        for (int i=0;i<numPoints;i++){
+            double t=2.0*M_PI*i/numPoints+angle;
+            double r=1.0+0.3*sin(5.0*t);
+            target.segment(2*i,2)<<r*cos(t), r*sin(t);
+        }
+    }
+
+    void initial_solution(Eigen::VectorXd& x0){x0=target;}
+    void pre_iteration(const Eigen::VectorXd& prevx){}
+    bool post_iteration(const Eigen::VectorXd& x){return false;}
+    bool post_optimization(const Eigen::VectorXd& x){return true;}
+
+    void update_energy(const Eigen::VectorXd& x){
+        EVec.head(2*numPoints)=x-target;
+        for (int i=0;i<numPoints-1;i++)
+            EVec.segment(2*numPoints+2*i,2)=smoothCoeff*(x.segment(2*(i+1),2)-x.segment(2*i,2));
+    }
+
+    void update_constraints(const Eigen::VectorXd& x){
+        for (int i=0;i<numPoints;i++)
+            CVec(i)=x.segment(2*i,2).squaredNorm()-1.0;
+    }
+
+    void update_jacobian(const Eigen::VectorXd& x){
+        JEVals.head(2*numPoints).setOnes();
+        for (int i=0;i<numPoints-1;i++)
+            for (int c=0;c<2;c++){
+                JEVals(2*numPoints+4*i+2*c)=-smoothCoeff;
+                JEVals(2*numPoints+4*i+2*c+1)=smoothCoeff;
+            }
+        JCVals=2.0*x;
+    }
+};
+
+
+int main(int argc, char *argv[])
+{
+    using namespace std;
+    using namespace Eigen;
+
+    int numPoints=(argc>1 ? atoi(argv[1]) : 10000);
+    int numFrames=(argc>2 ? atoi(argv[2]) : 30);
+    const double frameAngle=0.002;
+
+    for (int run=0;run<4;run++){
+        bool useCGTSchedule=(run>=2);
+        int warm=run%2;
+        CircleChainTraits chainTraits;
+        hedra::optimization::AugmentedLagrangianTraits<CircleChainTraits> alTraits;
+        LinearSolver lSolver;
+        hedra::optimization::LMSolver<LinearSolver, hedra::optimization::AugmentedLagrangianTraits<CircleChainTraits> > lmSolver;
+
+        chainTraits.init(numPoints, 2.0);
+        chainTraits.set_target(0.0);
+        alTraits.warmStart=(warm==1);
+        alTraits.useCGTSchedule=useCGTSchedule;
+        alTraits.init(&chainTraits, 20, 10e-8);
+        lmSolver.init(&lSolver, &alTraits, 50);
+
+        int totalBigIterations=0, totalFactorizations=0;
+        double maxError=0.0;
+        Clock::time_point start=Clock::now();
+        for (int frame=0;frame<numFrames;frame++){
+            chainTraits.set_target(frame*frameAngle);
+            lmSolver.solve(false);
+            totalBigIterations+=alTraits.currBigIteration;
+            totalFactorizations+=lmSolver.numFactorizations;
+            maxError=std::max(maxError, alTraits.currError);
+        }
+        double time=std::chrono::duration<double>(Clock::now()-start).count();
+
+        cout<<(useCGTSchedule ? "Conn-Gould-Toint schedule, " : "Default schedule, ")<<(warm ? "warm" : "cold")<<" starts, "<<numFrames<<" frames of "<<numPoints<<" points: "<<(double)totalBigIterations/numFrames<<" big iterations and "<<
+        (double)totalFactorizations/numFrames<<" factorizations per frame, "<<time/numFrames<<"s per frame, largest constraint error "<<maxError<<endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,165 @@
+#include <hedra/polygonal_read_OFF.h>
+#include <hedra/polygonal_edge_topology.h>
+#include <hedra/triangulate_mesh.h>
+#include <hedra/DiscreteShellsTraits.h>
+#include <hedra/AutodiffTraits.h>
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include "../common/grid_spring_traits.h"
+
+
+//Compares the Jacobians of AutodiffTraits (forward-mode dual numbers) against hand-written ones, in values and in time:
+//edge springs on a grid (6 variables per element), against a hand-written traits class, and the dihedral angles of the flaps of a mesh (12 variables per element), against DiscreteShellsTraits.
+
+typedef std::chrono::high_resolution_clock Clock;
+
+
+//the springs of GridSpringTraits, by automatic differentiation
+class AutodiffSpringTraits: public hedra::optimization::AutodiffTraits<AutodiffSpringTraits, 6>{
+public:
+    void init(const Eigen::MatrixXi& EV, const int xSize){
+        Eigen::MatrixXi variables(EV.rows(),6);
+        for (int i=0;i<EV.rows();i++)
+            variables.row(i)<<3*EV(i,0),3*EV(i,0)+1,3*EV(i,0)+2,3*EV(i,1),3*EV(i,1)+1,3*EV(i,1)+2;
+        init_elements(variables, xSize);
+    }
+
+    template<typename Scalar>
+    void element_residuals(const int element, const Scalar* p, Scalar* residuals) const{
+        using std::sqrt;
+        Scalar dx=p[3]-p[0], dy=p[4]-p[1], dz=p[5]-p[2];
+        residuals[0]=sqrt(dx*dx+dy*dy+dz*dz)-1.0;
+    }
+};
+
+//the dihedral residuals of DiscreteShellsTraits, by automatic differentiation, with the same handles and weights
+class AutodiffFlapTraits: public hedra::optimization::AutodiffTraits<AutodiffFlapTraits, 12>{
+public:
+    const hedra::optimization::DiscreteShellsTraits* shells;
+
+    void init(const hedra::optimization::DiscreteShellsTraits& _shells){
+        shells=&_shells;
+        Eigen::MatrixXi variables(shells->flapVertexIndices.rows(),12);
+        for (int i=0;i<variables.rows();i++)
+            for (int k=0;k<4;k++)
+                for (int c=0;c<3;c++){
+                    int v=shells->flapVertexIndices(i,k);
+                    variables(i,3*k+c)=(shells->a2x(v)!=-1 ? 3*shells->a2x(v)+c : -1);
+                }
+        init_elements(variables, shells->xSize);
+    }
+
+    //handles
+    double constant_variable(const int element, const int k) const{
+        int v=shells->flapVertexIndices(element,k/3);
+        for (int i=0;i<shells->h.size();i++)
+            if (shells->h(i)==v)
+                return shells->qh(i,k%3);
+        return 0.0;
+    }
+
+    //the signed dihedral angle is atan2((n1 x n2).eki/|eki|, n1.n2), which equals the arcsine form of DiscreteShellsTraits and is better conditioned for differentiation near flat angles
+    template<typename Scalar>
+    void element_residuals(const int element, const Scalar* p, Scalar* residuals) const{
+        using std::sqrt; using std::atan2;
+        Scalar eji[3], ejk[3], eli[3], elk[3], eki[3];
+        for (int c=0;c<3;c++){
+            eji[c]=p[c]-p[3+c];
+            ejk[c]=p[6+c]-p[3+c];
+            eli[c]=p[c]-p[9+c];
+            elk[c]=p[6+c]-p[9+c];
+            eki[c]=p[c]-p[6+c];
+        }
+        Scalar n1[3]={ejk[1]*eji[2]-ejk[2]*eji[1], ejk[2]*eji[0]-ejk[0]*eji[2], ejk[0]*eji[1]-ejk[1]*eji[0]};
+        Scalar n2[3]={eli[1]*elk[2]-eli[2]*elk[1], eli[2]*elk[0]-eli[0]*elk[2], eli[0]*elk[1]-eli[1]*elk[0]};
+        Scalar n12[3]={n1[1]*n2[2]-n1[2]*n2[1], n1[2]*n2[0]-n1[0]*n2[2], n1[0]*n2[1]-n1[1]*n2[0]};
+        Scalar sine=(n12[0]*eki[0]+n12[1]*eki[1]+n12[2]*eki[2])/sqrt(eki[0]*eki[0]+eki[1]*eki[1]+eki[2]*eki[2]);
+        Scalar cosine=n1[0]*n2[0]+n1[1]*n2[1]+n1[2]*n2[2];
+        residuals[0]=(atan2(sine, cosine)-shells->origDihedrals(element))*shells->Wd(element)*shells->bendCoeff;
+    }
+};
+
+
+template<class Traits>
+double time_jacobian(Traits& traits, const Eigen::VectorXd& x, const int numIterations)
+{
+    Clock::time_point start=Clock::now();
+    for (int i=0;i<numIterations;i++)
+        traits.update_jacobian(x);
+    return std::chrono::duration<double>(Clock::now()-start).count()/numIterations;
+}
+
+
+int main(int argc, char *argv[])
+{
+    using namespace std;
+    using namespace Eigen;
+
+    string meshName=(argc>1 ? argv[1] : TUTORIAL_SHARED_PATH "/Moomoo.off");
+    int numIterations=(argc>2 ? atoi(argv[2]) : 100);
+
+    //springs
+    {
+        const int n=300;
+        MatrixXi EV;
+        grid_edges(n, EV);
+        GridSpringTraits handTraits;
+        AutodiffSpringTraits autodiffTraits;
+        handTraits.init(EV, 3*n*n);
+        autodiffTraits.init(EV, 3*n*n);
+        VectorXd x=VectorXd::Random(3*n*n)*n;
+
+        double handTime=time_jacobian(handTraits, x, numIterations);
+        double autodiffTime=time_jacobian(autodiffTraits, x, numIterations);
+        handTraits.update_energy(x);
+        autodiffTraits.update_energy(x);
+        cout<<"Springs ("<<EV.rows()<<" elements of 6 variables): by hand "<<handTime<<"s, autodiff "<<autodiffTime<<"s (ratio "<<autodiffTime/handTime<<")"<<endl;
+        cout<<"  largest difference of energy entries "<<(handTraits.EVec-autodiffTraits.EVec).lpNorm<Infinity>()<<", of Jacobian entries "<<(handTraits.JVals-autodiffTraits.JVals).lpNorm<Infinity>()<<endl;
+    }
+
+    //flaps
+    {
+        MatrixXd V;
+        VectorXi D;
+        MatrixXi F;
+        if (!hedra::polygonal_read_OFF(meshName, V, D, F)){
+            cout<<"Could not read "<<meshName<<endl;
+            return 1;
+        }
+        MatrixXi T, EV, FE, ET, ETi;
+        MatrixXd FEs;
+        VectorXi TF, innerEdges;
+        hedra::triangulate_mesh(D, F, T, TF);
+        hedra::polygonal_edge_topology(VectorXi::Constant(T.rows(),3), T, EV, FE, ET, ETi, FEs, innerEdges);
+
+        hedra::optimization::DiscreteShellsTraits shells;
+        VectorXi h(1);
+        h<<0;
+        shells.init(V, T, h, EV, ET, ETi, innerEdges);
+        shells.qh=V.row(0);
+        AutodiffFlapTraits autodiffTraits;
+        autodiffTraits.init(shells);
+
+        double scale=(V.colwise().maxCoeff()-V.colwise().minCoeff()).norm();
+        VectorXd x(shells.xSize);
+        for (int i=0;i<V.rows();i++)
+            if (shells.a2x(i)!=-1)
+                x.segment(3*shells.a2x(i),3)=(V.row(i)+10e-3*scale*RowVector3d::Random()).transpose();
+
+        //the shells time includes the edges, which are about a fifth of the work
+        double shellsTime=time_jacobian(shells, x, numIterations);
+        double autodiffTime=time_jacobian(autodiffTraits, x, numIterations);
+        shells.update_energy(x);
+        autodiffTraits.update_energy(x);
+        int numFlapEntries=autodiffTraits.JVals.size();
+        cout<<"Flaps of "<<meshName<<" ("<<autodiffTraits.elementVariables.rows()<<" elements of 12 variables): DiscreteShellsTraits (with edges) "<<shellsTime<<"s, autodiff "<<autodiffTime<<"s (ratio "<<autodiffTime/shellsTime<<")"<<endl;
+        cout<<"  largest difference of energy entries "<<(shells.EVec.tail(autodiffTraits.EVec.size())-autodiffTraits.EVec).lpNorm<Infinity>()<<
+        ", of Jacobian entries "<<(shells.JVals.tail(numFlapEntries)-autodiffTraits.JVals).lpNorm<Infinity>()<<endl;
+    }
+
+    return 0;
+}
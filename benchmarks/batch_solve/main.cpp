@@ -0,0 +1,73 @@
+#include <hedra/BatchSolver.h>
+#include <hedra/LMSolver.h>
+#include <hedra/EigenSolverWrapper.h>
+#include <hedra/CachedOrdering.h>
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+#include <Eigen/Core>
+#include <Eigen/Sparse>
+#include "../common/grid_spring_traits.h"
+
+
+//Solves many small independent problems (edge springs on grids of a few sizes, standing for panels) one after the other, each with its own LMSolver, against BatchSolver, which schedules them on all threads and shares the symbolic analysis between instances of the same pattern.
+
+typedef hedra::optimization::EigenSolverWrapper<Eigen::SimplicialLLT<Eigen::SparseMatrix<double> > > LinearSolver;
+typedef hedra::optimization::EigenSolverWrapper<Eigen::SimplicialLLT<Eigen::SparseMatrix<double>, Eigen::Lower, hedra::optimization::CachedOrdering<Eigen::AMDOrdering<int> > > > CachedLinearSolver;
+
+
+int main(int argc, char *argv[])
+{
+    using namespace std;
+    using namespace Eigen;
+    using namespace hedra::optimization;
+    typedef std::chrono::high_resolution_clock Clock;
+
+    int numInstances=(argc>1 ? atoi(argv[1]) : 1000);
+    int maxIterations=(argc>2 ? atoi(argv[2]) : 50);
+    int numThreads=(argc>3 ? atoi(argv[3]) : hedra::default_num_threads());
+
+    //a few panel sizes, with a few large panels among many small ones
+    const int sizes[4]={6, 8, 10, 20};
+    vector<GridSpringTraits> traits(numInstances);
+    vector<GridSpringTraits*> traitsPointers(numInstances);
+    for (int i=0;i<numInstances;i++){
+        traits[i].init(sizes[(i%10==9 ? 3 : i%3)], i);
+        traitsPointers[i]=&traits[i];
+    }
+
+    //one solver after the other
+    vector<double> serialEnergies(numInstances);
+    Clock::time_point start=Clock::now();
+    for (int i=0;i<numInstances;i++){
+        LinearSolver linearSolver;
+        LMSolver<LinearSolver, GridSpringTraits> solver;
+        solver.init(&linearSolver, &traits[i], maxIterations);
+        solver.solve(false);
+        traits[i].update_energy(solver.x);
+        serialEnergies[i]=traits[i].EVec.squaredNorm();
+    }
+    double serialTime=std::chrono::duration<double>(Clock::now()-start).count();
+
+    BatchSolver<CachedLinearSolver, GridSpringTraits> batchSolver;
+    batchSolver.init(maxIterations, 10e-9, 10e-9, numThreads);
+    vector<BatchSolveResult> results;
+    bool isSolved=batchSolver.solve(traitsPointers, results);
+
+    int numConverged=0;
+    double maxEnergyDifference=0.0, sumTime=0.0;
+    for (int i=0;i<numInstances;i++){
+        numConverged+=(results[i].isConverged ? 1 : 0);
+        maxEnergyDifference=std::max(maxEnergyDifference, std::abs(results[i].finalEnergy-serialEnergies[i]));
+        sumTime+=results[i].time;
+    }
+
+    cout<<numInstances<<" instances, "<<batchSolver.numPatterns<<" patterns, "<<numThreads<<" threads"<<endl;
+    cout<<"Serial LMSolver per instance: "<<serialTime<<"s"<<endl;
+    cout<<"BatchSolver:                  "<<batchSolver.time<<"s (sum over instances "<<sumTime<<"s), all solved: "<<(isSolved ? "yes" : "no")<<", converged: "<<numConverged<<endl;
+    cout<<"Ordering cache hits: "<<CachedOrdering<AMDOrdering<int> >::num_hits()<<", misses: "<<CachedOrdering<AMDOrdering<int> >::num_misses()<<endl;
+    cout<<"Largest difference of final energies: "<<maxEnergyDifference<<endl;
+
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include <hedra/CeresMRSolver.h>
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+
+//Compares the evaluation of the residuals and Jacobians of the cost functions of CeresMRSolver: the analytic ones (FullCRAnalyticError, LengthCRAnalyticError, FullFNAnalyticError) against the autodiff ones that are used with HEDRA_CERES_MR_AUTODIFF, by time and by the largest difference.
+//The elements are random quads (and triads) of unit-scale positions, with unit cross-ratio and normal vectors.
+
+typedef std::chrono::high_resolution_clock Clock;
+
+//evaluates every cost function with all its Jacobians, numIterations times; returns the time per iteration, and the residuals and Jacobians of the last one
+double time_evaluation(const std::vector<ceres::CostFunction*>& costs,
+                       const std::vector<std::vector<double*> >& parameters,
+                       const int numIterations,
+                       Eigen::VectorXd& values)
+{
+    int numBlocks=parameters[0].size();
+    values.resize(costs.size()*4*(1+3*numBlocks));
+    std::vector<double*> jacobians(numBlocks);
+    Clock::time_point start=Clock::now();
+    for (int iter=0;iter<numIterations;iter++){
+        for (int i=0;i<costs.size();i++){
+            double* currValues=values.data()+i*4*(1+3*numBlocks);
+            for (int b=0;b<numBlocks;b++)
+                jacobians[b]=currValues+4+12*b;
+            costs[i]->Evaluate(&parameters[i][0], currValues, &jacobians[0]);
+        }
+    }
+    return std::chrono::duration<double>(Clock::now()-start).count()/numIterations;
+}
+
+void compare(const std::string& name,
+             const std::vector<ceres::CostFunction*>& autodiffCosts,
+             const std::vector<ceres::CostFunction*>& analyticCosts,
+             const std::vector<std::vector<double*> >& parameters,
+             const int numIterations)
+{
+    using namespace std;
+    Eigen::VectorXd autodiffValues, analyticValues;
+    double autodiffTime=time_evaluation(autodiffCosts, parameters, numIterations, autodiffValues);
+    double analyticTime=time_evaluation(analyticCosts, parameters, numIterations, analyticValues);
+    cout<<name<<" ("<<parameters.size()<<" residual blocks): autodiff "<<autodiffTime<<"s, analytic "<<analyticTime<<"s (speedup "<<autodiffTime/analyticTime<<
+    "), largest difference "<<(autodiffValues-analyticValues).lpNorm<Eigen::Infinity>()<<endl;
+    for (int i=0;i<autodiffCosts.size();i++){
+        delete autodiffCosts[i];
+        delete analyticCosts[i];
+    }
+}
+
+
+int main(int argc, char *argv[])
+{
+    using namespace std;
+    using namespace Eigen;
+
+    int numQuads=(argc>1 ? atoi(argv[1]) : 50000);
+    int numIterations=(argc>2 ? atoi(argv[2]) : 20);
+
+    //four vertices and a cross-ratio vector per quad, and three vertices and a normal vector per triad
+    VectorXd positions=VectorXd::Random(12*numQuads);
+    VectorXd vectors(3*numQuads);
+    for (int i=0;i<numQuads;i++)
+        vectors.segment(3*i,3)=Vector3d::Random().normalized();
+    VectorXd lengths=VectorXd::Random(numQuads).array()+2.0;
+    VectorXd angles=VectorXd::Random(numQuads);
+    double factor=2.0;
+
+    vector<vector<double*> > crParameters(numQuads), lengthParameters(numQuads), fnParameters(numQuads);
+    vector<ceres::CostFunction*> autodiffCR(numQuads), analyticCR(numQuads), autodiffLength(numQuads), analyticLength(numQuads), autodiffFN(numQuads), analyticFN(numQuads);
+    for (int i=0;i<numQuads;i++){
+        for (int k=0;k<4;k++)
+            lengthParameters[i].push_back(positions.data()+12*i+3*k);
+        crParameters[i]=lengthParameters[i];
+        crParameters[i].push_back(vectors.data()+3*i);
+        fnParameters[i]=vector<double*>(lengthParameters[i].begin(), lengthParameters[i].begin()+3);
+        fnParameters[i].push_back(vectors.data()+3*i);
+
+        autodiffCR[i]=new AutoDiffCostFunction<FullCRError, 4, 3, 3, 3, 3, 3>(new FullCRError(&lengths(i), &angles(i), &factor));
+        analyticCR[i]=new FullCRAnalyticError(&lengths(i), &angles(i), &factor);
+        autodiffLength[i]=new AutoDiffCostFunction<LengthCRError, 4, 3, 3, 3, 3>(new LengthCRError(&lengths(i), &factor));
+        analyticLength[i]=new LengthCRAnalyticError(&lengths(i), &factor);
+        autodiffFN[i]=new AutoDiffCostFunction<FullFNError, 4, 3, 3, 3, 3>(new FullFNError(&lengths(i), &angles(i), &factor));
+        analyticFN[i]=new FullFNAnalyticError(&lengths(i), &angles(i), &factor);
+    }
+
+    compare("FullCRError", autodiffCR, analyticCR, crParameters, numIterations);
+    compare("LengthCRError", autodiffLength, analyticLength, lengthParameters, numIterations);
+    compare("FullFNError", autodiffFN, analyticFN, fnParameters, numIterations);
+
+    return 0;
+}
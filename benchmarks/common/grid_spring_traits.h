@@ -0,0 +1,87 @@
+#ifndef HEDRA_GRID_SPRING_TRAITS_H
+#define HEDRA_GRID_SPRING_TRAITS_H
+#include <cstdlib>
+#include <Eigen/Core>
+
+
+//The edge springs on a grid that the solver benchmarks (lm_assembly, batch_solve and autodiff) share as a test problem.
+
+//the 2n(n-1) edges of an n by n grid of points, numbered row by row
+inline void grid_edges(const int n, Eigen::MatrixXi& EV)
+{
+    EV.resize(2*n*(n-1),2);
+    int currEdge=0;
+    for (int i=0;i<n;i++)
+        for (int j=0;j<n-1;j++){
+            EV.row(currEdge++)<<n*i+j, n*i+j+1;
+            EV.row(currEdge++)<<n*j+i, n*(j+1)+i;
+        }
+}
+
+//edge springs of rest length 1 between 3D points, where every edge residual depends on the 6 coordinates of its vertices, with hand-written Jacobians
+class GridSpringTraits{
+public:
+    Eigen::VectorXi JRows, JCols;
+    Eigen::VectorXd JVals;
+    int xSize;
+    Eigen::VectorXd EVec;
+
+    Eigen::MatrixXi EV;
+    Eigen::VectorXd initx;  //the initial solution; a new random one for every solve when empty
+
+    //springs on the edges EV of xSize/3 points
+    void init(const Eigen::MatrixXi& _EV, const int _xSize)
+    {
+        EV=_EV;
+        xSize=_xSize;
+        JRows.resize(6*EV.rows());
+        JCols.resize(6*EV.rows());
+        JVals.resize(6*EV.rows());
+        for (int i=0;i<EV.rows();i++){
+            JRows.segment(6*i,6).setConstant(i);
+            JCols.segment(6*i,3)<<3*EV(i,0),3*EV(i,0)+1,3*EV(i,0)+2;
+            JCols.segment(6*i+3,3)<<3*EV(i,1),3*EV(i,1)+1,3*EV(i,1)+2;
+        }
+        EVec.resize(EV.rows());
+    }
+
+    //springs on an n by n grid
+    void init(const int n)
+    {
+        Eigen::MatrixXi gridEV;
+        grid_edges(n, gridEV);
+        init(gridEV, 3*n*n);
+    }
+
+    //springs on an n by n grid, from a random initial solution with a given seed
+    void init(const int n, const int seed)
+    {
+        init(n);
+        std::srand(seed);
+        initx=Eigen::VectorXd::Random(xSize)*n;
+    }
+
+    void initial_solution(Eigen::VectorXd& x0){
+        if (initx.size()==xSize)
+            x0=initx;
+        else
+            x0=Eigen::VectorXd::Random(xSize);
+    }
+    void pre_iteration(const Eigen::VectorXd& prevx){}
+    bool post_iteration(const Eigen::VectorXd& x){return false;}
+    void update_energy(const Eigen::VectorXd& x){
+        for (int i=0;i<EV.rows();i++)
+            EVec(i)=(x.segment(3*EV(i,1),3)-x.segment(3*EV(i,0),3)).norm()-1.0;
+    }
+    void update_jacobian(const Eigen::VectorXd& x){
+        for (int i=0;i<EV.rows();i++){
+            Eigen::Vector3d e=(x.segment(3*EV(i,1),3)-x.segment(3*EV(i,0),3)).normalized();
+            JVals.segment(6*i,3)<<-e;
+            JVals.segment(6*i+3,3)<<e;
+        }
+    }
+    bool post_optimization(const Eigen::VectorXd& x){return true;}
+};
+
+
+#endif
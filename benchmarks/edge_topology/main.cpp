@@ -0,0 +1,210 @@
+#include <fstream>
+#include <hedra/polygonal_read_OFF.h>
+#include <hedra/polygonal_edge_topology.h>
+#include <hedra/build_connectivity.h>
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <Eigen/Core>
+
+
+//Compares the radix-sort polygonal_edge_topology against the original sort-based version, and the serial connectivity setup (polygonal_edge_topology, dcel, vertex_stars) against the threaded build_connectivity, on tutorial meshes tiled up to a given number of corners.
+
+//the original implementation, as the reference
+void reference_polygonal_edge_topology(const Eigen::VectorXi& D,
+                                       const Eigen::MatrixXi& F,
+                                       Eigen::MatrixXi& EV,
+                                       Eigen::MatrixXi& FE,
+                                       Eigen::MatrixXi& EF,
+                                       Eigen::MatrixXi& EFi,
+                                       Eigen::MatrixXd& FEs,
+                                       Eigen::VectorXi& InnerEdges)
+{
+    std::vector<std::vector<int> > ETT;
+    for(int f=0;f<D.rows();++f)
+        for (int i=0;i<D(f);++i)
+        {
+            int v1 = F(f,i);
+            int v2 = F(f,(i+1)%D(f));
+            if (v1 > v2) std::swap(v1,v2);
+            std::vector<int> r(4);
+            r[0] = v1; r[1] = v2;
+            r[2] = f;  r[3] = i;
+            ETT.push_back(r);
+        }
+    std::sort(ETT.begin(),ETT.end());
+
+    int En = 1;
+    for(unsigned i=0;i<ETT.size()-1;++i)
+        if (!((ETT[i][0] == ETT[i+1][0]) && (ETT[i][1] == ETT[i+1][1])))
+            ++En;
+
+    EV = Eigen::MatrixXi::Constant((int)(En),2,-1);
+    FE = Eigen::MatrixXi::Constant((int)(F.rows()),(int)(F.cols()),-1);
+    EF = Eigen::MatrixXi::Constant((int)(En),2,-1);
+    En = 0;
+
+    for(unsigned i=0;i<ETT.size();++i)
+    {
+        if (i == ETT.size()-1 ||
+            !((ETT[i][0] == ETT[i+1][0]) && (ETT[i][1] == ETT[i+1][1])))
+        {
+            std::vector<int>& r1 = ETT[i];
+            EV(En,0)     = r1[0];
+            EV(En,1)     = r1[1];
+            EF(En,0)    = r1[2];
+            FE(r1[2],r1[3]) = En;
+        }
+        else
+        {
+            std::vector<int>& r1 = ETT[i];
+            std::vector<int>& r2 = ETT[i+1];
+            EV(En,0)     = r1[0];
+            EV(En,1)     = r1[1];
+            EF(En,0)    = r1[2];
+            EF(En,1)    = r2[2];
+            FE(r1[2],r1[3]) = En;
+            FE(r2[2],r2[3]) = En;
+            ++i;
+        }
+        ++En;
+    }
+
+    for(unsigned i=0; i<EF.rows(); ++i)
+    {
+        int fid = EF(i,0);
+        bool flip = true;
+        for (int j=0; j<D(fid); ++j)
+        {
+            if ((F(fid,j) == EV(i,0)) && (F(fid,(j+1)%D(fid)) == EV(i,1)))
+                flip = false;
+        }
+
+        if (flip)
+        {
+            int tmp = EF(i,0);
+            EF(i,0) = EF(i,1);
+            EF(i,1) = tmp;
+        }
+    }
+
+    std::vector<int> InnerEdgesVec;
+    EFi=Eigen::MatrixXi::Constant(EF.rows(), 2,-1);
+    FEs=Eigen::MatrixXd::Zero(FE.rows(),FE.cols());
+    for (int i=0;i<EF.rows();i++)
+        for (int k=0;k<2;k++){
+            if (EF(i,k)==-1)
+                continue;
+
+            for (int j=0;j<D(EF(i,k));j++)
+                if (FE(EF(i,k),j)==i)
+                    EFi(i,k)=j;
+        }
+
+    for (int i=0;i<EF.rows();i++){
+        if (EFi(i,0)!=-1) FEs(EF(i,0),EFi(i,0))=1.0;
+        if (EFi(i,1)!=-1) FEs(EF(i,1),EFi(i,1))=-1.0;
+        if ((EF(i,0)!=-1)&&(EF(i,1)!=-1))
+            InnerEdgesVec.push_back(i);
+    }
+
+    InnerEdges.resize(InnerEdgesVec.size());
+    for (size_t i=0;i<InnerEdgesVec.size();i++)
+        InnerEdges(i)=InnerEdgesVec[i];
+}
+
+
+//disjoint copies of the mesh, until there are at least minCorners corners
+void tile_mesh(const Eigen::MatrixXd& V,
+               const Eigen::VectorXi& D,
+               const Eigen::MatrixXi& F,
+               const int minCorners,
+               Eigen::MatrixXd& tiledV,
+               Eigen::VectorXi& tiledD,
+               Eigen::MatrixXi& tiledF)
+{
+    int numCopies=std::max(1, (minCorners+D.sum()-1)/D.sum());
+    tiledV.resize(numCopies*V.rows(),3);
+    tiledD.resize(numCopies*D.rows());
+    tiledF.resize(numCopies*F.rows(),F.cols());
+    for (int c=0;c<numCopies;c++){
+        tiledV.block(c*V.rows(),0,V.rows(),3)=V;
+        tiledD.segment(c*D.rows(),D.rows())=D;
+        for (int f=0;f<F.rows();f++)
+            for (int j=0;j<F.cols();j++)
+                tiledF(c*F.rows()+f,j)=(F(f,j)==-1 ? -1 : F(f,j)+c*V.rows());
+    }
+}
+
+
+int main(int argc, char *argv[])
+{
+    using namespace Eigen;
+    using namespace std;
+    typedef std::chrono::high_resolution_clock Clock;
+
+    int minCorners=(argc>1 ? atoi(argv[1]) : 5000000);
+    vector<string> meshNames;
+    for (int i=2;i<argc;i++)
+        meshNames.push_back(argv[i]);
+    if (meshNames.empty()){
+        meshNames.push_back("eight-smoothed-quads.off");
+        meshNames.push_back("rhombitruncated_cubeoctahedron_fixed.off");
+        meshNames.push_back("hexagon.off");
+    }
+
+    bool allIdentical=true;
+    for (size_t m=0;m<meshNames.size();m++){
+        MatrixXd V, tiledV;
+        VectorXi D, tiledD;
+        MatrixXi F, tiledF;
+        if (!hedra::polygonal_read_OFF(string(TUTORIAL_SHARED_PATH "/")+meshNames[m], V, D, F)){
+            cout<<"Could not read "<<meshNames[m]<<endl;
+            continue;
+        }
+        tile_mesh(V, D, F, minCorners, tiledV, tiledD, tiledF);
+
+        MatrixXi refEV, refFE, refEF, refEFi, EV, FE, EF, EFi;
+        MatrixXd refFEs, FEs;
+        VectorXi refInnerEdges, InnerEdges;
+
+        Clock::time_point start=Clock::now();
+        reference_polygonal_edge_topology(tiledD, tiledF, refEV, refFE, refEF, refEFi, refFEs, refInnerEdges);
+        double referenceTime=std::chrono::duration<double>(Clock::now()-start).count();
+
+        start=Clock::now();
+        hedra::polygonal_edge_topology(tiledD, tiledF, EV, FE, EF, EFi, FEs, InnerEdges);
+        double radixTime=std::chrono::duration<double>(Clock::now()-start).count();
+
+        //the reference leaves FE of the padding at -1 and FEs at 0, as does the new version
+        bool isIdentical=(EV==refEV)&&(FE==refFE)&&(EF==refEF)&&(EFi==refEFi)&&(FEs==refFEs)&&(InnerEdges==refInnerEdges);
+        allIdentical=allIdentical&&isIdentical;
+
+        cout<<meshNames[m]<<": "<<tiledD.rows()<<" faces, "<<tiledD.sum()<<" corners, "<<EV.rows()<<" edges"<<endl;
+        cout<<"  reference (std::sort): "<<referenceTime<<"s"<<endl;
+        cout<<"  radix sort:            "<<radixTime<<"s ("<<referenceTime/radixTime<<"x)"<<endl;
+        cout<<"  identical outputs:     "<<(isIdentical ? "yes" : "NO")<<endl;
+
+        //the full connectivity, as in OneRingSubdivisionData::setup()
+        MatrixXi EH, FH, starVertices, starHalfedges, ringFaces;
+        VectorXi VH, HV, HE, HF, nextH, prevH, twinH, vertexValences, isBoundaryVertex;
+        start=Clock::now();
+        hedra::polygonal_edge_topology(tiledD, tiledF, EV, FE, EF, EFi, FEs, InnerEdges);
+        hedra::dcel(MatrixXi(tiledD), tiledF, EV, EF, EFi, InnerEdges, VH, EH, FH, HV, HE, HF, nextH, prevH, twinH);
+        hedra::vertex_stars(EV, VH, EH, FH, HV, HE, HF, nextH, prevH, twinH, vertexValences, starVertices, starHalfedges, ringFaces, isBoundaryVertex);
+        double serialTime=std::chrono::duration<double>(Clock::now()-start).count();
+
+        int numThreads=hedra::default_num_threads();
+        start=Clock::now();
+        hedra::build_connectivity(tiledD, tiledF, EV, FE, EF, EFi, FEs, InnerEdges, VH, EH, FH, HV, HE, HF, nextH, prevH, twinH, vertexValences, starVertices, starHalfedges, ringFaces, isBoundaryVertex, numThreads);
+        double parallelTime=std::chrono::duration<double>(Clock::now()-start).count();
+
+        cout<<"  serial connectivity:   "<<serialTime<<"s"<<endl;
+        cout<<"  build_connectivity:    "<<parallelTime<<"s with "<<numThreads<<" threads ("<<serialTime/parallelTime<<"x)"<<endl;
+    }
+
+    return (allIdentical ? 0 : 1);
+}
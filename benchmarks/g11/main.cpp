@@ -1,7 +1,9 @@
 #include <hedra/LMSolver.h>
+#include <hedra/GNSolver.h>
 #include <hedra/EigenSolverWrapper.h>
 #include <hedra/check_traits.h>
 #include <iostream>
+#include <cmath>
 #include <Eigen/core>
 #include <hedra/AugmentedLagrangianTraits.h>
 
@@ -99,11 +101,26 @@ int main(int argc, char *argv[])
     using namespace Eigen;
     
     slTraits.init();
+    ctTraits.verbose=true;
     ctTraits.init(&slTraits, 100);
     lmSolver.init(&lSolver, &ctTraits, 1000);
     hedra::optimization::check_traits(ctTraits);
     //exit(0);
     lmSolver.solve(true);
     
+    //the Gauss-Newton solver with each line search, by the evaluations it needs. Each should reach the optimum (+-1/sqrt(2),1/2), where f=x^2+(y-1)^2=0.75, and not the saddle (0,0) with f=1.
+    const hedra::optimization::GNLineSearch lineSearches[3]={hedra::optimization::HALVING, hedra::optimization::ARMIJO, hedra::optimization::CUBIC};
+    const char* lineSearchNames[3]={"halving", "Armijo", "cubic"};
+    for (int i=0;i<3;i++){
+        ctTraits.verbose=false;
+        LinearSolver gnLinearSolver;
+        hedra::optimization::GNSolver<LinearSolver,hedra::optimization::AugmentedLagrangianTraits<g11Traits> > gnSolver;
+        gnSolver.init(&gnLinearSolver, &ctTraits, 100, 10e-6, 10e-9, 10e7, lineSearches[i]);
+        gnSolver.solve(false);
+        double f=gnSolver.x(0)*gnSolver.x(0)+(gnSolver.x(1)-1.0)*(gnSolver.x(1)-1.0);
+        cout<<"Gauss-Newton with "<<lineSearchNames[i]<<" line search: x=("<<gnSolver.x(0)<<","<<gnSolver.x(1)<<"), f="<<f<<(std::abs(f-0.75)<10e-6 ? " (optimum)" : " (NOT the optimum 0.75)")<<
+        ", energy evaluations: "<<gnSolver.numEnergyEvaluations<<", Jacobian evaluations: "<<gnSolver.numJacobianEvaluations<<", factorizations: "<<gnSolver.numFactorizations<<endl;
+    }
+    
     return 0;
 }
@@ -0,0 +1,120 @@
+#include <hedra/polygonal_read_OFF.h>
+#include <hedra/polygonal_edge_topology.h>
+#include <hedra/triangulate_mesh.h>
+#include <hedra/DiscreteShellsTraits.h>
+#include <hedra/complex_moebius_deform.h>
+#include <hedra/incremental_traits.h>
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <Eigen/Core>
+#include <Eigen/Sparse>
+
+
+//Checks that the partial updates of the incremental traits (update_energy(x, changedVariables) and update_jacobian(x, changedVariables)) give the same EVec and JVals as the full updates, for DiscreteShellsTraits and for Moebius2DEdgeDeviationTraits (without exact constraints, with DC and with IAP), and times both.
+//Every step moves a few consecutive variables, as a local edit does; for the Moebius traits, smoothFactor is also reduced in every other step, as in post_iteration(), so that the rescaling of the cached weights is checked too.
+
+typedef std::chrono::high_resolution_clock Clock;
+
+void change_weights(hedra::optimization::DiscreteShellsTraits& traits){}
+void change_weights(hedra::optimization::Moebius2DEdgeDeviationTraits& traits){traits.smoothFactor*=0.9;}
+
+//returns the largest difference between the partial and the full updates
+template<class SolverTraits>
+double check_partial_updates(const std::string& name, SolverTraits& traits, Eigen::VectorXd x, const int numSteps, const int numChanged)
+{
+    using namespace Eigen;
+    traits.update_energy(x);
+    traits.update_jacobian(x);
+    hedra::optimization::IncrementalTracker energyTracker, jacobianTracker;
+    VectorXi changedVariables;
+    energyTracker.changed_variables(x, 0.0, changedVariables);
+    jacobianTracker.changed_variables(x, 0.0, changedVariables);
+
+    double maxDifference=0.0, partialTime=0.0, fullTime=0.0;
+    for (int step=0;step<numSteps;step++){
+        int first=(int)(((long long)step*(x.size()-numChanged))/numSteps);
+        for (int k=0;k<numChanged;k++)
+            x(first+k)+=0.01*(k+1);
+        if (step%2==1)
+            change_weights(traits);
+
+        Clock::time_point start=Clock::now();
+        energyTracker.changed_variables(x, 0.0, changedVariables);
+        traits.update_energy(x, changedVariables);
+        jacobianTracker.changed_variables(x, 0.0, changedVariables);
+        traits.update_jacobian(x, changedVariables);
+        partialTime+=std::chrono::duration<double>(Clock::now()-start).count();
+        VectorXd partialEVec=traits.EVec, partialJVals=traits.JVals;
+
+        start=Clock::now();
+        traits.update_energy(x);
+        traits.update_jacobian(x);
+        fullTime+=std::chrono::duration<double>(Clock::now()-start).count();
+        maxDifference=std::max(maxDifference, std::max((partialEVec-traits.EVec).cwiseAbs().maxCoeff(), (partialJVals-traits.JVals).cwiseAbs().maxCoeff()));
+    }
+
+    std::cout<<name<<": "<<numChanged<<" changed variables of "<<x.size()<<", partial "<<partialTime/numSteps<<"s, full "<<fullTime/numSteps<<"s per update, largest difference "<<maxDifference<<std::endl;
+    return maxDifference;
+}
+
+
+int main(int argc, char *argv[])
+{
+    using namespace std;
+    using namespace Eigen;
+
+    string meshName=(argc>1 ? argv[1] : TUTORIAL_SHARED_PATH "/bar2d.off");
+    int numSteps=(argc>2 ? atoi(argv[2]) : 10);
+    const int numChanged=12;
+
+    MatrixXd V;
+    VectorXi D;
+    MatrixXi F;
+    if (!hedra::polygonal_read_OFF(meshName, V, D, F)){
+        cout<<"Could not read "<<meshName<<endl;
+        return 1;
+    }
+
+    VectorXi handles(2);
+    handles<<0, 1;
+    MatrixXd handlePoses(2,3);
+    handlePoses<<V.row(0), V.row(1);
+    double maxDifference=0.0;
+
+    {
+        MatrixXi T, EV, FE, ET, ETi;
+        MatrixXd FEs;
+        VectorXi TF, innerEdges;
+        hedra::triangulate_mesh(D, F, T, TF);
+        hedra::polygonal_edge_topology(VectorXi::Constant(T.rows(),3), T, EV, FE, ET, ETi, FEs, innerEdges);
+        hedra::optimization::DiscreteShellsTraits traits;
+        traits.init(V, T, handles, EV, ET, ETi, innerEdges);
+        traits.qh=handlePoses;
+        maxDifference=std::max(maxDifference, check_partial_updates("DiscreteShellsTraits", traits, VectorXd::Random(traits.xSize), numSteps, numChanged));
+    }
+
+    const char* exactNames[3]={"", ", exact DC", ", exact IAP"};
+    for (int exact=0;exact<3;exact++){
+        MatrixXi EV, FE, EF, EFi, T;
+        MatrixXd FEs;
+        VectorXi innerEdges, TF;
+        hedra::polygonal_edge_topology(D, F, EV, FE, EF, EFi, FEs, innerEdges);
+        hedra::triangulate_mesh(D, F, T, TF);
+        hedra::ComplexMoebiusData mdata;
+        hedra::complex_moebius_setup(V, D, F, TF, EV, EF, EFi, FE, FEs, innerEdges, mdata);
+        hedra::complex_moebius_precompute(handles, exact==1, exact==2, 0.1, mdata);
+        Coords2Complex(handlePoses, mdata.complexConstPoses);
+        hedra::optimization::Moebius2DEdgeDeviationTraits& traits=mdata.deformTraits;
+        traits.complexConstPoses=mdata.complexConstPoses;
+        traits.smoothFactor=100.0;
+        traits.posFactor=10.0;
+        maxDifference=std::max(maxDifference, check_partial_updates(string("Moebius2DEdgeDeviationTraits")+exactNames[exact], traits, VectorXd::Random(traits.xSize), numSteps, numChanged));
+    }
+
+    //the partial updates evaluate the same expressions as the full ones; only the rescaling of cached weights may differ by rounding
+    bool isEqual=(maxDifference<10e-10);
+    cout<<"Partial updates "<<(isEqual ? "equal" : "DIFFER FROM")<<" the full updates"<<endl;
+    return (isEqual ? 0 : 1);
+}
@@ -75,7 +75,7 @@ int main(int argc, char *argv[])
     
     slTraits.init();
     lmSolver.init(&lSolver, &slTraits, 100);
-    hedra::optimization::check_traits(slTraits, slTraits.xSize);
+    hedra::optimization::check_traits(slTraits);
     lmSolver.solve(true);
     
     return 0;
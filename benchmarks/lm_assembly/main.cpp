@@ -0,0 +1,94 @@
+#include <hedra/LMSolver.h>
+#include <hedra/EigenSolverWrapper.h>
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <Eigen/Core>
+#include <Eigen/Sparse>
+#include "../common/grid_spring_traits.h"
+
+
+//Compares the per-iteration J^T*J+miu*I assembly and factorization of the LMSolver with the in-place scatter plan of EigenSolverWrapper against the original triplet-based assembly.
+
+typedef hedra::optimization::EigenSolverWrapper<Eigen::SimplicialLLT<Eigen::SparseMatrix<double> > > LinearSolver;
+
+
+//the assembly that EigenSolverWrapper::factorize() used before the scatter plan
+template<class EigenSparseSolver>
+bool triplet_factorize(EigenSparseSolver& solver,
+                       Eigen::SparseMatrix<double>& A,
+                       const Eigen::VectorXi& rows,
+                       const Eigen::VectorXi& cols,
+                       const Eigen::VectorXd& values)
+{
+    std::vector<Eigen::Triplet<double> > triplets;
+    for (int i=0;i<rows.size();i++){
+        triplets.push_back(Eigen::Triplet<double> (rows(i), cols(i), values(i)));
+        if (rows(i)!=cols(i))
+            triplets.push_back(Eigen::Triplet<double> (cols(i), rows(i), values(i)));
+    }
+    A.setZero();
+    A.setFromTriplets(triplets.begin(), triplets.end());
+    solver.factorize(A);
+    return (solver.info()==Eigen::Success);
+}
+
+
+GridSpringTraits gsTraits;
+LinearSolver lSolver;
+hedra::optimization::LMSolver<LinearSolver,GridSpringTraits> lmSolver;
+
+
+int main(int argc, char *argv[])
+{
+    using namespace std;
+    using namespace Eigen;
+    typedef std::chrono::high_resolution_clock Clock;
+
+    int n=(argc>1 ? atoi(argv[1]) : 100);
+    int numIterations=(argc>2 ? atoi(argv[2]) : 10);
+
+    gsTraits.init(n);
+
+    Clock::time_point initStart=Clock::now();
+    lmSolver.init(&lSolver, &gsTraits, 100);
+    double initTime=std::chrono::duration<double>(Clock::now()-initStart).count();
+
+    cout<<"Variables: "<<gsTraits.xSize<<", J nonzeros: "<<gsTraits.JVals.size()<<", H entries: "<<lmSolver.HRows.size()<<endl;
+    cout<<"init() (pattern, scatter plan and symbolic analysis): "<<initTime<<"s"<<endl;
+
+    VectorXd x;
+    gsTraits.initial_solution(x);
+    gsTraits.update_jacobian(x);
+
+    //the reference path, with its own symbolic analysis so that both paths factorize the same matrix
+    Eigen::SimplicialLLT<Eigen::SparseMatrix<double> > refSolver;
+    Eigen::SparseMatrix<double> refA=lSolver.A;
+    refSolver.analyzePattern(refA);
+
+    double tripletTime=0.0, scatterTime=0.0, numericTime=0.0;
+    for (int i=0;i<numIterations;i++){
+        double miu=1.0+i;
+        lmSolver.MatrixValues(lmSolver.HRows, lmSolver.HCols, gsTraits.JVals, lmSolver.S2D, miu, lmSolver.HVals);
+
+        Clock::time_point start=Clock::now();
+        triplet_factorize(refSolver, refA, lmSolver.HRows, lmSolver.HCols, lmSolver.HVals);
+        tripletTime+=std::chrono::duration<double>(Clock::now()-start).count();
+
+        start=Clock::now();
+        lSolver.factorize(lmSolver.HVals, true);
+        scatterTime+=std::chrono::duration<double>(Clock::now()-start).count();
+
+        //the numerical factorization alone, shared by both paths
+        start=Clock::now();
+        lSolver.solver.factorize(lSolver.A);
+        numericTime+=std::chrono::duration<double>(Clock::now()-start).count();
+    }
+
+    cout<<"Difference between assembled matrices: "<<(refA-lSolver.A).norm()<<endl;
+    cout<<"Per iteration, triplet assembly+factorization: "<<tripletTime/numIterations<<"s"<<endl;
+    cout<<"Per iteration, scatter plan+factorization:     "<<scatterTime/numIterations<<"s"<<endl;
+    cout<<"Per iteration, numerical factorization alone:  "<<numericTime/numIterations<<"s"<<endl;
+
+    return 0;
+}
@@ -0,0 +1,150 @@
+#include <hedra/moebius_regular_meshes.h>
+#include <hedra/polygonal_read_OFF.h>
+#include <hedra/polygonal_edge_topology.h>
+#include <hedra/triangulate_mesh.h>
+#include <igl/boundary_loop.h>
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <Eigen/Core>
+#include <Eigen/Sparse>
+
+
+//Compares the native solver of Moebius regular meshes (MoebiusRegularTraits with LMSolver) against the Ceres one (CeresMRSolver), on the setup of tutorial/304_RegularMeshes: the boundary vertices are the handles, and the Euclidean regularity coefficient is raised in steps, as with the '3' key of the tutorial.
+//Without Ceres (HEDRA_WITHOUT_CERES), only the native solver is timed.
+//The normal matrix that LMSolver assembles from the pattern of MoebiusRegularTraits is also checked against an explicit J^T*J, at the solution of the native solver.
+
+typedef std::chrono::high_resolution_clock Clock;
+
+struct RunResult{
+    double setupTime, solveTime;
+    double MREnergy, EREnergy;
+    Eigen::MatrixXd VRegular;
+};
+
+//the largest difference between the normal matrix of the native solver (without the miu diagonal) and J^T*J from the triplets of the traits, relative to the largest entry of J^T*J
+double normal_matrix_difference(hedra::MoebiusRegularData& MRData)
+{
+    using namespace Eigen;
+    hedra::optimization::MoebiusRegularTraits& traits=MRData.MRTraits;
+    VectorXd x;
+    traits.initial_solution(x);
+    traits.update_jacobian(x);
+
+    std::vector<Triplet<double> > JTriplets;
+    for (int i=0;i<traits.JRows.size();i++)
+        JTriplets.push_back(Triplet<double>(traits.JRows(i), traits.JCols(i), traits.JVals(i)));
+    SparseMatrix<double> J(traits.EVec.size(), traits.xSize);
+    J.setFromTriplets(JTriplets.begin(), JTriplets.end());
+    SparseMatrix<double> JtJ=SparseMatrix<double>(J.transpose()*J).triangularView<Upper>();
+
+    hedra::optimization::LMSolver<hedra::MoebiusRegularData::NativeLinearSolver, hedra::optimization::MoebiusRegularTraits>& solver=MRData.MRLMSolver;
+    VectorXd HVals(solver.HRows.size());
+    solver.MatrixValues(solver.HRows, solver.HCols, traits.JVals, solver.S2D, 0.0, HVals);
+    std::vector<Triplet<double> > HTriplets;
+    for (int i=0;i<HVals.size();i++)
+        HTriplets.push_back(Triplet<double>(solver.HRows(i), solver.HCols(i), HVals(i)));
+    SparseMatrix<double> H(traits.xSize, traits.xSize);
+    H.setFromTriplets(HTriplets.begin(), HTriplets.end());
+
+    double maxEntry=0.0, maxDifference=0.0;
+    for (int k=0;k<JtJ.outerSize();k++)
+        for (SparseMatrix<double>::InnerIterator it(JtJ,k);it;++it)
+            maxEntry=std::max(maxEntry, std::abs(it.value()));
+    SparseMatrix<double> difference=H-JtJ;
+    for (int k=0;k<difference.outerSize();k++)
+        for (SparseMatrix<double>::InnerIterator it(difference,k);it;++it)
+            maxDifference=std::max(maxDifference, std::abs(it.value()));
+    return maxDifference/maxEntry;
+}
+
+RunResult run(const bool useNativeSolver,
+              const Eigen::MatrixXd& VOrig,
+              const Eigen::VectorXi& D,
+              const Eigen::MatrixXi& F,
+              const Eigen::MatrixXi& T,
+              const Eigen::MatrixXi& EV,
+              const Eigen::MatrixXi& FE,
+              const Eigen::MatrixXi& EF,
+              const Eigen::MatrixXi& EFi,
+              const Eigen::MatrixXd& FEs,
+              const Eigen::VectorXi& innerEdges,
+              const Eigen::VectorXi& constIndices,
+              const Eigen::MatrixXd& constPoses,
+              const int numSteps)
+{
+    RunResult result;
+    hedra::MoebiusRegularData MRData;
+    MRData.useNativeSolver=useNativeSolver;
+
+    Clock::time_point start=Clock::now();
+    hedra::setup_moebius_regular(VOrig, D, F, T, EV, FE, EF, EFi, FEs, innerEdges, constIndices, MRData);
+    result.setupTime=std::chrono::duration<double>(Clock::now()-start).count();
+
+    start=Clock::now();
+    for (int step=0;step<numSteps;step++)
+        hedra::compute_moebius_regular(MRData, 1.0, 0.1*(step+1), constPoses, false, result.VRegular);
+    result.solveTime=std::chrono::duration<double>(Clock::now()-start).count();
+
+    result.MREnergy=MRData.deformMR.sum();
+    result.EREnergy=MRData.deformER.sum();
+
+    std::cout<<(useNativeSolver ? "Native" : "Ceres ")<<": setup "<<result.setupTime<<"s, "<<numSteps<<" solves "<<result.solveTime<<"s ("<<result.solveTime/numSteps<<
+    "s per solve), Moebius regularity "<<MRData.origMR.sum()<<" -> "<<result.MREnergy<<", Euclidean regularity "<<MRData.origER.sum()<<" -> "<<result.EREnergy<<std::endl;
+    if (useNativeSolver)
+        std::cout<<"Native normal matrix against J^T*J: largest relative difference "<<normal_matrix_difference(MRData)<<std::endl;
+    return result;
+}
+
+
+int main(int argc, char *argv[])
+{
+    using namespace std;
+    using namespace Eigen;
+
+    string fileName=(argc>1 ? argv[1] : TUTORIAL_SHARED_PATH "/Intersection.off");
+    int numSteps=(argc>2 ? atoi(argv[2]) : 5);
+
+    MatrixXd VOrig, FEs;
+    MatrixXi F, T, EV, FE, EF, EFi;
+    VectorXi D, TF, innerEdges;
+    hedra::polygonal_read_OFF(fileName, VOrig, D, F);
+    hedra::polygonal_edge_topology(D, F, EV, FE, EF, EFi, FEs, innerEdges);
+    hedra::triangulate_mesh(D, F, T, TF);
+
+    //the boundary vertices are the handles, at their original positions
+    vector<vector<int> > boundaryList;
+    igl::boundary_loop(T, boundaryList);
+
+    VectorXi boundaryMask=VectorXi::Zero(VOrig.rows());
+    for (int i=0;i<boundaryList.size();i++)
+        for (int j=0;j<boundaryList[i].size();j++)
+            boundaryMask(boundaryList[i][j])=1;
+
+    VectorXi constIndices(boundaryMask.sum());
+    MatrixXd constPoses(boundaryMask.sum(),3);
+    int counter=0;
+    for (int i=0;i<boundaryMask.size();i++){
+        if (boundaryMask(i)){
+            constIndices(counter)=i;
+            constPoses.row(counter++)=VOrig.row(i);
+        }
+    }
+
+    cout<<fileName<<": "<<VOrig.rows()<<" vertices, "<<F.rows()<<" faces, "<<constIndices.size()<<" handles"<<endl;
+
+    RunResult nativeResult=run(true, VOrig, D, F, T, EV, FE, EF, EFi, FEs, innerEdges, constIndices, constPoses, numSteps);
+
+#ifndef HEDRA_WITHOUT_CERES
+    RunResult ceresResult=run(false, VOrig, D, F, T, EV, FE, EF, EFi, FEs, innerEdges, constIndices, constPoses, numSteps);
+    double diagonal=(VOrig.colwise().maxCoeff()-VOrig.colwise().minCoeff()).norm();
+    cout<<"Speedup "<<ceresResult.solveTime/nativeResult.solveTime<<", largest distance between the results (of the bounding box diagonal) "<<
+    (nativeResult.VRegular-ceresResult.VRegular).rowwise().norm().maxCoeff()/diagonal<<endl;
+#endif
+
+    return 0;
+}
@@ -0,0 +1,158 @@
+#include <hedra/quaternionic_operations.h>
+#include <hedra/moebius_refinement.h>
+#include <hedra/quat_cross_ratio.h>
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <cmath>
+#include <Eigen/Core>
+#include <Eigen/Sparse>
+
+
+//Times the quaternion batch kernels (QMultBatch() etc.) against the batch functions they replaced (the former QMultN() etc., copied below as PreviousQMultN() etc.) and against a loop of the single-quaternion functions (QMult() etc.) on the same rows, with the largest differences between them, and the throughput of the Moebius blends and cross ratios that are built on the chunk kernels.
+
+typedef std::chrono::high_resolution_clock Clock;
+
+//the batch functions of quaternionic_operations.h before the chunk kernels, which allocate their intermediate batches
+Eigen::MatrixXd PreviousQConjN(const Eigen::MatrixXd& q)
+{
+    Eigen::MatrixXd newq(q.rows(), q.cols());
+    newq<<q.col(0), -q.block(0,1,q.rows(),3);
+    return newq;
+}
+
+Eigen::MatrixXd PreviousQMultN(const Eigen::MatrixXd& q1, const Eigen::MatrixXd& q2)
+{
+    Eigen::MatrixXd newq(q1.rows(),4);
+    Eigen::VectorXd r1=q1.col(0);
+    Eigen::VectorXd r2=q2.col(0);
+    Eigen::MatrixXd v1=q1.block(0,1,q1.rows(), 3);
+    Eigen::MatrixXd v2=q2.block(0,1,q2.rows(), 3);
+    Eigen::MatrixXd r1mat; r1mat.resize(r1.rows(),3); r1mat<<r1, r1, r1;
+    Eigen::MatrixXd r2mat; r2mat.resize(r2.rows(),3); r2mat<<r2, r2, r2;
+    newq.col(0)=r1.cwiseProduct(r2)-(v1.cwiseProduct(v2)).rowwise().sum();
+    Eigen::MatrixXd v1cv2; v1cv2.resize(v1.rows(),3);
+    for (int i=0;i<v1.rows();i++){
+        Eigen::Vector3d vv1=v1.row(i);
+        Eigen::Vector3d vv2=v2.row(i);
+        v1cv2.row(i)=vv1.cross(vv2);
+    }
+    newq.block(0,1,newq.rows(),newq.cols()-1)=v1.cwiseProduct(r2mat)+v2.cwiseProduct(r1mat)+v1cv2;
+    return newq;
+}
+
+Eigen::MatrixXd PreviousQInvN(const Eigen::MatrixXd& q)
+{
+    return(PreviousQConjN(q).cwiseQuotient(q.rowwise().squaredNorm().replicate(1,4)));
+}
+
+Eigen::MatrixXd PreviousQLogN(const Eigen::MatrixXd& q)
+{
+    Eigen::VectorXd nq=q.rowwise().norm();
+    Eigen::VectorXd nv=q.block(0,1,q.rows(),q.cols()-1).rowwise().norm();
+    Eigen::VectorXd acosqnq=acos((q.col(0).cwiseQuotient(nq)).array()).matrix().cwiseQuotient(nv);
+    Eigen::MatrixXd acosmat(acosqnq.rows(),3); acosmat<<acosqnq, acosqnq, acosqnq;
+    Eigen::MatrixXd logq(q.rows(),q.cols());
+    logq<<log(nq.array()), q.block(0,1,q.rows(),q.cols()-1).cwiseProduct(acosmat);
+    for (int i=0;i<logq.rows();i++)
+        if (nv(i)<10e-6)
+            logq.row(i)<<log(nq(i)),0.0,0.0,0.0;
+    return logq;
+}
+
+Eigen::MatrixXd PreviousQExpN(const Eigen::MatrixXd& q)
+{
+    Eigen::VectorXd nv=q.block(0,1,q.rows(),q.cols()-1).rowwise().norm();
+    Eigen::VectorXd exp1=exp(q.col(0).array());
+    Eigen::MatrixXd exp1mat(exp1.rows(),4); exp1mat<<exp1,exp1,exp1,exp1;
+    Eigen::MatrixXd expq(q.rows(),q.cols());
+    Eigen::VectorXd sinnv=(sin(nv.array()).matrix()).cwiseQuotient(nv);
+    Eigen::MatrixXd sinnvmat(sinnv.rows(),3); sinnvmat<<sinnv,sinnv,sinnv;
+    expq<<cos(nv.array()), q.block(0,1,q.rows(),q.cols()-1).cwiseProduct(sinnvmat);
+    expq=expq.cwiseProduct(exp1mat);
+    for (int i=0;i<expq.rows();i++)
+        if (nv(i)<10e-6)
+            expq.row(i)<<exp1(i),0.0,0.0,0.0;
+    return expq;
+}
+
+template<typename Func>
+double time_per_iteration(const Func& func, const int numIterations)
+{
+    Clock::time_point start=Clock::now();
+    for (int iter=0;iter<numIterations;iter++)
+        func();
+    return std::chrono::duration<double>(Clock::now()-start).count()/numIterations;
+}
+
+template<typename BatchFunc, typename PreviousFunc, typename RowFunc>
+void compare(const std::string& name, const BatchFunc& batchFunc, const PreviousFunc& previousFunc, const RowFunc& rowFunc, const int numRows, const int numIterations)
+{
+    Eigen::MatrixXd batchResult(numRows,4), previousResult(numRows,4), rowResult(numRows,4);
+    double batchTime=time_per_iteration([&]{batchFunc(batchResult);}, numIterations);
+    double previousTime=time_per_iteration([&]{previousResult=previousFunc();}, numIterations);
+    double rowTime=time_per_iteration([&]{for (int i=0;i<numRows;i++) rowResult.row(i)=rowFunc(i);}, numIterations);
+    std::cout<<name<<": batch "<<batchTime<<"s, previous "<<name<<"N "<<previousTime<<"s (speedup "<<previousTime/batchTime<<", largest difference "<<(batchResult-previousResult).cwiseAbs().maxCoeff()<<
+    "), per row "<<rowTime<<"s (speedup "<<rowTime/batchTime<<", largest difference "<<(batchResult-rowResult).cwiseAbs().maxCoeff()<<")"<<std::endl;
+}
+
+
+int main(int argc, char *argv[])
+{
+    using namespace std;
+    using namespace Eigen;
+
+    int numRows=(argc>1 ? atoi(argv[1]) : 100000);
+    int numIterations=(argc>2 ? atoi(argv[2]) : 20);
+
+    MatrixXd q1=MatrixXd::Random(numRows,4);
+    MatrixXd q2=MatrixXd::Random(numRows,4);
+
+    compare("QMult", [&](MatrixXd& result){QMultBatch(q1, q2, result);}, [&]{return PreviousQMultN(q1, q2);}, [&](const int i){return QMult(q1.row(i), q2.row(i));}, numRows, numIterations);
+    compare("QInv", [&](MatrixXd& result){QInvBatch(q1, result);}, [&]{return PreviousQInvN(q1);}, [&](const int i){return QInv(q1.row(i));}, numRows, numIterations);
+    compare("QConj", [&](MatrixXd& result){QConjBatch(q1, result);}, [&]{return PreviousQConjN(q1);}, [&](const int i){return QConj(q1.row(i));}, numRows, numIterations);
+
+    //log, exp and slerp have no single-quaternion versions; they are compared with the previous batch functions only
+    MatrixXd logq(numRows,4), previousLogq;
+    double logTime=time_per_iteration([&]{QLogBatch(q1, logq);}, numIterations);
+    double previousLogTime=time_per_iteration([&]{previousLogq=PreviousQLogN(q1);}, numIterations);
+    MatrixXd expq(numRows,4), previousExpq;
+    double expTime=time_per_iteration([&]{QExpBatch(logq, expq);}, numIterations);
+    double previousExpTime=time_per_iteration([&]{previousExpq=PreviousQExpN(logq);}, numIterations);
+    cout<<"QLog: batch "<<logTime<<"s, previous QLogN "<<previousLogTime<<"s (speedup "<<previousLogTime/logTime<<", largest difference "<<(logq-previousLogq).cwiseAbs().maxCoeff()<<")"<<endl;
+    cout<<"QExp: batch "<<expTime<<"s, previous QExpN "<<previousExpTime<<"s (speedup "<<previousExpTime/expTime<<", largest difference "<<(expq-previousExpq).cwiseAbs().maxCoeff()<<
+    "), largest exp(log(q))-q "<<(expq-q1).cwiseAbs().maxCoeff()<<endl;
+    MatrixXd slerpq(numRows,4);
+    double slerpTime=time_per_iteration([&]{QSlerpBatch(q1, q2, 0.3, slerpq);}, numIterations);
+    MatrixXd composedSlerp(numRows,4);
+    double composedSlerpTime=time_per_iteration([&]{composedSlerp=PreviousQMultN(q1, PreviousQExpN(PreviousQLogN(PreviousQMultN(PreviousQInvN(q1), q2))*0.3));}, numIterations);
+    cout<<"Slerp: QSlerpBatch "<<slerpTime<<"s, composed from the previous batch functions "<<composedSlerpTime<<"s (speedup "<<composedSlerpTime/slerpTime<<
+    ", largest difference "<<(slerpq-composedSlerp).cwiseAbs().maxCoeff()<<")"<<endl;
+
+    //points near a common circle, as in a subdivision of a circular mesh
+    MatrixXd v[6];
+    for (int k=0;k<6;k++){
+        VectorXd angles=VectorXd::Constant(numRows, 0.5*k)+0.05*VectorXd::Random(numRows);
+        v[k].resize(numRows,3);
+        v[k]<<angles.array().cos().matrix(), angles.array().sin().matrix(), 0.1*VectorXd::Random(numRows);
+    }
+
+    MatrixXd p4, p6;
+    double fourTime=time_per_iteration([&]{p4=hedra::moebius_four_points_blend(v[0], v[1], v[2], v[3]);}, numIterations);
+    double sixTime=time_per_iteration([&]{p6=hedra::moebius_six_points_blend(v[0], v[1], v[2], v[3], v[4], v[5]);}, numIterations);
+    int numSingleRows=std::min(numRows, 10000);
+    double sixSingleTime=time_per_iteration([&]{for (int i=0;i<numSingleRows;i++) p6.row(i)=hedra::moebius_six_points_blend(v[0].row(i), v[1].row(i), v[2].row(i), v[3].row(i), v[4].row(i), v[5].row(i));}, numIterations);
+    cout<<"moebius_four_points_blend "<<fourTime/numRows*1e9<<"ns per blend, moebius_six_points_blend "<<sixTime/numRows*1e9<<"ns per blend in a batch, "<<
+    sixSingleTime/numSingleRows*1e9<<"ns per single-row call"<<endl;
+
+    MatrixXd V=v[0];
+    MatrixXi Q(numRows,4);
+    for (int i=0;i<numRows;i++)
+        Q.row(i)<<i, (i+1)%numRows, (i+2)%numRows, (i+3)%numRows;
+    MatrixXd cr;
+    double crTime=time_per_iteration([&]{hedra::quat_cross_ratio(V, Q, cr);}, numIterations);
+    cout<<"quat_cross_ratio "<<crTime/numRows*1e9<<"ns per quad"<<endl;
+
+    return 0;
+}
@@ -0,0 +1,143 @@
+#include <hedra/polygonal_read_OFF.h>
+#include <hedra/polygonal_edge_topology.h>
+#include <hedra/triangulate_mesh.h>
+#include <hedra/DiscreteShellsTraits.h>
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+
+//Compares the energy and Jacobian assembly of DiscreteShellsTraits, with its batched (SoA) element kernels, against the original per-element assembly with RowVector3d temporaries.
+
+//the per-element assembly that DiscreteShellsTraits used before the batched kernels
+void scalar_update_energy(const hedra::optimization::DiscreteShellsTraits& traits, const Eigen::MatrixXd& fullx, Eigen::VectorXd& EVec)
+{
+    using namespace Eigen;
+    const MatrixXi& EV=traits.EV;
+    const MatrixXi& flaps=traits.flapVertexIndices;
+    for (int i=0;i<EV.rows();i++)
+        EVec(i)=((fullx.row(EV(i,1))-fullx.row(EV(i,0))).norm()-traits.origLengths(i))*traits.Wl(i)*traits.lengthCoeff;
+
+    for (int i=0;i<flaps.rows();i++){
+        RowVector3d eji=fullx.row(flaps(i,0))-fullx.row(flaps(i,1));
+        RowVector3d ejk=fullx.row(flaps(i,2))-fullx.row(flaps(i,1));
+        RowVector3d eli=fullx.row(flaps(i,0))-fullx.row(flaps(i,3));
+        RowVector3d elk=fullx.row(flaps(i,2))-fullx.row(flaps(i,3));
+        RowVector3d eki=fullx.row(flaps(i,0))-fullx.row(flaps(i,2));
+
+        RowVector3d n1 = (ejk.cross(eji));
+        RowVector3d n2 = (eli.cross(elk));
+        double sign=((n1.cross(n2)).dot(eki) >= 0 ? 1.0 : -1.0);
+        double dotn1n2=1.0-n1.normalized().dot(n2.normalized());
+        if (dotn1n2<0.0) dotn1n2=0.0;
+        double sinHalf=sign*sqrt(dotn1n2/2.0);
+        if (sinHalf>1.0)
+            sinHalf=1.0;
+        if (sinHalf<-1.0)
+            sinHalf=-1.0;
+        EVec(EV.rows()+i)=(2.0*asin(sinHalf)-traits.origDihedrals(i))*traits.Wd(i)*traits.bendCoeff;
+    }
+}
+
+void scalar_update_jacobian(const hedra::optimization::DiscreteShellsTraits& traits, const Eigen::MatrixXd& fullx, Eigen::VectorXd& fullJVals, Eigen::VectorXd& JVals)
+{
+    using namespace Eigen;
+    const MatrixXi& EV=traits.EV;
+    const MatrixXi& flaps=traits.flapVertexIndices;
+    for (int i=0;i<EV.rows();i++){
+        RowVector3d normedEdgeVector=(fullx.row(EV(i,1))-fullx.row(EV(i,0))).normalized();
+        fullJVals.segment(6*i,3)<<-normedEdgeVector.transpose()*traits.Wl(i)*traits.lengthCoeff;
+        fullJVals.segment(6*i+3,3)<<normedEdgeVector.transpose()*traits.Wl(i)*traits.lengthCoeff;
+    }
+
+    for (int i=0;i<flaps.rows();i++){
+        RowVector3d eji=fullx.row(flaps(i,0))-fullx.row(flaps(i,1));
+        RowVector3d ejk=fullx.row(flaps(i,2))-fullx.row(flaps(i,1));
+        RowVector3d eli=fullx.row(flaps(i,0))-fullx.row(flaps(i,3));
+        RowVector3d elk=fullx.row(flaps(i,2))-fullx.row(flaps(i,3));
+        RowVector3d eki=fullx.row(flaps(i,0))-fullx.row(flaps(i,2));
+
+        RowVector3d n1 = (ejk.cross(eji));
+        RowVector3d n2 = (eli.cross(elk));
+        double Wd=traits.Wd(i)*traits.bendCoeff;
+        fullJVals.segment(6*EV.rows()+12*i,3)<<(Wd*((ejk.dot(-eki)/(n1.squaredNorm()*eki.norm()))*n1+(elk.dot(-eki)/(n2.squaredNorm()*eki.norm()))*n2)).transpose();
+        fullJVals.segment(6*EV.rows()+12*i+3,3)<<(Wd*(-eki.norm()/n1.squaredNorm())*n1).transpose();
+        fullJVals.segment(6*EV.rows()+12*i+6,3)<<(Wd*((eji.dot(eki)/(n1.squaredNorm()*eki.norm()))*n1+(eli.dot(eki)/(n2.squaredNorm()*eki.norm()))*n2)).transpose();
+        fullJVals.segment(6*EV.rows()+12*i+9,3)<<(Wd*(-eki.norm()/n2.squaredNorm())*n2).transpose();
+    }
+
+    for (int i=0;i<fullJVals.size();i++)
+        if (traits.full2J(i)!=-1)
+            JVals(traits.full2J(i))=fullJVals(i);
+}
+
+
+int main(int argc, char *argv[])
+{
+    using namespace std;
+    using namespace Eigen;
+    typedef std::chrono::high_resolution_clock Clock;
+
+    string meshName=(argc>1 ? argv[1] : TUTORIAL_SHARED_PATH "/Moomoo.off");
+    int numIterations=(argc>2 ? atoi(argv[2]) : 100);
+
+    MatrixXd V;
+    VectorXi D;
+    MatrixXi F;
+    if (!hedra::polygonal_read_OFF(meshName, V, D, F)){
+        cout<<"Could not read "<<meshName<<endl;
+        return 1;
+    }
+
+    MatrixXi T, EV, FE, ET, ETi;
+    MatrixXd FEs;
+    VectorXi TF, innerEdges;
+    hedra::triangulate_mesh(D, F, T, TF);
+    hedra::polygonal_edge_topology(VectorXi::Constant(T.rows(),3), T, EV, FE, ET, ETi, FEs, innerEdges);
+
+    //the first vertex is a handle, and the rest are perturbed
+    hedra::optimization::DiscreteShellsTraits traits;
+    VectorXi h(1);
+    h<<0;
+    traits.init(V, T, h, EV, ET, ETi, innerEdges);
+    traits.qh=V.row(0);
+    double scale=(V.colwise().maxCoeff()-V.colwise().minCoeff()).norm();
+    VectorXd x(traits.xSize);
+    MatrixXd fullx=V;
+    for (int i=0;i<V.rows();i++){
+        if (traits.a2x(i)==-1)
+            continue;
+        fullx.row(i)+=10e-3*scale*RowVector3d::Random();
+        x.segment(3*traits.a2x(i),3)=fullx.row(i).transpose();
+    }
+    cout<<meshName<<": "<<EV.rows()<<" edges, "<<traits.flapVertexIndices.rows()<<" flaps, "<<traits.JVals.size()<<" Jacobian entries"<<endl;
+
+    VectorXd scalarEVec(traits.EVec.size()), scalarJVals(traits.JVals.size()), fullJVals(traits.fullJRows.size());
+    Clock::time_point start=Clock::now();
+    for (int i=0;i<numIterations;i++){
+        //the conversion of x to the full positions is included, as in the traits
+        for (int v=0;v<V.rows();v++)
+            if (traits.a2x(v)!=-1)
+                fullx.row(v)=x.segment(3*traits.a2x(v),3).transpose();
+        scalar_update_energy(traits, fullx, scalarEVec);
+        scalar_update_jacobian(traits, fullx, fullJVals, scalarJVals);
+    }
+    double scalarTime=std::chrono::duration<double>(Clock::now()-start).count()/numIterations;
+
+    start=Clock::now();
+    for (int i=0;i<numIterations;i++){
+        traits.update_energy(x);
+        traits.update_jacobian(x);
+    }
+    double batchTime=std::chrono::duration<double>(Clock::now()-start).count()/numIterations;
+
+    cout<<"Per iteration, per-element assembly: "<<scalarTime<<"s"<<endl;
+    cout<<"Per iteration, batched assembly:     "<<batchTime<<"s (speedup "<<scalarTime/batchTime<<", batches of "<<(int)hedra::optimization::DiscreteShellsTraits::BatchSize<<")"<<endl;
+    cout<<"Largest difference of energy entries:   "<<(scalarEVec-traits.EVec).lpNorm<Infinity>()<<endl;
+    cout<<"Largest difference of Jacobian entries: "<<(scalarJVals-traits.JVals).lpNorm<Infinity>()<<endl;
+
+    return 0;
+}
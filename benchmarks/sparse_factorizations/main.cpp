@@ -0,0 +1,112 @@
+#include <hedra/polygonal_read_OFF.h>
+#include <hedra/polygonal_edge_topology.h>
+#include <hedra/affine_maps_deform.h>
+#include <hedra/shapeup.h>
+#include <hedra/CholmodSolverWrapper.h>
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <algorithm>
+#include <Eigen/Core>
+#include <Eigen/SVD>
+
+
+//Times the sparse factorizations of CholmodSolverWrapper.h where the library uses them: the LL^T of shapeup (planarization of the faces) and the QR of the KKT system of the affine maps deformation.
+//Built with HEDRA_WITH_CHOLMOD (the LIBHEDRA_WITH_CHOLMOD option), these are CHOLMOD and SuiteSparseQR; otherwise the fallbacks of Eigen. Running both builds on the same mesh compares them.
+
+typedef std::chrono::high_resolution_clock Clock;
+
+//centers the vertices of face (subset) i and returns the normal of their least-squares plane
+Eigen::RowVector3d centered_face(const int i, const Eigen::VectorXi& D, const Eigen::MatrixXi& F, const Eigen::MatrixXd& V, Eigen::MatrixXd& points)
+{
+    using namespace Eigen;
+    points.resize(D(i),3);
+    for (int j=0;j<D(i);j++)
+        points.row(j)=V.row(F(i,j));
+    RowVector3d centroid=points.colwise().mean();
+    points.rowwise()-=centroid;
+    JacobiSVD<MatrixXd> svd(points, ComputeThinV);
+    return svd.matrixV().col(2).transpose();
+}
+
+//projects the vertices of face (subset) i to the least-squares plane through them
+void planarity_projection(int i, const hedra::ShapeupData& sudata, const Eigen::MatrixXd& currV, Eigen::MatrixXd& PV)
+{
+    Eigen::MatrixXd points;
+    Eigen::RowVector3d normal=centered_face(i, sudata.SD, sudata.S, currV, points);
+    for (int j=0;j<sudata.SD(i);j++)
+        PV.block(i,3*j,1,3)=points.row(j)-points.row(j).dot(normal)*normal;
+}
+
+//the largest distance of a vertex from the least-squares plane of its face
+double max_nonplanarity(const Eigen::VectorXi& D, const Eigen::MatrixXi& F, const Eigen::MatrixXd& V)
+{
+    Eigen::MatrixXd points;
+    double maxDistance=0.0;
+    for (int i=0;i<D.rows();i++){
+        Eigen::RowVector3d normal=centered_face(i, D, F, V, points);
+        maxDistance=std::max(maxDistance, (points*normal.transpose()).cwiseAbs().maxCoeff());
+    }
+    return maxDistance;
+}
+
+
+int main(int argc, char *argv[])
+{
+    using namespace std;
+    using namespace Eigen;
+
+    string meshName=(argc>1 ? argv[1] : TUTORIAL_SHARED_PATH "/six.off");
+    int numIterations=(argc>2 ? atoi(argv[2]) : 5);
+
+    MatrixXd V;
+    VectorXi D;
+    MatrixXi F;
+    if (!hedra::polygonal_read_OFF(meshName, V, D, F)){
+        cout<<"Could not read "<<meshName<<endl;
+        return 1;
+    }
+    MatrixXi EV, FE, EF, EFi;
+    MatrixXd FEs;
+    VectorXi innerEdges;
+    hedra::polygonal_edge_topology(D, F, EV, FE, EF, EFi, FEs, innerEdges);
+
+#ifdef HEDRA_WITH_CHOLMOD
+    cout<<meshName<<" with CHOLMOD and SuiteSparseQR"<<endl;
+#else
+    cout<<meshName<<" with the factorizations of Eigen"<<endl;
+#endif
+
+    //the first and the last vertices are the handles; the last is moved by a tenth of the bounding box diagonal
+    VectorXi handles(2);
+    handles<<0, (int)V.rows()-1;
+    MatrixXd handlePoses(2,3);
+    handlePoses<<V.row(0), V.row(V.rows()-1);
+    double diagonal=(V.colwise().maxCoeff()-V.colwise().minCoeff()).norm();
+    handlePoses(1,2)+=0.1*diagonal;
+
+    hedra::AffineData affineData;
+    Clock::time_point start=Clock::now();
+    hedra::affine_maps_precompute(V, D, F, EV, EF, EFi, FE, handles, 3, affineData);
+    double affinePrecomputeTime=std::chrono::duration<double>(Clock::now()-start).count();
+    MatrixXd affineV=V;
+    start=Clock::now();
+    hedra::affine_maps_deform(affineData, handlePoses, numIterations, affineV);
+    double affineDeformTime=std::chrono::duration<double>(Clock::now()-start).count();
+    cout<<"Affine maps (QR): precompute "<<affinePrecomputeTime<<"s, "<<numIterations<<" iterations "<<affineDeformTime<<"s, largest vertex displacement "<<
+    (affineV-V).rowwise().norm().maxCoeff()/diagonal<<" (of the diagonal)"<<endl;
+
+    hedra::ShapeupData shapeupData;
+    start=Clock::now();
+    hedra::shapeup_precompute(V, D, F, D, F, handles, VectorXd::Ones(D.rows()), 1.0, 100.0, shapeupData);
+    double shapeupPrecomputeTime=std::chrono::duration<double>(Clock::now()-start).count();
+    MatrixXd shapeupV=V;
+    start=Clock::now();
+    hedra::shapeup_compute(planarity_projection, handlePoses, shapeupData, shapeupV, numIterations);
+    double shapeupTime=std::chrono::duration<double>(Clock::now()-start).count();
+    cout<<"Shapeup (LL^T): precompute "<<shapeupPrecomputeTime<<"s, "<<numIterations<<" iterations "<<shapeupTime<<"s, factorization "<<
+    (shapeupData.solver.info()==Success ? "succeeded" : "FAILED")<<", largest non-planarity "<<max_nonplanarity(D, F, V)/diagonal<<" -> "<<max_nonplanarity(D, F, shapeupV)/diagonal<<" (of the diagonal)"<<endl;
+
+    return 0;
+}
@@ -0,0 +1,156 @@
+#include <hedra/polygonal_read_OFF.h>
+#include <hedra/polygonal_edge_topology.h>
+#include <hedra/triangulate_mesh.h>
+#include <hedra/DiscreteShellsTraits.h>
+#include <hedra/complex_moebius_deform.h>
+#include <hedra/LMSolver.h>
+#include <hedra/TRSolver.h>
+#include <hedra/EigenSolverWrapper.h>
+#include <hedra/CachedOrdering.h>
+#include <hedra/SolverTelemetry.h>
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <Eigen/Core>
+#include <Eigen/Sparse>
+
+
+//Compares the LMSolver against the TRSolver (dogleg and geodesic LM) on a Moebius (Moebius2DEdgeDeviationTraits) and a discrete shells (DiscreteShellsTraits) deformation of the same mesh, by the final energy, the number of factorizations per accepted step, and the time of each phase.
+//With a third argument, the iterations of every solve are also written as <argument>_<traits>_<solver>.csv
+//The handles are the vertices at both ends of the x axis; one end is fixed, and the other is rotated by 90 degrees around the z axis.
+
+typedef hedra::optimization::EigenSolverWrapper<Eigen::SimplicialLLT<Eigen::SparseMatrix<double>, Eigen::Lower, hedra::optimization::CachedOrdering<Eigen::AMDOrdering<int> > > > LinearSolver;
+typedef std::chrono::high_resolution_clock Clock;
+
+void print_statistics(const std::string& name, const double energy, const int numFactorizations, const int numAcceptedSteps, const int numRejectedSteps, const double time,
+                      const hedra::optimization::SolverTelemetry& telemetry, const std::string& csvName)
+{
+    using namespace hedra::optimization;
+    std::cout<<name<<": energy "<<energy<<", factorizations "<<numFactorizations<<", accepted steps "<<numAcceptedSteps<<", rejected steps "<<numRejectedSteps<<
+    ", factorizations per accepted step "<<(numAcceptedSteps>0 ? (double)numFactorizations/(double)numAcceptedSteps : (double)numFactorizations)<<", time "<<time<<"s"<<std::endl;
+    std::cout<<"            ";
+    for (int p=0;p<NUM_SOLVER_PHASES;p++)
+        std::cout<<(p==0 ? "" : ", ")<<SolverTelemetry::phase_name(SolverPhase(p))<<" "<<telemetry.total_time(SolverPhase(p))<<"s";
+    std::cout<<std::endl;
+    if (!csvName.empty()&&!telemetry.write_CSV(csvName))
+        std::cout<<"Could not write "<<csvName<<std::endl;
+}
+
+//runs the LMSolver and both TRSolver methods; reset() restores the traits to the state before the solve
+template<class SolverTraits, class ResetFunction>
+void compare_solvers(SolverTraits& traits, ResetFunction reset, const int maxIterations, const std::string& csvPrefix)
+{
+    using namespace hedra::optimization;
+    {
+        reset();
+        LinearSolver linearSolver;
+        SolverTelemetry telemetry;
+        LMSolver<LinearSolver, SolverTraits> solver;
+        solver.init(&linearSolver, &traits, maxIterations);
+        solver.telemetry=&telemetry;
+        Clock::time_point start=Clock::now();
+        solver.solve(false);
+        double time=std::chrono::duration<double>(Clock::now()-start).count();
+        traits.update_energy(solver.x);
+        print_statistics("LM         ", traits.EVec.squaredNorm(), solver.numFactorizations, solver.numAcceptedSteps, solver.numRejectedSteps, time,
+                         telemetry, csvPrefix.empty() ? csvPrefix : csvPrefix+"_LM.csv");
+    }
+
+    const TRMethod methods[2]={DOGLEG, GEODESIC_LM};
+    const std::string names[2]={"Dogleg     ", "Geodesic LM"};
+    const std::string fileNames[2]={"_dogleg.csv", "_geodesic_LM.csv"};
+    for (int m=0;m<2;m++){
+        reset();
+        LinearSolver linearSolver;
+        SolverTelemetry telemetry;
+        TRSolver<LinearSolver, SolverTraits> solver;
+        solver.init(&linearSolver, &traits, maxIterations, 10e-9, 10e-9, methods[m]);
+        solver.telemetry=&telemetry;
+        Clock::time_point start=Clock::now();
+        solver.solve(false);
+        double time=std::chrono::duration<double>(Clock::now()-start).count();
+        traits.update_energy(solver.x);
+        print_statistics(names[m], traits.EVec.squaredNorm(), solver.numFactorizations, solver.numAcceptedSteps, solver.numRejectedSteps, time,
+                         telemetry, csvPrefix.empty() ? csvPrefix : csvPrefix+fileNames[m]);
+    }
+}
+
+
+int main(int argc, char *argv[])
+{
+    using namespace std;
+    using namespace Eigen;
+
+    string meshName=(argc>1 ? argv[1] : TUTORIAL_SHARED_PATH "/bar2d.off");
+    int maxIterations=(argc>2 ? atoi(argv[2]) : 100);
+    string csvPrefix=(argc>3 ? argv[3] : "");
+
+    MatrixXd V;
+    VectorXi D;
+    MatrixXi F;
+    if (!hedra::polygonal_read_OFF(meshName, V, D, F)){
+        cout<<"Could not read "<<meshName<<endl;
+        return 1;
+    }
+
+    //handles at both ends of the x axis
+    double minX=V.col(0).minCoeff(), maxX=V.col(0).maxCoeff();
+    double tolerance=10e-3*(maxX-minX);
+    vector<int> handleList;
+    for (int i=0;i<V.rows();i++)
+        if ((V(i,0)<minX+tolerance)||(V(i,0)>maxX-tolerance))
+            handleList.push_back(i);
+    VectorXi h(handleList.size());
+    MatrixXd qh(handleList.size(),3);
+    for (int i=0;i<h.size();i++){
+        h(i)=handleList[i];
+        qh.row(i)=V.row(h(i));
+        if (V(h(i),0)>maxX-tolerance)
+            qh.row(i)<<maxX-(V(h(i),1)-V.col(1).mean()), maxX-minX+V(h(i),1)-V.col(1).mean(), V(h(i),2);
+    }
+    cout<<meshName<<": "<<V.rows()<<" vertices, "<<F.rows()<<" faces, "<<h.size()<<" handles"<<endl;
+
+    //Moebius deformation
+    {
+        MatrixXi EV, FE, EF, EFi, T, TF;
+        MatrixXd FEs;
+        VectorXi innerEdges, TFi;
+        hedra::polygonal_edge_topology(D, F, EV, FE, EF, EFi, FEs, innerEdges);
+        hedra::triangulate_mesh(D, F, T, TFi);
+        TF=TFi;
+        hedra::ComplexMoebiusData mdata;
+        hedra::complex_moebius_setup(V, D, F, TF, EV, EF, EFi, FE, FEs, innerEdges, mdata);
+        hedra::complex_moebius_precompute(h, false, false, 0.1, mdata);
+        Coords2Complex(qh, mdata.complexConstPoses);
+
+        cout<<"Moebius2DEdgeDeviationTraits:"<<endl;
+        hedra::optimization::Moebius2DEdgeDeviationTraits& traits=mdata.deformTraits;
+        compare_solvers(traits, [&](){
+            traits.init(mdata.origVc, mdata.D, mdata.F, mdata.extEV, false, false, h, 0.1);
+            traits.complexConstPoses=mdata.complexConstPoses;
+            traits.currPositions=mdata.origVc;
+            traits.currY=VectorXcd::Ones(mdata.origVc.rows());
+            traits.currE=VectorXcd::Ones(mdata.extEV.rows());
+        }, maxIterations, csvPrefix.empty() ? csvPrefix : csvPrefix+"_moebius");
+    }
+
+    //discrete shells deformation of the triangulated mesh
+    {
+        MatrixXi T, EV, FE, ET, ETi;
+        MatrixXd FEs;
+        VectorXi TF, innerEdges;
+        hedra::triangulate_mesh(D, F, T, TF);
+        hedra::polygonal_edge_topology(VectorXi::Constant(T.rows(),3), T, EV, FE, ET, ETi, FEs, innerEdges);
+
+        cout<<"DiscreteShellsTraits:"<<endl;
+        hedra::optimization::DiscreteShellsTraits traits;
+        compare_solvers(traits, [&](){
+            traits.init(V, T, h, EV, ET, ETi, innerEdges);
+            traits.qh=qh;
+        }, maxIterations, csvPrefix.empty() ? csvPrefix : csvPrefix+"_shells");
+    }
+
+    return 0;
+}
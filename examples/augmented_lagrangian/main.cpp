@@ -124,9 +124,10 @@ int main(int argc, char *argv[])
     //solving for offset 1.0
     double d=100.0;
     osTraits.init(VOrig, D, F,  EV,hedra::optimization::OffsetMeshTraits::FACE_OFFSET, d);
+    slTraits.verbose=true;
     slTraits.init(&osTraits, 5);
     lmSolver.init(&lSolver, &slTraits, 100);
-    //hedra::optimization::check_traits(slTraits, slTraits.xSize);
+    //hedra::optimization::check_traits(slTraits);
     //exit(0);
     lmSolver.solve(true);
     
@@ -13,7 +13,9 @@
 #include <string>
 #include <vector>
 #include <cstdio>
+#include <iostream>
 #include <set>
+#include <cmath>
 
 
 namespace hedra { namespace optimization {
@@ -40,21 +42,40 @@ namespace hedra { namespace optimization {
             int currBigIteration;            //current big iteration
             
             double prevError;
-            double currError;
+            double currError;               //max(constraint) at the end of the last big iteration
             
-            void init(ConstraintTraits* _CT, int _maxBigIterations=10, double constTolerance=10e-6){
+            double initMiu;                 //miu of a cold start
+            
+            //By default, the multipliers are updated after every big iteration, and miu is multiplied by 1.5-reduceRate (clamped to [0.5,1]), where reduceRate is the ratio of the constraint errors of the last two big iterations.
+            //With useCGTSchedule, the penalty schedule of [Conn, Gould and Toint 1991] (LANCELOT) is used instead: if the constraint error is below constraintTarget, the multipliers are updated and the target is tightened to constraintTarget*miu^targetTightening; otherwise the multipliers are kept, the penalty is strengthened to miu*miuDecrease, and the target is loosened to targetScale*miu^targetLoosening.
+            bool useCGTSchedule;
+            double miuDecrease;
+            double targetScale;
+            double targetTightening;
+            double targetLoosening;
+            double constraintTarget;
+            
+            //Warm start for a series of similar problems (e.g., an interactive deformation): initial_solution() then keeps lambda and miu, and starts from the last solution instead of that of the ConstraintTraits (whose initial_solution() is still called, for its own state). The first solve, and any solve after the number of variables or of constraints changed, start cold.
+            bool warmStart;
+            Eigen::VectorXd lastSolution;   //the solution of the last big iteration
+            
+            bool verbose;                   //printing the constraint error, the size of the multipliers and the penalty of each big iteration
+            
+            void init(ConstraintTraits* _CT, int _maxBigIterations=10, double _constTolerance=10e-6){
                 
                 CT=_CT;
                 xSize=CT->xSize;
                 maxBigIterations=_maxBigIterations;
+                constTolerance=_constTolerance;
                 lambda.resize(CT->CVec.size());
                 EVec.resize(CT->EVec.size()+CT->CVec.size());
                 JRows.resize(CT->JERows.size()+CT->JCRows.size());
                 JCols.resize(CT->JECols.size()+CT->JCCols.size());
                 JVals.resize(CT->JEVals.size()+CT->JCVals.size());
                 
-                miu=0.1;  //TODO: something more sophisticated
+                miu=initMiu;
                 lambda.setOnes();
+                lastSolution.resize(0);
                 if (CT->JCRows.size()!=0){
                     JRows<<CT->JERows, CT->JCRows.array()+CT->EVec.size();
                     JCols<<CT->JECols, CT->JCCols;
@@ -63,17 +84,25 @@ namespace hedra { namespace optimization {
                     JCols<<CT->JECols;
                 }
                 
-                std::cout<<"Augmented EVec size: "<<EVec.size()<<std::endl;
+                if (verbose)
+                    std::cout<<"Augmented EVec size: "<<EVec.size()<<std::endl;
             }
             
             void initial_solution(Eigen::VectorXd& x0){
                 CT->initial_solution(x0);
                 currBigIteration=0;
+                bool isWarm=(warmStart)&&(lastSolution.size()==x0.size())&&(lambda.size()==CT->CVec.size());
+                if (isWarm)
+                    x0=lastSolution;
                 CT->update_constraints(x0);
-                miu=0.1;
-                lambda=-CT->CVec/miu;
-                std::cout<<"initial lambda: "<<lambda<<std::endl;
+                if (!isWarm){
+                    miu=initMiu;
+                    lambda=-CT->CVec/miu;
+                }
+                constraintTarget=targetScale*pow(miu, targetLoosening);
                 prevError=currError=CT->CVec.template lpNorm<Eigen::Infinity>();
+                if (verbose)
+                    std::cout<<(isWarm ? "warm start" : "cold start")<<", initial constraint error: "<<currError<<", max(lambda): "<<lambda.template lpNorm<Eigen::Infinity>()<<", miu: "<<miu<<std::endl;
    
             }
             
@@ -110,37 +139,47 @@ namespace hedra { namespace optimization {
             bool post_optimization(const Eigen::VectorXd& x){
                 //updating the lagrangian function
                 currBigIteration++;
+                lastSolution=x;
                 
                 CT->update_constraints(x);
-                //miu*=0.9;
-                lambda=lambda-CT->CVec/miu;
-                std::cout<<"change of lambda: "<<lambda<<std::endl;
-                //std::cout<<"lambda: "<<lambda<<std::endl;
-                std::cout<<"Final Energy: "<<CT->EVec.template squaredNorm()<<std::endl<<std::endl<<std::endl;
-                std::cout<<"Constraint Error: "<<CT->CVec.template lpNorm<Eigen::Infinity>()<<std::endl<<std::endl<<std::endl;
+                currError=CT->CVec.template lpNorm<Eigen::Infinity>();
+                if (!useCGTSchedule)
+                    lambda=lambda-CT->CVec/miu;
+                else if (currError<=constraintTarget){
+                    lambda=lambda-CT->CVec/miu;
+                    constraintTarget*=pow(miu, targetTightening);
+                } else {
+                    miu*=miuDecrease;
+                    constraintTarget=targetScale*pow(miu, targetLoosening);
+                }
+                if (verbose){
+                    std::cout<<"Big iteration "<<currBigIteration<<": Final Energy: "<<CT->EVec.template squaredNorm()<<", Constraint Error: "<<currError<<std::endl;
+                    std::cout<<"max(lambda): "<<lambda.template lpNorm<Eigen::Infinity>()<<", miu: "<<miu;
+                    if (useCGTSchedule)
+                        std::cout<<", constraint target: "<<constraintTarget;
+                    std::cout<<std::endl;
+                }
                 
                 bool isCTStop=CT->post_optimization(x);
-                if ((CT->CVec.template lpNorm<Eigen::Infinity>()<constTolerance)||(currBigIteration>=maxBigIterations))
+                if ((currError<constTolerance)||(currBigIteration>=maxBigIterations))
                     return isCTStop;  //Only stopping if the ConstraintTraits wants to stop
-                else{
+                
+                if (!useCGTSchedule){
                     //updating miu
-                    currError=CT->CVec.template lpNorm<Eigen::Infinity>();
                     double reduceRate=currError/prevError;
-                    std::cout<<"reduceRate: "<<reduceRate<<std::endl;
+                    if (verbose)
+                        std::cout<<"reduceRate: "<<reduceRate<<std::endl;
                     double miuMult=1.5-reduceRate;
                     miuMult=(miuMult > 1.0 ? 1.0 : miuMult);
                     miuMult=(miuMult < 0.5 ? 0.5 : miuMult);
                     miu*=miuMult;
-                    std::cout<<"miu: "<<miu<<std::endl;
                     prevError=currError;
-                    return false;  ///do another optimization process, since we have not reached the constraints
                 }
+                return false;  ///do another optimization process, since we have not reached the constraints
                 
-                
-
             }
             
-            AugmentedLagrangianTraits(){}
+            AugmentedLagrangianTraits():initMiu(0.1), useCGTSchedule(false), miuDecrease(0.1), targetScale(0.1258925), targetTightening(0.9), targetLoosening(0.1), warmStart(false), verbose(false){}
             ~AugmentedLagrangianTraits(){}
         };
         
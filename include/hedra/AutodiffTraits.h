@@ -0,0 +1,109 @@
+// This file is part of libhedra, a library for polyhedral mesh processing
+//
+// Copyright (C) 2016 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+#ifndef HEDRA_AUTODIFF_TRAITS_H
+#define HEDRA_AUTODIFF_TRAITS_H
+#include <igl/igl_inline.h>
+#include <Eigen/Core>
+#include <hedra/Dual.h>
+
+namespace hedra { namespace optimization {
+
+    //A base class for traits whose energy is a sum of element residuals, with the Jacobian computed by forward-mode automatic differentiation (see Dual.h) instead of by hand.
+    //Every element depends on NumVariables entries of the solution and has NumResiduals residuals, which are rows element*NumResiduals+r of EVec. The Derived class (using CRTP, as "class MyTraits: public AutodiffTraits<MyTraits, 6, 1>") provides:
+    //  template<typename Scalar> void element_residuals(const int element, const Scalar* variables, Scalar* residuals) const;
+    //templated on the scalar, which is double in update_energy() and Dual<NumVariables> in update_jacobian(). Its init() calls init_elements() with the variables of every element, and it implements initial_solution(); pre_iteration(), post_iteration() and post_optimization() have defaults here, which the Derived class can hide.
+    //A variable of -1 is a constant (e.g., of a handle), whose value is given by the Derived class in constant_variable(element, k), and which has no Jacobian entries. The other variables of an element must be distinct.
+    //Every dual operation costs NumVariables derivative operations, so the overhead over a hand-written Jacobian grows with the variables per element: the 6-variable edge springs of benchmarks/autodiff are as fast as by hand, but its 12-variable flap dihedrals take about 7.5-8x the time of DiscreteShellsTraits (5-5.5x with -march=native). Hot traits with many variables per element are better written by hand.
+    template<class Derived, int NumVariables, int NumResiduals=1>
+    class AutodiffTraits{
+    public:
+        //concept requirements
+        Eigen::VectorXi JRows, JCols;  //rows and column indices for the jacobian matrix
+        Eigen::VectorXd JVals;         //values for the jacobian matrix.
+        int xSize;                  //size of the solution
+        Eigen::VectorXd EVec;          //energy vector
+
+        typedef Dual<NumVariables> DualScalar;
+
+        Eigen::MatrixXi elementVariables;   //#elements by NumVariables indices into the solution (-1 for constants)
+        Eigen::VectorXi elementJStart;      //the first Jacobian entry of every element, which has NumResiduals rows of its free variables in order
+
+        //the pattern, from the variables of every element
+        void init_elements(const Eigen::MatrixXi& _elementVariables, const int _xSize){
+            elementVariables=_elementVariables;
+            xSize=_xSize;
+            EVec.resize(NumResiduals*elementVariables.rows());
+
+            elementJStart.resize(elementVariables.rows()+1);
+            elementJStart(0)=0;
+            for (int e=0;e<elementVariables.rows();e++){
+                int numFree=0;
+                for (int k=0;k<NumVariables;k++)
+                    numFree+=(elementVariables(e,k)!=-1 ? 1 : 0);
+                elementJStart(e+1)=elementJStart(e)+NumResiduals*numFree;
+            }
+
+            JRows.resize(elementJStart(elementVariables.rows()));
+            JCols.resize(JRows.size());
+            JVals.resize(JRows.size());
+            for (int e=0;e<elementVariables.rows();e++){
+                int currEntry=elementJStart(e);
+                for (int r=0;r<NumResiduals;r++){
+                    for (int k=0;k<NumVariables;k++){
+                        if (elementVariables(e,k)==-1)
+                            continue;
+                        JRows(currEntry)=NumResiduals*e+r;
+                        JCols(currEntry++)=elementVariables(e,k);
+                    }
+                }
+            }
+        }
+
+        //the value of constant variable k of an element; Derived classes with constants hide this
+        double constant_variable(const int element, const int k) const{return 0.0;}
+
+        void update_energy(const Eigen::VectorXd& x){
+            double variables[NumVariables];
+            double residuals[NumResiduals];
+            for (int e=0;e<elementVariables.rows();e++){
+                for (int k=0;k<NumVariables;k++)
+                    variables[k]=(elementVariables(e,k)!=-1 ? x(elementVariables(e,k)) : derived().constant_variable(e,k));
+                derived().element_residuals(e, variables, residuals);
+                for (int r=0;r<NumResiduals;r++)
+                    EVec(NumResiduals*e+r)=residuals[r];
+            }
+        }
+
+        void update_jacobian(const Eigen::VectorXd& x){
+            DualScalar variables[NumVariables];
+            DualScalar residuals[NumResiduals];
+            for (int e=0;e<elementVariables.rows();e++){
+                for (int k=0;k<NumVariables;k++)
+                    variables[k]=(elementVariables(e,k)!=-1 ? DualScalar::variable(x(elementVariables(e,k)), k) : DualScalar(derived().constant_variable(e,k)));
+                derived().element_residuals(e, variables, residuals);
+                int currEntry=elementJStart(e);
+                for (int r=0;r<NumResiduals;r++)
+                    for (int k=0;k<NumVariables;k++)
+                        if (elementVariables(e,k)!=-1)
+                            JVals(currEntry++)=residuals[r].v(k);
+            }
+        }
+
+        void pre_iteration(const Eigen::VectorXd& prevx){}
+        bool post_iteration(const Eigen::VectorXd& x){return false;}
+        bool post_optimization(const Eigen::VectorXd& x){return true;}
+
+    protected:
+        Derived& derived(){return static_cast<Derived&>(*this);}
+        const Derived& derived() const{return static_cast<const Derived&>(*this);}
+    };
+
+} }
+
+
+#endif
@@ -0,0 +1,190 @@
+// This file is part of libhedra, a library for polyhedral mesh processing
+//
+// Copyright (C) 2016 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+#ifndef HEDRA_BATCH_SOLVER_H
+#define HEDRA_BATCH_SOLVER_H
+#include <igl/igl_inline.h>
+#include <Eigen/Core>
+#include <hedra/LMSolver.h>
+#include <hedra/SolverTelemetry.h>
+#include <hedra/parallel_for.h>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+
+namespace hedra {
+    namespace optimization
+    {
+        //the outcome of one instance of BatchSolver::solve()
+        struct BatchSolveResult{
+            bool isSolved;                  //LMSolver::solve() returned true (no factorization failed)
+            bool isConverged;               //isSolved, and the last optimization stopped by a criterion of LMSolver or of the traits rather than by maxIterations (see LMStopReason in LMSolver.h)
+            int numIterations;              //trial steps over all big iterations
+            int numFactorizations;
+            int numAcceptedSteps;
+            int numRejectedSteps;
+            double initialEnergy;           //|EVec|^2 at the initial solution
+            double finalEnergy;             //|EVec|^2 at x
+            double firstOrderOptimality;    //|J^T*EVec|_inf at x
+            double time;                    //of the whole instance, in seconds
+            int threadIndex;                //the thread that solved it
+            Eigen::VectorXd x;              //the final solution
+        };
+
+        //Solves many independent instances of the same SolverTraits type (e.g., an OffsetMeshTraits per panel cluster) with LMSolver, in parallel.
+        //Every instance is solved serially in one thread, and the instances are scheduled by work stealing (see parallel_for_stealing() in parallel_for.h), so that large and small instances balance over all cores.
+        //Instances with the same Jacobian pattern (JRows, JCols and xSize) share their symbolic analysis: the pattern of J^T*J and the gather patterns are computed once per pattern, and consecutive instances of a pattern in a thread reuse the symbolic factorization of the linear solver (see EigenSolverWrapper.h); with a CachedOrdering, the fill-reducing ordering is also shared between the threads.
+        //The traits instances must not share mutable state with each other, as they run concurrently.
+        template<class LinearSolver, class SolverTraits>
+        class BatchSolver{
+        public:
+            int maxIterations;
+            double xTolerance;
+            double fooTolerance;
+            int numThreads;
+
+            //statistics of the last solve()
+            int numPatterns;                //distinct Jacobian patterns among the instances
+            double time;                    //wall time, in seconds
+
+            BatchSolver():maxIterations(100), xTolerance(10e-9), fooTolerance(10e-9), numThreads(1), numPatterns(0), time(0.0){}
+
+            void init(int _maxIterations=100,
+                      double _xTolerance=10e-9,
+                      double _fooTolerance=10e-9,
+                      int _numThreads=1){
+                maxIterations=_maxIterations;
+                xTolerance=_xTolerance;
+                fooTolerance=_fooTolerance;
+                numThreads=_numThreads;
+            }
+
+            //Input: the initialized traits of every instance
+            //Output: a result per instance, in the same order
+            //returns whether all instances were solved
+            bool solve(const std::vector<SolverTraits*>& traits,
+                       std::vector<BatchSolveResult>& results){
+
+                using namespace std;
+                typedef std::chrono::steady_clock Clock;
+                Clock::time_point start=Clock::now();
+                const int numInstances=traits.size();
+                results.resize(numInstances);
+
+                //grouping the instances by pattern
+                vector<int> patternIndex(numInstances);
+                vector<int> patternPrototype;   //the first instance of every pattern
+                unordered_map<uint64_t, vector<int> > patternsOfKey;
+                for (int i=0;i<numInstances;i++){
+                    uint64_t key=pattern_key(*traits[i]);
+                    vector<int>& candidates=patternsOfKey[key];
+                    patternIndex[i]=-1;
+                    for (size_t c=0;c<candidates.size();c++){
+                        if (is_same_pattern(*traits[i], *traits[patternPrototype[candidates[c]]])){
+                            patternIndex[i]=candidates[c];
+                            break;
+                        }
+                    }
+                    if (patternIndex[i]<0){
+                        patternIndex[i]=patternPrototype.size();
+                        candidates.push_back(patternPrototype.size());
+                        patternPrototype.push_back(i);
+                    }
+                }
+                numPatterns=patternPrototype.size();
+
+                //the instances of a pattern are consecutive in the schedule, and the patterns with the largest Jacobians come first, so that the long instances do not end up last
+                vector<int> order(numInstances);
+                for (int i=0;i<numInstances;i++)
+                    order[i]=i;
+                std::stable_sort(order.begin(), order.end(), [&](const int a, const int b){
+                    int sizeA=traits[patternPrototype[patternIndex[a]]]->JVals.size();
+                    int sizeB=traits[patternPrototype[patternIndex[b]]]->JVals.size();
+                    if (sizeA!=sizeB)
+                        return (sizeA>sizeB);
+                    return (patternIndex[a]<patternIndex[b]);
+                });
+
+                //a solver and a linear solver per thread; the solvers of the prototypes keep the shared patterns
+                int numWorkers=std::max(1, std::min(numThreads, numInstances));
+                vector<LinearSolver> linearSolvers(numWorkers);
+                vector<LMSolver<LinearSolver, SolverTraits> > solvers(numWorkers);
+                vector<LMSolver<LinearSolver, SolverTraits> > patternSolvers(numPatterns);
+                vector<std::once_flag> patternFlags(numPatterns);
+
+                parallel_for_stealing(numInstances, [&](const int orderIndex, const int threadIndex){
+                    Clock::time_point instanceStart=Clock::now();
+                    const int i=order[orderIndex];
+                    const int p=patternIndex[i];
+                    LMSolver<LinearSolver, SolverTraits>& solver=solvers[threadIndex];
+                    solver.numThreads=1;
+                    bool isInitialized=false;
+                    std::call_once(patternFlags[p], [&](){
+                        solver.init(&linearSolvers[threadIndex], traits[i], maxIterations, xTolerance, fooTolerance);
+                        patternSolvers[p]=solver;
+                        isInitialized=true;
+                    });
+                    if (!isInitialized)
+                        solver.init(&linearSolvers[threadIndex], traits[i], maxIterations, xTolerance, fooTolerance, &patternSolvers[p]);
+
+                    SolverTelemetry telemetry;
+                    solver.telemetry=&telemetry;
+                    BatchSolveResult& result=results[i];
+                    result.isSolved=solver.solve(false);
+                    solver.telemetry=NULL;
+
+                    //the energy and the optimality at the final solution
+                    SolverTraits* ST=traits[i];
+                    ST->update_energy(solver.x);
+                    ST->update_jacobian(solver.x);
+                    Eigen::VectorXd rhs(ST->xSize);
+                    solver.MultiplyAdjointVector(ST->EVec, rhs);
+                    result.finalEnergy=ST->EVec.squaredNorm();
+                    result.firstOrderOptimality=rhs.template lpNorm<Eigen::Infinity>();
+                    result.initialEnergy=(telemetry.iterations.empty() ? result.finalEnergy : telemetry.iterations.front().energy);
+                    result.numIterations=telemetry.iterations.size();
+                    result.isConverged=result.isSolved&&(solver.stopReason!=MAX_ITERATIONS);
+                    result.numFactorizations=solver.numFactorizations;
+                    result.numAcceptedSteps=solver.numAcceptedSteps;
+                    result.numRejectedSteps=solver.numRejectedSteps;
+                    result.threadIndex=threadIndex;
+                    result.x=solver.x;
+                    result.time=std::chrono::duration<double>(Clock::now()-instanceStart).count();
+                }, numWorkers);
+
+                time=std::chrono::duration<double>(Clock::now()-start).count();
+                for (int i=0;i<numInstances;i++)
+                    if (!results[i].isSolved)
+                        return false;
+                return true;
+            }
+
+        private:
+            //64-bit FNV-1a of xSize, JRows and JCols
+            static uint64_t pattern_key(const SolverTraits& ST){
+                uint64_t key=14695981039346656037ULL;
+                key=(key^(uint64_t)ST.xSize)*1099511628211ULL;
+                for (int i=0;i<ST.JRows.size();i++){
+                    key=(key^(uint64_t)ST.JRows(i))*1099511628211ULL;
+                    key=(key^(uint64_t)ST.JCols(i))*1099511628211ULL;
+                }
+                return key;
+            }
+
+            static bool is_same_pattern(const SolverTraits& ST1, const SolverTraits& ST2){
+                return ((ST1.xSize==ST2.xSize)&&(ST1.EVec.size()==ST2.EVec.size())&&(ST1.JRows.size()==ST2.JRows.size())&&(ST1.JCols.size()==ST2.JCols.size())&&
+                        (ST1.JRows==ST2.JRows)&&(ST1.JCols==ST2.JCols));
+            }
+        };
+    }
+}
+
+
+#endif
@@ -0,0 +1,124 @@
+// This file is part of libhedra, a library for polyhedral mesh processing
+//
+// Copyright (C) 2016 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+#ifndef HEDRA_CACHED_ORDERING_H
+#define HEDRA_CACHED_ORDERING_H
+#include <igl/igl_inline.h>
+#include <Eigen/Core>
+#include <Eigen/Sparse>
+#include <Eigen/OrderingMethods>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+
+
+namespace hedra {
+    namespace optimization
+    {
+        //A fill-reducing ordering functor for Eigen's sparse solvers (e.g. SimplicialLLT<SparseMatrix<double>, Lower, CachedOrdering<AMDOrdering<int> > > or SparseQR<SparseMatrix<double>, CachedOrdering<COLAMDOrdering<int> > >) that caches the orderings computed by BaseOrdering, keyed by a hash of the sparsity pattern.
+        //Repeated analyzePattern() calls on the same pattern, from any solver instance and thread, reuse the ordering and skip AMD/COLAMD entirely. The rest of the symbolic analysis (elimination tree and column counts) is linear in the nonzeros and is still done by the solver.
+        //The stored patterns are compared entry by entry on a hash hit, so collisions never return a wrong ordering.
+        template<class BaseOrdering>
+        class CachedOrdering{
+        public:
+            typedef typename BaseOrdering::PermutationType PermutationType;
+            typedef typename PermutationType::StorageIndex StorageIndex;
+            typedef Eigen::Matrix<StorageIndex, Eigen::Dynamic, 1> IndicesType;
+
+            struct CacheEntry{
+                std::vector<StorageIndex> pattern;  //rows, cols, column sizes, and row indices
+                IndicesType indices;                //of the permutation
+            };
+
+            struct CacheData{
+                std::unordered_map<std::uint64_t, std::vector<CacheEntry> > entries;
+                int numEntries;
+                int maxEntries;    //the cache is emptied when it grows beyond this
+                long long hits;
+                long long misses;
+                std::mutex lock;
+                CacheData():numEntries(0), maxEntries(64), hits(0), misses(0){}
+            };
+
+            static CacheData& cache(){
+                static CacheData data;
+                return data;
+            }
+
+            static long long num_hits(){std::lock_guard<std::mutex> guard(cache().lock); return cache().hits;}
+            static long long num_misses(){std::lock_guard<std::mutex> guard(cache().lock); return cache().misses;}
+            static void set_max_entries(const int maxEntries){std::lock_guard<std::mutex> guard(cache().lock); cache().maxEntries=maxEntries;}
+
+            static void clear(){
+                std::lock_guard<std::mutex> guard(cache().lock);
+                cache().entries.clear();
+                cache().numEntries=0;
+                cache().hits=cache().misses=0;
+            }
+
+            template <typename MatrixType>
+            void operator()(const MatrixType& mat, PermutationType& perm)
+            {
+                std::vector<StorageIndex> pattern;
+                pattern.reserve(2+mat.outerSize()+mat.nonZeros());
+                pattern.push_back((StorageIndex)mat.rows());
+                pattern.push_back((StorageIndex)mat.cols());
+                for (int k=0;k<mat.outerSize();k++){
+                    StorageIndex outerSize=0;
+                    for (typename MatrixType::InnerIterator it(mat,k); it; ++it)
+                        outerSize++;
+                    pattern.push_back(outerSize);
+                }
+                for (int k=0;k<mat.outerSize();k++)
+                    for (typename MatrixType::InnerIterator it(mat,k); it; ++it)
+                        pattern.push_back((StorageIndex)it.index());
+
+                //64-bit FNV-1a
+                std::uint64_t key=14695981039346656037ULL;
+                for (size_t i=0;i<pattern.size();i++){
+                    key^=(std::uint64_t)pattern[i];
+                    key*=1099511628211ULL;
+                }
+
+                CacheData& data=cache();
+                {
+                    std::lock_guard<std::mutex> guard(data.lock);
+                    typename std::unordered_map<std::uint64_t, std::vector<CacheEntry> >::const_iterator iter=data.entries.find(key);
+                    if (iter!=data.entries.end()){
+                        for (size_t i=0;i<iter->second.size();i++){
+                            if (iter->second[i].pattern==pattern){
+                                perm.indices()=iter->second[i].indices;
+                                data.hits++;
+                                return;
+                            }
+                        }
+                    }
+                    data.misses++;
+                }
+
+                //computing outside the lock, so other patterns are not held up
+                BaseOrdering ordering;
+                ordering(mat, perm);
+
+                std::lock_guard<std::mutex> guard(data.lock);
+                if (data.numEntries>=data.maxEntries){
+                    data.entries.clear();
+                    data.numEntries=0;
+                }
+                CacheEntry entry;
+                entry.pattern.swap(pattern);
+                entry.indices=perm.indices();
+                data.entries[key].push_back(entry);
+                data.numEntries++;
+            }
+        };
+    }
+}
+
+
+#endif
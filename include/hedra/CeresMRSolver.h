@@ -11,6 +11,10 @@
 
 #include "ceres/ceres.h"
 #include "glog/logging.h"
+#include <hedra/CeresSolveConfig.h>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <iostream>
 
 using ceres::AutoDiffCostFunction;
 using ceres::CostFunction;
@@ -141,11 +145,182 @@ public:
 };
 
 
+//Analytic versions of the cost functions above, which CeresMRSolver uses unless HEDRA_CERES_MR_AUTODIFF is defined (e.g., to validate them against the autodiff versions).
+//All ratios are of differences of positions, which are pure quaternions (vectors), for which a*b^{-1}=(a.b, b x a)/|b|^2. The residual and its Jacobians share these ratios and the matrices of their products.
+
+//the matrices of left and right quaternion multiplication: p*q=QLeftMatrix(p)*q=QRightMatrix(q)*p
+inline Eigen::Matrix4d QLeftMatrix(const Eigen::Vector4d& p)
+{
+  Eigen::Matrix4d L;
+  L<<p(0), -p(1), -p(2), -p(3),
+     p(1),  p(0), -p(3),  p(2),
+     p(2),  p(3),  p(0), -p(1),
+     p(3), -p(2),  p(1),  p(0);
+  return L;
+}
+
+inline Eigen::Matrix4d QRightMatrix(const Eigen::Vector4d& q)
+{
+  Eigen::Matrix4d R;
+  R<<q(0), -q(1), -q(2), -q(3),
+     q(1),  q(0),  q(3), -q(2),
+     q(2), -q(3),  q(0),  q(1),
+     q(3),  q(2), -q(1),  q(0);
+  return R;
+}
+
+//the ratio P=a*b^{-1} of the vectors a and b, and its derivatives by them
+inline void QVectorRatio(const Eigen::Vector3d& a,
+                         const Eigen::Vector3d& b,
+                         Eigen::Vector4d& P,
+                         Eigen::Matrix<double, 4, 3>& dPda,
+                         Eigen::Matrix<double, 4, 3>& dPdb)
+{
+  double invb2=1.0/b.squaredNorm();
+  P<<a.dot(b)*invb2, b.cross(a)*invb2;
+  //b x da and db x a
+  dPda<<b(0),  b(1),  b(2),
+        0.0,  -b(2),  b(1),
+        b(2),  0.0,  -b(0),
+       -b(1),  b(0),  0.0;
+  dPdb<<a(0),  a(1),  a(2),
+        0.0,   a(2), -a(1),
+       -a(2),  0.0,   a(0),
+        a(1), -a(0),  0.0;
+  dPda*=invb2;
+  dPdb=dPdb*invb2-(2.0*invb2)*P*b.transpose();
+}
+
+//the Jacobians are row-major, and those of constant parameter blocks are NULL
+typedef Eigen::Map<Eigen::Matrix<double, 4, 3, Eigen::RowMajor> > CeresJacobianMap;
+
+class FullCRAnalyticError: public ceres::SizedCostFunction<4, 3, 3, 3, 3, 3>{
+public:
+  FullCRAnalyticError(double* _pLength, double* _pAngle, double* _factor):pLength(_pLength), pAngle(_pAngle), factor(_factor){}
+  virtual ~FullCRAnalyticError(){};
+  
+  virtual bool Evaluate(double const* const* parameters,
+                        double* residuals,
+                        double** jacobians) const {
+    
+    Eigen::Map<const Eigen::Vector3d> pi(parameters[0]), pj(parameters[1]), pk(parameters[2]), pl(parameters[3]), crvec(parameters[4]);
+    Eigen::Vector4d P, Q;
+    Eigen::Matrix<double, 4, 3> dPda, dPdb, dQdc, dQdd;
+    QVectorRatio(pj-pi, pk-pj, P, dPda, dPdb);
+    QVectorRatio(pl-pk, pi-pl, Q, dQdc, dQdd);
+    Eigen::Matrix4d LP=QLeftMatrix(P);
+    
+    Eigen::Vector4d cr; cr<<(*pLength)*cos(*pAngle), ((*pLength)*sin(*pAngle))*crvec;
+    Eigen::Map<Eigen::Vector4d> error(residuals);
+    error=(*factor)*(LP*Q-cr);
+    if (jacobians==NULL)
+      return true;
+    
+    //d(P*Q)=QRightMatrix(Q)*dP+QLeftMatrix(P)*dQ
+    Eigen::Matrix4d RQ=(*factor)*QRightMatrix(Q);
+    LP*=(*factor);
+    if (jacobians[0]!=NULL)
+      CeresJacobianMap(jacobians[0], 4, 3)=LP*dQdd-RQ*dPda;
+    if (jacobians[1]!=NULL)
+      CeresJacobianMap(jacobians[1], 4, 3)=RQ*(dPda-dPdb);
+    if (jacobians[2]!=NULL)
+      CeresJacobianMap(jacobians[2], 4, 3)=RQ*dPdb-LP*dQdc;
+    if (jacobians[3]!=NULL)
+      CeresJacobianMap(jacobians[3], 4, 3)=LP*(dQdc-dQdd);
+    if (jacobians[4]!=NULL){
+      CeresJacobianMap J(jacobians[4]);
+      J.row(0).setZero();
+      J.bottomRows(3)=Eigen::Matrix3d::Identity()*(-(*factor)*(*pLength)*sin(*pAngle));
+    }
+    return true;
+  }
+  double* pLength;
+  double* pAngle;
+  double* factor;
+};
+
+class LengthCRAnalyticError: public ceres::SizedCostFunction<4, 3, 3, 3, 3>{
+public:
+  LengthCRAnalyticError(double* _pLength,  double* _factor):pLength(_pLength), factor(_factor){}
+  virtual ~LengthCRAnalyticError(){};
+  
+  virtual bool Evaluate(double const* const* parameters,
+                        double* residuals,
+                        double** jacobians) const {
+    
+    Eigen::Map<const Eigen::Vector3d> pi(parameters[0]), pj(parameters[1]), pk(parameters[2]), pl(parameters[3]);
+    Eigen::Vector4d P, Q;
+    Eigen::Matrix<double, 4, 3> dPda, dPdb, dQdc, dQdd;
+    QVectorRatio(pj-pi, pk-pj, P, dPda, dPdb);
+    QVectorRatio(pl-pk, pi-pl, Q, dQdc, dQdd);
+    Eigen::Matrix4d LP=QLeftMatrix(P);
+    
+    Eigen::Vector4d cr; cr<<-(*pLength), 0.0, 0.0, 0.0;
+    Eigen::Map<Eigen::Vector4d> error(residuals);
+    error=(*factor)*(LP*Q-cr);
+    if (jacobians==NULL)
+      return true;
+    
+    Eigen::Matrix4d RQ=(*factor)*QRightMatrix(Q);
+    LP*=(*factor);
+    if (jacobians[0]!=NULL)
+      CeresJacobianMap(jacobians[0], 4, 3)=LP*dQdd-RQ*dPda;
+    if (jacobians[1]!=NULL)
+      CeresJacobianMap(jacobians[1], 4, 3)=RQ*(dPda-dPdb);
+    if (jacobians[2]!=NULL)
+      CeresJacobianMap(jacobians[2], 4, 3)=RQ*dPdb-LP*dQdc;
+    if (jacobians[3]!=NULL)
+      CeresJacobianMap(jacobians[3], 4, 3)=LP*(dQdc-dQdd);
+    return true;
+  }
+  double* pLength;
+  double* factor;
+};
+
+class FullFNAnalyticError: public ceres::SizedCostFunction<4, 3, 3, 3, 3>{
+public:
+  FullFNAnalyticError(double* _pLength, double* _pAngle, double* _factor):pLength(_pLength), pAngle(_pAngle), factor(_factor){}
+  virtual ~FullFNAnalyticError(){};
+  
+  virtual bool Evaluate(double const* const* parameters,
+                        double* residuals,
+                        double** jacobians) const {
+    
+    Eigen::Map<const Eigen::Vector3d> pi(parameters[0]), pj(parameters[1]), pk(parameters[2]), fnvec(parameters[3]);
+    Eigen::Vector4d P;
+    Eigen::Matrix<double, 4, 3> dPda, dPdb;
+    QVectorRatio(pj-pi, pk-pj, P, dPda, dPdb);
+    
+    Eigen::Vector4d fn; fn<<(*pLength)*cos(*pAngle), ((*pLength)*sin(*pAngle))*fnvec;
+    Eigen::Map<Eigen::Vector4d> error(residuals);
+    error=(*factor)*(P-fn);
+    if (jacobians==NULL)
+      return true;
+    
+    if (jacobians[0]!=NULL)
+      CeresJacobianMap(jacobians[0], 4, 3)=-(*factor)*dPda;
+    if (jacobians[1]!=NULL)
+      CeresJacobianMap(jacobians[1], 4, 3)=(*factor)*(dPda-dPdb);
+    if (jacobians[2]!=NULL)
+      CeresJacobianMap(jacobians[2], 4, 3)=(*factor)*dPdb;
+    if (jacobians[3]!=NULL){
+      CeresJacobianMap J(jacobians[3]);
+      J.row(0).setZero();
+      J.bottomRows(3)=Eigen::Matrix3d::Identity()*(-(*factor)*(*pLength)*sin(*pAngle));
+    }
+    return true;
+  }
+  double* pLength;
+  double* pAngle;
+  double* factor;
+};
+
+
 class CeresMRSolver{
 public:
   
-  CeresMRSolver():currSolution(NULL),problem(NULL){}
-  ~CeresMRSolver(){if (problem!=NULL) delete problem; if (currSolution!=NULL) delete[] currSolution;}
+  CeresMRSolver():currSolution(NULL),problem(NULL),lastTrustRegionRadius(-1.0){}
+  ~CeresMRSolver(){if (problem!=NULL) delete problem;}
   
   Eigen::MatrixXi D, F;
   
@@ -155,7 +330,14 @@ public:
   Eigen::MatrixXi quadFaceIndices;          //rows of wi, wj, wk, wl
   Eigen::MatrixXi faceTriads;               //rows of wi, wj, wk, FN (N belongs to wj)
   
-  double* currSolution;   //3*|V| (vertex positions) + 3*|V| (vertex cross-ratio vectors) + 3*|F| (face normals).
+  Eigen::VectorXd solution;
+  double* currSolution;   //the data of solution: 3*|V| (vertex positions) + 3*|V| (vertex cross-ratio vectors) + 3*|F| (face normals).
+  
+  //the parts of the solution as #V (or #F) by 3 matrices, which are views of currSolution (and not copies)
+  typedef Eigen::Map<Eigen::Matrix<double, Eigen::Dynamic, 3, Eigen::RowMajor> > SolutionBlock;
+  SolutionBlock positions(){return SolutionBlock(currSolution, QOrig.rows(), 3);}
+  SolutionBlock cr_vectors(){return SolutionBlock(currSolution+3*QOrig.rows(), QOrig.rows(), 3);}
+  SolutionBlock normals(){return SolutionBlock(currSolution+3*QOrig.rows()+3*QOrig.rows(), F.rows(), 3);}
   
   //prescribed variables
   Eigen::VectorXd CRLengths;
@@ -169,7 +351,10 @@ public:
   double CRFactor;
   double FNFactor;
   
-  ceres::Problem* problem;
+  CeresSolveConfig config;  //the settings of solve()
+  
+  ceres::Problem* problem;   //kept between solves, with its parameter and residual blocks
+  double lastTrustRegionRadius;   //of the last iteration of the last solve, or -1 before the first solve
   
   void init(const Eigen::MatrixXd& inQOrig,
             const Eigen::MatrixXi& inD,
@@ -194,15 +379,16 @@ public:
     FNLengths.conservativeResize(faceTriads.rows());
     FNAngles.conservativeResize(faceTriads.rows());
     
-    if (currSolution!=NULL)
-      delete[] currSolution;
-    
     if (problem!=NULL)
-      delete[] problem;
+      delete problem;
     
-    problem=new ceres::Problem;
+    ceres::Problem::Options problemOptions;
+    problemOptions.enable_fast_removal=true;
+    problem=new ceres::Problem(problemOptions);
+    lastTrustRegionRadius=-1.0;
     
-    currSolution=new double[3*QOrig.rows()+3*QOrig.rows()+3*F.rows()];
+    solution.resize(3*QOrig.rows()+3*QOrig.rows()+3*F.rows());
+    currSolution=solution.data();
     
     for (int i=0;i<QOrig.rows();i++)
       problem->AddParameterBlock(currSolution+3*i, 3);
@@ -215,7 +401,11 @@ public:
     
     //Vertex CR
     for (int i = 0; i <quadVertexIndices.rows(); ++i) {
+#ifdef HEDRA_CERES_MR_AUTODIFF
       ceres::CostFunction* cost_function=new AutoDiffCostFunction<FullCRError, 4, 3, 3, 3, 3, 3>(new FullCRError(&CRLengths(i), &CRAngles(i), &CRFactor));
+#else
+      ceres::CostFunction* cost_function=new FullCRAnalyticError(&CRLengths(i), &CRAngles(i), &CRFactor);
+#endif
       problem->AddResidualBlock(cost_function,
                                 NULL, // TODO: update with coefficients somehow,
                                 currSolution+3*quadVertexIndices(i,0),
@@ -227,7 +417,11 @@ public:
     
     //Face CR
     for (int i = 0; i<quadFaceIndices.rows(); ++i) {
+#ifdef HEDRA_CERES_MR_AUTODIFF
       ceres::CostFunction* cost_function=new AutoDiffCostFunction<LengthCRError, 4, 3, 3, 3, 3>(new LengthCRError(&faceCRLengths(i), &CRFactor));
+#else
+      ceres::CostFunction* cost_function=new LengthCRAnalyticError(&faceCRLengths(i), &CRFactor);
+#endif
       problem->AddResidualBlock(cost_function,
                                 NULL, // TODO: update with coefficients somehow,
                                 currSolution+3*quadFaceIndices(i,0),
@@ -238,7 +432,11 @@ public:
     
     //Face FN
     for (int i = 0; i <faceTriads.rows(); ++i) {
+#ifdef HEDRA_CERES_MR_AUTODIFF
       ceres::CostFunction* cost_function=new AutoDiffCostFunction<FullFNError, 4, 3, 3, 3, 3>(new FullFNError(&FNLengths(i), &FNAngles(i), &FNFactor));
+#else
+      ceres::CostFunction* cost_function=new FullFNAnalyticError(&FNLengths(i), &FNAngles(i), &FNFactor);
+#endif
       problem->AddResidualBlock(cost_function,
                                 NULL, // TODO: update with coefficients somehow,
                                 currSolution+3*faceTriads(i,0),
@@ -284,17 +482,27 @@ public:
     CRFactor=_CRFactor;
     FNFactor=_FNFactor;
     ceres::Solver::Options options;
-    options.linear_solver_type = ceres::SPARSE_NORMAL_CHOLESKY;
-    options.sparse_linear_algebra_library_type=ceres::SUITE_SPARSE;
+    //the cross-ratio vectors and the normals are each in a different residual from the others, and can be eliminated first
+    CeresSolveConfig currConfig=(config.autoTune ? config.tune(problem->NumParameters(), problem->NumResidualBlocks(), true) : config);
+    currConfig.set_options(options);
     options.minimizer_progress_to_stdout = outputProgress;
-    //options.preconditioner_type = ceres::JACOBI;
-    //options.use_inner_iterations=true;
+    if ((currConfig.warmStartTrustRegion)&&(lastTrustRegionRadius>0.0))
+      options.initial_trust_region_radius=lastTrustRegionRadius;
+    if ((currConfig.eliminateAuxiliary)&&(currConfig.is_schur())){
+      ceres::ParameterBlockOrdering* ordering=new ceres::ParameterBlockOrdering;
+      for (int i=0;i<QOrig.rows();i++){
+        ordering->AddElementToGroup(currSolution+3*i, 1);
+        ordering->AddElementToGroup(currSolution+3*QOrig.rows()+3*i, 0);
+      }
+      for (int i=0;i<F.rows();i++)
+        ordering->AddElementToGroup(currSolution+3*QOrig.rows()+3*QOrig.rows()+3*i, 0);
+      options.linear_solver_ordering.reset(ordering);
+    }
     //options.check_gradients=true;
-    options.max_num_iterations=250;
-    options.num_threads=16;
-    //options.num_linear_solver_threads = 16;
     ceres::Solver::Summary summary;
     ceres::Solve(options, problem, &summary);
+    if (!summary.iterations.empty())
+      lastTrustRegionRadius=summary.iterations.back().trust_region_radius;
     if (outputProgress)
       std::cout << summary.FullReport() << "\n";
   }
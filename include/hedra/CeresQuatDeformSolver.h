@@ -11,6 +11,7 @@
 
 #include "ceres/ceres.h"
 #include "glog/logging.h"
+#include <hedra/CeresSolveConfig.h>
 
 using ceres::AutoDiffCostFunction;
 using ceres::CostFunction;
@@ -132,7 +133,7 @@ public:
 class CeresQMDSolver{
 public:
   
-  CeresQMDSolver():currSolution(NULL),problem(NULL){}
+  CeresQMDSolver():currSolution(NULL),problem(NULL),lastTrustRegionRadius(-1.0){}
   ~CeresQMDSolver(){if (problem!=NULL) delete problem; if (currSolution!=NULL) delete[] currSolution;}
   
   Eigen::MatrixXi D, F;
@@ -150,7 +151,10 @@ public:
   Eigen::VectorXi constIndices;
   Eigen::MatrixXd constPoses;
   
+  CeresSolveConfig config;  //the settings of solve()
+  
   ceres::Problem* problem;
+  double lastTrustRegionRadius;   //of the last iteration of the last solve, or -1 before the first solve
   
   void init(const Eigen::MatrixXd& _VOrig,
             const Eigen::MatrixXi& _D,
@@ -169,6 +173,7 @@ public:
       delete problem;
     
     problem=new ceres::Problem;
+    lastTrustRegionRadius=-1.0;
     
     currSolution=new double[3*VOrig.rows()+4*VOrig.rows()];
     
@@ -252,17 +257,17 @@ public:
     AMAPFactor=_AMAPFactor;
     DCFactor=_DCFactor;
     ceres::Solver::Options options;
-    options.linear_solver_type = ceres::SPARSE_NORMAL_CHOLESKY;
-    options.sparse_linear_algebra_library_type=ceres::SUITE_SPARSE;
+    //the quaternionic variables of neighbouring vertices share residuals, so there are no auxiliary variables to eliminate, and the ordering of the Schur solvers is left to Ceres
+    CeresSolveConfig currConfig=(config.autoTune ? config.tune(problem->NumParameters(), problem->NumResidualBlocks(), false) : config);
+    currConfig.set_options(options);
     options.minimizer_progress_to_stdout = outputProgress;
-    //options.preconditioner_type = ceres::JACOBI;
-    //options.use_inner_iterations=true;
+    if ((currConfig.warmStartTrustRegion)&&(lastTrustRegionRadius>0.0))
+      options.initial_trust_region_radius=lastTrustRegionRadius;
     //options.check_gradients=true;
-    options.max_num_iterations=250;
-    options.num_threads=16;
-    //options.num_linear_solver_threads = 16;
     ceres::Solver::Summary summary;
     ceres::Solve(options, problem, &summary);
+    if (!summary.iterations.empty())
+      lastTrustRegionRadius=summary.iterations.back().trust_region_radius;
     if (outputProgress)
       std::cout << summary.FullReport() << "\n";
   }
@@ -0,0 +1,78 @@
+// This file is part of libhedra, a library for polygonal mesh processing
+//
+// Copyright (C) 2018 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef HEDRA_CERES_SOLVE_CONFIG_H
+#define HEDRA_CERES_SOLVE_CONFIG_H
+
+#include "ceres/ceres.h"
+#include <hedra/parallel_for.h>
+#include <algorithm>
+
+
+//The settings of the Ceres solves of CeresMRSolver and CeresQMDSolver, given to setup_moebius_regular() and quat_moebius_setup().
+//The defaults are those that the solvers always used, except for the threads, which are those of the machine instead of 16.
+struct CeresSolveConfig{
+  int numThreads;                 //<=0 for all the hardware threads
+  ceres::LinearSolverType linearSolverType;     //e.g., SPARSE_NORMAL_CHOLESKY, SPARSE_SCHUR, ITERATIVE_SCHUR, CGNR
+  ceres::PreconditionerType preconditionerType; //for ITERATIVE_SCHUR (e.g., SCHUR_JACOBI) and CGNR (JACOBI)
+  ceres::SparseLinearAlgebraLibraryType sparseLibrary;
+  bool eliminateAuxiliary;        //with the Schur solvers, eliminates the auxiliary variables (e.g., the cross-ratio vectors and normals of CeresMRSolver) first, instead of leaving the ordering to Ceres. Solvers whose auxiliary variables are not independent ignore it.
+  bool useInnerIterations;
+  bool warmStartTrustRegion;      //starts every solve but the first with the trust region radius where the last one ended, for a series of similar solves
+  int maxNumIterations;
+  double maxSolverTimeInSeconds;
+
+  //picks the settings from the size of the problem in solve() (see tune()), instead of the ones above
+  bool autoTune;
+
+  CeresSolveConfig():numThreads(0), linearSolverType(ceres::SPARSE_NORMAL_CHOLESKY), preconditionerType(ceres::JACOBI), sparseLibrary(ceres::SUITE_SPARSE),
+  eliminateAuxiliary(false), useInnerIterations(false), warmStartTrustRegion(false), maxNumIterations(250), maxSolverTimeInSeconds(1e9), autoTune(false){}
+
+  //Settings for a problem of the given size: threads for at least minBlocksPerThread residual blocks each, direct sparse Cholesky up to maxDirectParameters parameters, and iterative solvers above it (ITERATIVE_SCHUR with SCHUR_JACOBI if the auxiliary variables can be eliminated, and CGNR with JACOBI otherwise), where the factorization would not fit.
+  //Direct solves use the Schur complement if the auxiliary variables can be eliminated, and SuiteSparse if Ceres has it.
+  CeresSolveConfig tune(const int numParameters,
+                        const int numResidualBlocks,
+                        const bool canEliminateAuxiliary) const
+  {
+    const int minBlocksPerThread=2000;
+    const int maxDirectParameters=500000;
+
+    CeresSolveConfig config=*this;
+    config.autoTune=false;
+    config.numThreads=std::max(1, std::min(hedra::default_num_threads(), numResidualBlocks/minBlocksPerThread));
+    config.sparseLibrary=(ceres::IsSparseLinearAlgebraLibraryTypeAvailable(ceres::SUITE_SPARSE) ? ceres::SUITE_SPARSE : ceres::EIGEN_SPARSE);
+    config.eliminateAuxiliary=canEliminateAuxiliary;
+    if (numParameters<=maxDirectParameters)
+      config.linearSolverType=(canEliminateAuxiliary ? ceres::SPARSE_SCHUR : ceres::SPARSE_NORMAL_CHOLESKY);
+    else {
+      config.linearSolverType=(canEliminateAuxiliary ? ceres::ITERATIVE_SCHUR : ceres::CGNR);
+      config.preconditionerType=(canEliminateAuxiliary ? ceres::SCHUR_JACOBI : ceres::JACOBI);
+    }
+    return config;
+  }
+
+  //sets the options of a solve; the ordering, if any, is set by the solver
+  void set_options(ceres::Solver::Options& options) const
+  {
+    options.num_threads=(numThreads>0 ? numThreads : hedra::default_num_threads());
+    options.linear_solver_type=linearSolverType;
+    options.preconditioner_type=preconditionerType;
+    options.sparse_linear_algebra_library_type=sparseLibrary;
+    options.use_inner_iterations=useInnerIterations;
+    options.max_num_iterations=maxNumIterations;
+    options.max_solver_time_in_seconds=maxSolverTimeInSeconds;
+  }
+
+  bool is_schur() const
+  {
+    return ((linearSolverType==ceres::SPARSE_SCHUR)||(linearSolverType==ceres::DENSE_SCHUR)||(linearSolverType==ceres::ITERATIVE_SCHUR));
+  }
+};
+
+
+#endif
@@ -0,0 +1,51 @@
+// This file is part of libhedra, a library for polyhedral mesh processing
+//
+// Copyright (C) 2016 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+#ifndef HEDRA_CHOLMOD_SOLVER_WRAPPER_H
+#define HEDRA_CHOLMOD_SOLVER_WRAPPER_H
+#include <igl/igl_inline.h>
+#include <hedra/EigenSolverWrapper.h>
+#include <Eigen/Core>
+#include <Eigen/Sparse>
+#ifdef HEDRA_WITH_CHOLMOD
+#include <Eigen/CholmodSupport>
+#include <Eigen/SPQRSupport>
+#else
+#include <hedra/CachedOrdering.h>
+#include <Eigen/SparseQR>
+#endif
+
+//CHOLMOD and SuiteSparseQR (SuiteSparse) are optional: with HEDRA_WITH_CHOLMOD defined, and linking with cholmod and spqr (the LIBHEDRA_WITH_CHOLMOD option of the tutorials), the sparse factorizations below are those of SuiteSparse. Otherwise they fall back to the built-in ones of Eigen, so that the code that uses them does not depend on the build.
+
+namespace hedra {
+    namespace optimization
+    {
+#ifdef HEDRA_WITH_CHOLMOD
+        //The supernodal LL^T factorization of CHOLMOD, for symmetric positive-definite systems. Multi-column right-hand sides (e.g., xyz) are solved by one blocked supernodal triangular solve (BLAS-3) rather than one sweep per column.
+        //CHOLMOD computes its own fill-reducing ordering, and only reads the lower triangle.
+        typedef Eigen::CholmodSupernodalLLT<Eigen::SparseMatrix<double>, Eigen::Lower> SparseLLTSolver;
+        
+        //The multifrontal QR factorization of SuiteSparseQR, for general (e.g., indefinite) systems
+        typedef Eigen::SPQR<Eigen::SparseMatrix<double> > SparseQRSolver;
+#else
+        typedef Eigen::SimplicialLLT<Eigen::SparseMatrix<double>, Eigen::Lower> SparseLLTSolver;
+        
+        //the column ordering is reused when the same pattern is factorized again
+        typedef Eigen::SparseQR<Eigen::SparseMatrix<double>, CachedOrdering<Eigen::COLAMDOrdering<int> > > SparseQRSolver;
+#endif
+        
+        //SparseLLTSolver as a linear solver for the LM/GN/SL solvers, e.g. LMSolver<SparseLLTSolverWrapper, SolverTraits>
+        typedef EigenSolverWrapper<SparseLLTSolver> SparseLLTSolverWrapper;
+        
+#ifdef HEDRA_WITH_CHOLMOD
+        typedef SparseLLTSolverWrapper CholmodSupernodalSolverWrapper;
+#endif
+    }
+}
+
+
+#endif
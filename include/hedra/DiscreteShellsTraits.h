@@ -10,14 +10,77 @@
 #include <igl/igl_inline.h>
 #include <igl/harmonic.h>
 #include <Eigen/Core>
+#include <hedra/incremental_traits.h>
 #include <string>
 #include <vector>
 #include <cstdio>
 #include <set>
+#include <algorithm>
 
 
 namespace hedra { namespace optimization {
         
+        //3D vectors of N elements at once, in SoA (structure of arrays) layout: every coordinate is an Eigen::Array<double,N,1>, so that the arithmetic on them is vectorized with Eigen packets
+        template<int N>
+        struct Vector3Batch{
+            typedef Eigen::Array<double,N,1> Batch;
+            Batch x, y, z;
+            
+            Vector3Batch(){}
+            Vector3Batch(const Batch& _x, const Batch& _y, const Batch& _z):x(_x), y(_y), z(_z){}
+            
+            Vector3Batch operator+(const Vector3Batch& v) const{return Vector3Batch(x+v.x, y+v.y, z+v.z);}
+            Vector3Batch operator-(const Vector3Batch& v) const{return Vector3Batch(x-v.x, y-v.y, z-v.z);}
+            Vector3Batch operator*(const Batch& s) const{return Vector3Batch(x*s, y*s, z*s);}
+            Batch dot(const Vector3Batch& v) const{return x*v.x+y*v.y+z*v.z;}
+            Vector3Batch cross(const Vector3Batch& v) const{return Vector3Batch(y*v.z-z*v.y, z*v.x-x*v.z, x*v.y-y*v.x);}
+            Batch squaredNorm() const{return dot(*this);}
+        };
+        
+        //the residual ((|p1-p0|-origLength)*weight) of the length of N edges (p0,p1), and its gradient by p1 (that by p0 is its negation)
+        template<int N>
+        struct ShellEdgeKernel{
+            typedef Eigen::Array<double,N,1> Batch;
+            
+            static void residual(const Vector3Batch<N>& p0, const Vector3Batch<N>& p1, const Batch& origLength, const Batch& weight, Batch& result){
+                result=((p1-p0).squaredNorm().sqrt()-origLength)*weight;
+            }
+            
+            static void gradient(const Vector3Batch<N>& p0, const Vector3Batch<N>& p1, const Batch& weight, Vector3Batch<N>& result){
+                Vector3Batch<N> e=p1-p0;
+                Batch length=e.squaredNorm().sqrt();
+                result=e*(length>0.0).select(weight/length, Batch::Zero());
+            }
+        };
+        
+        //the residual ((dihedral angle-origDihedral)*weight) of N flaps p[0..3]=(i,j,k,l) on edges (k,i), and its gradients by p[0..3]
+        template<int N>
+        struct ShellFlapKernel{
+            typedef Eigen::Array<double,N,1> Batch;
+            
+            static void residual(const Vector3Batch<N> p[4], const Batch& origDihedral, const Batch& weight, Batch& result){
+                Vector3Batch<N> eji=p[0]-p[1], ejk=p[2]-p[1], eli=p[0]-p[3], elk=p[2]-p[3], eki=p[0]-p[2];
+                Vector3Batch<N> n1=ejk.cross(eji), n2=eli.cross(elk);
+                Batch sign=(n1.cross(n2).dot(eki)>=0.0).select(Batch::Ones(), -Batch::Ones());
+                Batch normProduct=(n1.squaredNorm()*n2.squaredNorm()).sqrt();
+                Batch cosine=(normProduct>0.0).select(n1.dot(n2)/normProduct, Batch::Zero());
+                Batch sinHalf=(sign*((1.0-cosine).max(0.0)/2.0).sqrt()).max(-1.0).min(1.0);  //sanitizing
+                result=(2.0*sinHalf.asin()-origDihedral)*weight;
+            }
+            
+            static void gradient(const Vector3Batch<N> p[4], const Batch& weight, Vector3Batch<N> result[4]){
+                Vector3Batch<N> eji=p[0]-p[1], ejk=p[2]-p[1], eli=p[0]-p[3], elk=p[2]-p[3], eki=p[0]-p[2];
+                Vector3Batch<N> n1=ejk.cross(eji), n2=eli.cross(elk);
+                Batch length=eki.squaredNorm().sqrt();
+                Batch area1=n1.squaredNorm(), area2=n2.squaredNorm();
+                Batch factor1=weight/(area1*length), factor2=weight/(area2*length);
+                result[0]=n1*(-ejk.dot(eki)*factor1)+n2*(-elk.dot(eki)*factor2);
+                result[1]=n1*(-weight*length/area1);
+                result[2]=n1*(eji.dot(eki)*factor1)+n2*(eli.dot(eki)*factor2);
+                result[3]=n2*(-weight*length/area2);
+            }
+        };
+        
         //this class is a traits class for optimization of discrete shells deformation by given positional constraints. It is an implementation on [Froehlich and Botsch 2012] for general polyhedral meshes, using a triangulation of them
     
         //the solution vector is assumed to be arranged as xyzxyzxyz... where each triplet is a coordinate of the free vertices.
@@ -33,13 +96,13 @@ namespace hedra { namespace optimization {
             
             //These are for the the full Jacobian matrix without removing the handles
             Eigen::VectorXi fullJRows, fullJCols;
-            Eigen::VectorXd fullJVals;
             Eigen::MatrixXi flapVertexIndices;  //vertices (i,j,k,l) of a flap on edge e=(k,i) where the triangles are f=(i,j,k) and g=(i,k,l)
             Eigen::MatrixXi EV;
             Eigen::VectorXi h;              //list of handles
             Eigen::MatrixXd qh;             //#h by 3 positions
             Eigen::VectorXi a2x;            //from the entire set of variables "a" to the free variables in the optimization "x".
             Eigen::VectorXi colMap;         //raw map of a2x into the columns from fullJCols into JCols
+            Eigen::VectorXi full2J;         //from the full Jacobian entries into JVals (-1 for removed variables)
             Eigen::VectorXd origLengths;    //the original edge lengths.
             Eigen::VectorXd origDihedrals;  //Original dihedral angles
             Eigen::MatrixXd VOrig;          //original positions
@@ -50,6 +113,14 @@ namespace hedra { namespace optimization {
             //Eigen::VectorXd x0;                 //the initial solution to the optimization
             Eigen::MatrixXd fullSolution;       //The final solution of the last optimization
             
+            //for partial updates (see incremental_traits.h)
+            Eigen::VectorXi varRowStart, varRows;  //the residuals of every variable
+            std::vector<char> rowMarks;
+            std::vector<int> dirtyRows, dirtyEdges, dirtyFlaps;
+            
+            typedef Eigen::Matrix<double, Eigen::Dynamic, 3, Eigen::RowMajor> PositionMatrix;
+            enum {BatchSize=4};             //elements in a batch of the element kernels
+            
             void init(const Eigen::MatrixXd& _VOrig,
                       const Eigen::MatrixXi& _T,
                       const Eigen::VectorXi& _h,
@@ -119,7 +190,6 @@ namespace hedra { namespace optimization {
                 xSize=3*(VOrig.rows()-h.size());
                 fullJRows.resize(6*EV.rows()+12*flapVertexIndices.rows());
                 fullJCols.resize(6*EV.rows()+12*flapVertexIndices.rows());
-                fullJVals.resize(6*EV.rows()+12*flapVertexIndices.rows());
                 
                 
                 //Jacobian indices for edge lengths
@@ -166,12 +236,18 @@ namespace hedra { namespace optimization {
                 
                 
                 actualGradCounter=0;
+                full2J.resize(fullJCols.size());
                 for (int i=0;i<fullJCols.size();i++){
                     if (colMap(fullJCols(i))!=-1){  //not a removed variable
+                        full2J(i)=actualGradCounter;
                         JRows(actualGradCounter)=fullJRows(i);
                         JCols(actualGradCounter++)=colMap(fullJCols(i));
-                    }
+                    } else
+                        full2J(i)=-1;
                 }
+                
+                variable_residual_adjacency(JRows, JCols, xSize, varRowStart, varRows);
+                rowMarks.assign(EVec.size(),0);
             }
             
             //provide the initial solution to the solver
@@ -194,101 +270,178 @@ namespace hedra { namespace optimization {
             bool post_iteration(const Eigen::VectorXd& x){return false;  /*never stop after an iteration*/}
             
             
-            //updating the energy vector for a given current solution
-            void update_energy(const Eigen::VectorXd& x){
-                
-                using namespace std;
-                using namespace Eigen;
-                
-                MatrixXd fullx(xSize+h.size(),3);
+            //the positions of all vertices, from the free ones in x and the handles
+            void full_positions(const Eigen::VectorXd& x, PositionMatrix& fullx){
+                fullx.resize(xSize/3+h.size(),3);
                 for (int i=0;i<a2x.size();i++)
                     if (a2x(i)!=-1)
                         fullx.row(i)<<x.segment(3*a2x(i),3).transpose();
                 
                 for (int i=0;i<h.size();i++)
                     fullx.row(h(i))=qh.row(i);
+            }
+            
+            //gathering the positions of vertex k of the given elements into a batch
+            static void gather_positions(const PositionMatrix& fullx, const Eigen::MatrixXi& elementVertices, const int* elements, const int k, Vector3Batch<BatchSize>& p){
+                for (int l=0;l<BatchSize;l++){
+                    int v=elementVertices(elements[l],k);
+                    p.x(l)=fullx(v,0);
+                    p.y(l)=fullx(v,1);
+                    p.z(l)=fullx(v,2);
+                }
+            }
+            
+            //the residuals (into EVec) or the gradients (into JVals) of the given edges (all when NULL), in batches
+            void evaluate_edges(const PositionMatrix& fullx, const int* edges, const int numEdges, const bool isJacobian){
+                typedef Eigen::Array<double,BatchSize,1> Batch;
+                for (int b=0;b<numEdges;b+=BatchSize){
+                    int numLanes=std::min((int)BatchSize, numEdges-b);
+                    int e[BatchSize];
+                    Batch origLength, weight;
+                    for (int l=0;l<BatchSize;l++){
+                        int i=b+std::min(l,numLanes-1);  //a partial batch repeats its last edge
+                        e[l]=(edges ? edges[i] : i);
+                        origLength(l)=origLengths(e[l]);
+                        weight(l)=Wl(e[l])*lengthCoeff;
+                    }
+                    Vector3Batch<BatchSize> p0, p1;
+                    gather_positions(fullx, EV, e, 0, p0);
+                    gather_positions(fullx, EV, e, 1, p1);
+                    
+                    if (!isJacobian){
+                        Batch residual;
+                        ShellEdgeKernel<BatchSize>::residual(p0, p1, origLength, weight, residual);
+                        for (int l=0;l<numLanes;l++)
+                            EVec(e[l])=residual(l);
+                    } else {
+                        Vector3Batch<BatchSize> gradient;
+                        ShellEdgeKernel<BatchSize>::gradient(p0, p1, weight, gradient);
+                        for (int l=0;l<numLanes;l++){
+                            const double values[6]={-gradient.x(l), -gradient.y(l), -gradient.z(l), gradient.x(l), gradient.y(l), gradient.z(l)};
+                            for (int c=0;c<6;c++)
+                                if (full2J(6*e[l]+c)!=-1)
+                                    JVals(full2J(6*e[l]+c))=values[c];
+                        }
+                    }
+                }
+            }
+            
+            //the residuals (into EVec) or the gradients (into JVals) of the given flaps (all when NULL), in batches
+            void evaluate_flaps(const PositionMatrix& fullx, const int* flaps, const int numFlaps, const bool isJacobian){
+                typedef Eigen::Array<double,BatchSize,1> Batch;
+                for (int b=0;b<numFlaps;b+=BatchSize){
+                    int numLanes=std::min((int)BatchSize, numFlaps-b);
+                    int f[BatchSize];
+                    Batch origDihedral, weight;
+                    for (int l=0;l<BatchSize;l++){
+                        int i=b+std::min(l,numLanes-1);  //a partial batch repeats its last flap
+                        f[l]=(flaps ? flaps[i] : i);
+                        origDihedral(l)=origDihedrals(f[l]);
+                        weight(l)=Wd(f[l])*bendCoeff;
+                    }
+                    Vector3Batch<BatchSize> p[4];
+                    for (int k=0;k<4;k++)
+                        gather_positions(fullx, flapVertexIndices, f, k, p[k]);
+                    
+                    if (!isJacobian){
+                        Batch residual;
+                        ShellFlapKernel<BatchSize>::residual(p, origDihedral, weight, residual);
+                        for (int l=0;l<numLanes;l++)
+                            EVec(EV.rows()+f[l])=residual(l);
+                    } else {
+                        Vector3Batch<BatchSize> gradient[4];
+                        ShellFlapKernel<BatchSize>::gradient(p, weight, gradient);
+                        for (int l=0;l<numLanes;l++){
+                            int first=6*EV.rows()+12*f[l];
+                            for (int k=0;k<4;k++){
+                                if (full2J(first+3*k)!=-1){  //the coordinates of a vertex are either all free or all removed
+                                    JVals(full2J(first+3*k))=gradient[k].x(l);
+                                    JVals(full2J(first+3*k+1))=gradient[k].y(l);
+                                    JVals(full2J(first+3*k+2))=gradient[k].z(l);
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+            
+            //splitting the residuals of the changed variables into edges and flaps
+            void dirty_elements(const Eigen::VectorXi& changedVariables){
+                dirty_residuals(changedVariables, varRowStart, varRows, rowMarks, dirtyRows);
+                dirtyEdges.clear();
+                dirtyFlaps.clear();
+                for (size_t i=0;i<dirtyRows.size();i++){
+                    if (dirtyRows[i]<EV.rows())
+                        dirtyEdges.push_back(dirtyRows[i]);
+                    else
+                        dirtyFlaps.push_back(dirtyRows[i]-EV.rows());
+                }
+            }
+            
+            //updating the energy vector for a given current solution
+            void update_energy(const Eigen::VectorXd& x){
                 
-                fullJVals.setZero();
-                for (int i=0;i<EV.rows();i++)
-                    EVec(i)=((fullx.row(EV(i,1))-fullx.row(EV(i,0))).norm()-origLengths(i))*Wl(i)*lengthCoeff;
+                using namespace std;
+                using namespace Eigen;
                 
+                PositionMatrix fullx;
+                full_positions(x, fullx);
                 
-                for (int i=0;i<flapVertexIndices.rows();i++){
-                    RowVector3d eji=fullx.row(flapVertexIndices(i,0))-fullx.row(flapVertexIndices(i,1));
-                    RowVector3d ejk=fullx.row(flapVertexIndices(i,2))-fullx.row(flapVertexIndices(i,1));
-                    RowVector3d eli=fullx.row(flapVertexIndices(i,0))-fullx.row(flapVertexIndices(i,3));
-                    RowVector3d elk=fullx.row(flapVertexIndices(i,2))-fullx.row(flapVertexIndices(i,3));
-                    RowVector3d eki=fullx.row(flapVertexIndices(i,0))-fullx.row(flapVertexIndices(i,2));
-                    
-                    RowVector3d n1 = (ejk.cross(eji));
-                    RowVector3d n2 = (eli.cross(elk));
-                    double sign=((n1.cross(n2)).dot(eki) >= 0 ? 1.0 : -1.0);
-                    double dotn1n2=1.0-n1.normalized().dot(n2.normalized());
-                    if (dotn1n2<0.0) dotn1n2=0.0;  //sanitizing
-                    double sinHalf=sign*sqrt(dotn1n2/2.0);
-                    if (sinHalf>1.0) sinHalf=1.0; if (sinHalf<-1.0) sinHalf=-1.0;
-                    EVec(EV.rows()+i)=(2.0*asin(sinHalf)-origDihedrals(i))*Wd(i)*bendCoeff;
-                }
+                evaluate_edges(fullx, NULL, EV.rows(), false);
+                evaluate_flaps(fullx, NULL, flapVertexIndices.rows(), false);
                 
                 for (int i=0;i<EVec.size();i++)
                     if (isnan(EVec(i)))
                         cout<<"nan in EVec("<<i<<")"<<endl;
             }
             
-            
-            //update the jacobian values for a given current solution
-            void update_jacobian(const Eigen::VectorXd& x){
+            //updating only the residuals of the variables that changed since EVec was computed (see incremental_traits.h)
+            void update_energy(const Eigen::VectorXd& x, const Eigen::VectorXi& changedVariables){
+                
                 using namespace std;
                 using namespace Eigen;
                 
-                MatrixXd fullx(xSize+h.size(),3);
-                for (int i=0;i<a2x.size();i++)
-                    if (a2x(i)!=-1)
-                        fullx.row(i)<<x.segment(3*a2x(i),3).transpose();
+                PositionMatrix fullx;
+                full_positions(x, fullx);
                 
-                for (int i=0;i<h.size();i++)
-                    fullx.row(h(i))=qh.row(i);
+                dirty_elements(changedVariables);
+                evaluate_edges(fullx, dirtyEdges.data(), dirtyEdges.size(), false);
+                evaluate_flaps(fullx, dirtyFlaps.data(), dirtyFlaps.size(), false);
                 
-                fullJVals.setZero();
-                for (int i=0;i<EV.rows();i++){
-                   
-                    RowVector3d normedEdgeVector=(fullx.row(EV(i,1))-fullx.row(EV(i,0))).normalized();
-                    fullJVals.segment(6*i,3)<<-normedEdgeVector.transpose()*Wl(i)*lengthCoeff;
-                    fullJVals.segment(6*i+3,3)<<normedEdgeVector.transpose()*Wl(i)*lengthCoeff;
-                }
+                for (size_t i=0;i<dirtyRows.size();i++)
+                    if (isnan(EVec(dirtyRows[i])))
+                        cout<<"nan in EVec("<<dirtyRows[i]<<")"<<endl;
+            }
+            
+            
+            //update the jacobian values for a given current solution
+            void update_jacobian(const Eigen::VectorXd& x){
+                using namespace std;
+                using namespace Eigen;
                 
-                for (int i=0;i<flapVertexIndices.rows();i++){
-                    RowVector3d eji=fullx.row(flapVertexIndices(i,0))-fullx.row(flapVertexIndices(i,1));
-                    RowVector3d ejk=fullx.row(flapVertexIndices(i,2))-fullx.row(flapVertexIndices(i,1));
-                    RowVector3d eli=fullx.row(flapVertexIndices(i,0))-fullx.row(flapVertexIndices(i,3));
-                    RowVector3d elk=fullx.row(flapVertexIndices(i,2))-fullx.row(flapVertexIndices(i,3));
-                    RowVector3d eki=fullx.row(flapVertexIndices(i,0))-fullx.row(flapVertexIndices(i,2));
-                    
-                    RowVector3d n1 = (ejk.cross(eji));
-                    RowVector3d n2 = (eli.cross(elk));
-                    double sign=((n1.cross(n2)).dot(eki) >= 0 ? 1.0 : -1.0);
-                    double dotn1n2=1.0-n1.normalized().dot(n2.normalized());
-                    if (dotn1n2<0.0) dotn1n2=0.0;  //sanitizing
-                    double sinHalf=sign*sqrt(dotn1n2/2.0);
-                    if (sinHalf>1.0) sinHalf=1.0; if (sinHalf<-1.0) sinHalf=-1.0;
-                    
-                    fullJVals.segment(6*EV.rows()+12*i,3)<<(Wd(i)*((ejk.dot(-eki)/(n1.squaredNorm()*eki.norm()))*n1+(elk.dot(-eki)/(n2.squaredNorm()*eki.norm()))*n2)).transpose()*bendCoeff;
-                    fullJVals.segment(6*EV.rows()+12*i+3,3)<<(Wd(i)*(-eki.norm()/n1.squaredNorm())*n1).transpose()*bendCoeff;
-                    fullJVals.segment(6*EV.rows()+12*i+6,3)<<(Wd(i)*((eji.dot(eki)/(n1.squaredNorm()*eki.norm()))*n1+(eli.dot(eki)/(n2.squaredNorm()*eki.norm()))*n2)).transpose()*bendCoeff;
-                    fullJVals.segment(6*EV.rows()+12*i+9,3)<<(Wd(i)*(-eki.norm()/n2.squaredNorm())*n2).transpose()*bendCoeff;
-                    
-                }
+                PositionMatrix fullx;
+                full_positions(x, fullx);
                 
-
-                int actualGradCounter=0;
-                for (int i=0;i<fullJCols.size();i++)
-                    if (colMap(fullJCols(i))!=-1)  //not a removed variable
-                        JVals(actualGradCounter++)=fullJVals(i);
+                evaluate_edges(fullx, NULL, EV.rows(), true);
+                evaluate_flaps(fullx, NULL, flapVertexIndices.rows(), true);
                 
                 for (int i=0;i<JVals.size();i++)
                     if (isnan(JVals(i)))
                         cout<<"nan in JVals("<<i<<")"<<endl;
             }
+            
+            //updating only the gradients of the residuals of the variables that changed since JVals was computed (see incremental_traits.h)
+            void update_jacobian(const Eigen::VectorXd& x, const Eigen::VectorXi& changedVariables){
+                using namespace std;
+                using namespace Eigen;
+                
+                PositionMatrix fullx;
+                full_positions(x, fullx);
+                
+                dirty_elements(changedVariables);
+                evaluate_edges(fullx, dirtyEdges.data(), dirtyEdges.size(), true);
+                evaluate_flaps(fullx, dirtyFlaps.data(), dirtyFlaps.size(), true);
+            }
 
             
             
@@ -308,6 +461,7 @@ namespace hedra { namespace optimization {
             ~DiscreteShellsTraits(){}
         };
         
+        template<> struct is_incremental<DiscreteShellsTraits> : std::true_type {};
         
     } }
 
@@ -0,0 +1,124 @@
+// This file is part of libhedra, a library for polyhedral mesh processing
+//
+// Copyright (C) 2016 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+#ifndef HEDRA_DUAL_H
+#define HEDRA_DUAL_H
+#include <igl/igl_inline.h>
+#include <Eigen/Core>
+#include <cmath>
+
+namespace hedra { namespace optimization {
+
+    //in their own namespace, so that the math functions below do not hide those of <cmath> for unqualified calls in hedra::optimization; they are found by argument-dependent lookup
+    namespace dual_numbers {
+
+    //A forward-mode dual number: a value and its derivatives by N variables, with a fixed size so that the derivative arithmetic is unrolled and vectorized.
+    //Functions that are templated on the scalar type evaluate with double for values only, and with Dual<N> for values and gradients (see AutodiffTraits.h). Branches should compare values (value_of()), and the math functions should be called unqualified (e.g., "using std::sqrt; sqrt(a)") so that the overloads below are found.
+    template<int N>
+    struct Dual{
+        typedef Eigen::Matrix<double,N,1> Gradient;
+        double a;       //the value
+        Gradient v;     //the derivatives by the variables
+
+        Dual():a(0.0), v(Gradient::Zero()){}
+        Dual(const double _a):a(_a), v(Gradient::Zero()){}
+        Dual(const double _a, const Gradient& _v):a(_a), v(_v){}
+
+        //variable k of the N, with the given value
+        static Dual variable(const double value, const int k){
+            Dual d(value);
+            d.v(k)=1.0;
+            return d;
+        }
+
+        Dual& operator+=(const Dual& b){a+=b.a; v+=b.v; return *this;}
+        Dual& operator-=(const Dual& b){a-=b.a; v-=b.v; return *this;}
+        Dual& operator*=(const Dual& b){v=v*b.a+b.v*a; a*=b.a; return *this;}
+        Dual& operator/=(const Dual& b){v=(v-b.v*(a/b.a))/b.a; a/=b.a; return *this;}
+        Dual& operator+=(const double b){a+=b; return *this;}
+        Dual& operator-=(const double b){a-=b; return *this;}
+        Dual& operator*=(const double b){a*=b; v*=b; return *this;}
+        Dual& operator/=(const double b){a/=b; v/=b; return *this;}
+
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    };
+
+    //the value of a double or of a dual number, for branching in templated functions
+    inline double value_of(const double a){return a;}
+    template<int N> inline double value_of(const Dual<N>& a){return a.a;}
+
+    template<int N> inline Dual<N> operator-(const Dual<N>& a){return Dual<N>(-a.a, -a.v);}
+    template<int N> inline Dual<N> operator+(const Dual<N>& a, const Dual<N>& b){return Dual<N>(a.a+b.a, a.v+b.v);}
+    template<int N> inline Dual<N> operator-(const Dual<N>& a, const Dual<N>& b){return Dual<N>(a.a-b.a, a.v-b.v);}
+    template<int N> inline Dual<N> operator*(const Dual<N>& a, const Dual<N>& b){return Dual<N>(a.a*b.a, a.v*b.a+b.v*a.a);}
+    template<int N> inline Dual<N> operator/(const Dual<N>& a, const Dual<N>& b){
+        double q=a.a/b.a;
+        return Dual<N>(q, (a.v-b.v*q)/b.a);
+    }
+    template<int N> inline Dual<N> operator+(const Dual<N>& a, const double b){return Dual<N>(a.a+b, a.v);}
+    template<int N> inline Dual<N> operator+(const double a, const Dual<N>& b){return Dual<N>(a+b.a, b.v);}
+    template<int N> inline Dual<N> operator-(const Dual<N>& a, const double b){return Dual<N>(a.a-b, a.v);}
+    template<int N> inline Dual<N> operator-(const double a, const Dual<N>& b){return Dual<N>(a-b.a, -b.v);}
+    template<int N> inline Dual<N> operator*(const Dual<N>& a, const double b){return Dual<N>(a.a*b, a.v*b);}
+    template<int N> inline Dual<N> operator*(const double a, const Dual<N>& b){return Dual<N>(a*b.a, b.v*a);}
+    template<int N> inline Dual<N> operator/(const Dual<N>& a, const double b){return Dual<N>(a.a/b, a.v/b);}
+    template<int N> inline Dual<N> operator/(const double a, const Dual<N>& b){
+        double q=a/b.a;
+        return Dual<N>(q, b.v*(-q/b.a));
+    }
+
+    //comparisons are by value
+    template<int N> inline bool operator<(const Dual<N>& a, const Dual<N>& b){return a.a<b.a;}
+    template<int N> inline bool operator>(const Dual<N>& a, const Dual<N>& b){return a.a>b.a;}
+    template<int N> inline bool operator<=(const Dual<N>& a, const Dual<N>& b){return a.a<=b.a;}
+    template<int N> inline bool operator>=(const Dual<N>& a, const Dual<N>& b){return a.a>=b.a;}
+    template<int N> inline bool operator<(const Dual<N>& a, const double b){return a.a<b;}
+    template<int N> inline bool operator>(const Dual<N>& a, const double b){return a.a>b;}
+    template<int N> inline bool operator<=(const Dual<N>& a, const double b){return a.a<=b;}
+    template<int N> inline bool operator>=(const Dual<N>& a, const double b){return a.a>=b;}
+    template<int N> inline bool operator<(const double a, const Dual<N>& b){return a<b.a;}
+    template<int N> inline bool operator>(const double a, const Dual<N>& b){return a>b.a;}
+    template<int N> inline bool operator<=(const double a, const Dual<N>& b){return a<=b.a;}
+    template<int N> inline bool operator>=(const double a, const Dual<N>& b){return a>=b.a;}
+
+    //the chain rule f(a)'=f'(a)*a'
+    template<int N> inline Dual<N> chain(const double value, const double derivative, const Dual<N>& a){return Dual<N>(value, a.v*derivative);}
+
+    template<int N> inline Dual<N> sqrt(const Dual<N>& a){
+        double s=std::sqrt(a.a);
+        return chain(s, 0.5/s, a);
+    }
+    template<int N> inline Dual<N> exp(const Dual<N>& a){
+        double e=std::exp(a.a);
+        return chain(e, e, a);
+    }
+    template<int N> inline Dual<N> log(const Dual<N>& a){return chain(std::log(a.a), 1.0/a.a, a);}
+    template<int N> inline Dual<N> pow(const Dual<N>& a, const double b){return chain(std::pow(a.a,b), b*std::pow(a.a,b-1.0), a);}
+    template<int N> inline Dual<N> sin(const Dual<N>& a){return chain(std::sin(a.a), std::cos(a.a), a);}
+    template<int N> inline Dual<N> cos(const Dual<N>& a){return chain(std::cos(a.a), -std::sin(a.a), a);}
+    template<int N> inline Dual<N> tan(const Dual<N>& a){
+        double t=std::tan(a.a);
+        return chain(t, 1.0+t*t, a);
+    }
+    template<int N> inline Dual<N> asin(const Dual<N>& a){return chain(std::asin(a.a), 1.0/std::sqrt(1.0-a.a*a.a), a);}
+    template<int N> inline Dual<N> acos(const Dual<N>& a){return chain(std::acos(a.a), -1.0/std::sqrt(1.0-a.a*a.a), a);}
+    template<int N> inline Dual<N> atan(const Dual<N>& a){return chain(std::atan(a.a), 1.0/(1.0+a.a*a.a), a);}
+    template<int N> inline Dual<N> abs(const Dual<N>& a){return (a.a<0.0 ? -a : a);}
+    template<int N> inline Dual<N> atan2(const Dual<N>& y, const Dual<N>& x){
+        double r2=x.a*x.a+y.a*y.a;
+        return Dual<N>(std::atan2(y.a, x.a), (y.v*x.a-x.v*y.a)/r2);
+    }
+
+    }
+
+    using dual_numbers::Dual;
+    using dual_numbers::value_of;
+
+} }
+
+
+#endif
@@ -14,21 +14,24 @@
 #include <vector>
 #include <cstdio>
 #include <set>
+#include <algorithm>
 
 
 namespace hedra {
     namespace optimization
     {
-        //a templated wrapper to all sparse solvers by Eigen. Not doing much and not entirely efficient since the matrix has to be initialized twice, but not too bad.
-        //
-        
-        //TODO: perhaps better to invalidate the analysis stage and do it all in the factorization.
+        //a templated wrapper to all sparse solvers by Eigen. Re-analyzing an unchanged pattern keeps the previous symbolic analysis, and solvers with a CachedOrdering also share orderings across instances. The pattern is assembled once in analyze(), together with a scatter plan from every input (row,col) pair to its slot in the compressed storage of A, so factorize() only writes values in place without building or sorting triplets.
         template<class EigenSparseSolver>
         class EigenSolverWrapper{
         public:
             EigenSparseSolver solver;
             Eigen::SparseMatrix<double> A;
             Eigen::VectorXi rows, cols;
+            Eigen::VectorXi valueMap;       //slot in A.valuePtr() of every (rows(i), cols(i)) entry
+            Eigen::VectorXi transValueMap;  //slot of the mirrored (cols(i), rows(i)) entry, or -1 when it is not mirrored
+            bool isAnalyzed;                //whether solver holds the symbolic analysis of the pattern of A
+            
+            EigenSolverWrapper():isAnalyzed(false){}
             
             //if Symmetric = true that means that (_rows, _cols) only contain the bottom left as input, and the matrix will be symmetrized.
             bool analyze(const Eigen::VectorXi& _rows,
@@ -36,6 +39,8 @@ namespace hedra {
                          const bool Symmetric){
                 rows=_rows;
                 cols=_cols;
+                Eigen::SparseMatrix<double> prevA;
+                prevA.swap(A);
                 A.resize(rows.maxCoeff()+1, cols.maxCoeff()+1);
                 std::vector<Eigen::Triplet<double> > triplets;
                 for (int i=0;i<rows.size();i++){
@@ -45,21 +50,36 @@ namespace hedra {
                 }
                 A.setZero();
                 A.setFromTriplets(triplets.begin(), triplets.end());
-                solver.analyzePattern(A);
+                A.makeCompressed();
+                
+                //the same pattern as the last analysis (for instance, only the handles changed): the symbolic analysis is still valid
+                bool isSamePattern=(isAnalyzed)&&(prevA.rows()==A.rows())&&(prevA.cols()==A.cols())&&(prevA.nonZeros()==A.nonZeros())&&
+                std::equal(A.outerIndexPtr(), A.outerIndexPtr()+A.outerSize()+1, prevA.outerIndexPtr())&&
+                std::equal(A.innerIndexPtr(), A.innerIndexPtr()+A.nonZeros(), prevA.innerIndexPtr());
+                
+                //the scatter plan; duplicate (row,col) pairs map to the same slot and are summed in factorize()
+                valueMap.resize(rows.size());
+                transValueMap.resize(rows.size());
+                for (int i=0;i<rows.size();i++){
+                    valueMap(i)=pattern_slot(rows(i), cols(i));
+                    transValueMap(i)=((Symmetric)&&(rows(i)!=cols(i)) ? pattern_slot(cols(i), rows(i)) : -1);
+                }
+                
+                if (!isSamePattern)
+                    solver.analyzePattern(A);
+                isAnalyzed=true;
                 return true; //(solver.info()==Eigen::Success);
             }
             
             bool factorize(const Eigen::VectorXd& values,
                            const bool Symmetric){
-                std::vector<Eigen::Triplet<double> > triplets;
+                double* AVals=A.valuePtr();
+                std::fill(AVals, AVals+A.nonZeros(), 0.0);
                 for (int i=0;i<rows.size();i++){
-                    triplets.push_back(Eigen::Triplet<double> (rows(i), cols(i), values(i)));
-                    if ((Symmetric)&&(rows(i)!=cols(i)))
-                        triplets.push_back(Eigen::Triplet<double> (cols(i), rows(i), values(i)));
-                        
+                    AVals[valueMap(i)]+=values(i);
+                    if ((Symmetric)&&(transValueMap(i)!=-1))
+                        AVals[transValueMap(i)]+=values(i);
                 }
-                A.setZero();
-                A.setFromTriplets(triplets.begin(), triplets.end());
                 solver.factorize(A);
                 return (solver.info()==Eigen::Success);
             }
@@ -68,10 +88,16 @@ namespace hedra {
                        Eigen::MatrixXd& x){
                 
                  //cout<<"Rhs: "<<rhs<<endl;
-                x.conservativeResize(A.cols(), rhs.cols());
-                for (int i=0;i<rhs.cols();i++)
-                    x.col(i) = solver.solve(rhs.col(i));
-                return true;
+                //all columns at once, so that backends with blocked triangular solves (e.g. CHOLMOD supernodal, see CholmodSolverWrapper.h) treat them as one matrix-matrix solve
+                x = solver.solve(rhs);
+                return (solver.info()==Eigen::Success);
+            }
+            
+            //the index of (row,col) in the compressed storage of A; the entry must be in the pattern.
+            int pattern_slot(const int row, const int col) const{
+                const int* colStart=A.innerIndexPtr()+A.outerIndexPtr()[col];
+                const int* colEnd=A.innerIndexPtr()+A.outerIndexPtr()[col+1];
+                return (int)(std::lower_bound(colStart, colEnd, row)-A.innerIndexPtr());
             }
         };
         
@@ -9,14 +9,25 @@
 #define HEDRA_GAUSS_NEWTON_SOLVER_H
 #include <igl/igl_inline.h>
 #include <Eigen/Core>
+#include <hedra/jacobian_kernels.h>
+#include <hedra/is_matrix_free.h>
+#include <hedra/SolverTelemetry.h>
 #include <string>
 #include <vector>
 #include <cstdio>
 #include <iostream>
+#include <cmath>
+#include <algorithm>
 
 namespace hedra {
     namespace optimization
     {
+        //the search along the Gauss-Newton direction; only the energy is evaluated at the trial points
+        enum GNLineSearch{
+            HALVING,    //halving the step until the largest residual does not grow, and stopping only by the traits
+            ARMIJO,     //halving the step until the Armijo sufficient decrease of |EVec|^2 holds, and stopping on convergence
+            CUBIC       //as ARMIJO, with the steps by quadratic and then cubic interpolation of |EVec|^2 along the direction [Nocedal and Wright 2006, Section 3.5]
+        };
         
         template<class LinearSolver, class SolverTraits>
         class GNSolver{
@@ -31,6 +42,8 @@ namespace hedra {
             Eigen::VectorXi HRows, HCols;  //(row,col) pairs for H=J^T*J matrix
             Eigen::VectorXd HVals;      //values for H matrix
             Eigen::MatrixXi S2D;        //single J to J^J indices
+            Eigen::VectorXi adjColStart, adjColPerm;  //column-sorted gather pattern of J for J^T*v
+            int numThreads;             //threads for the Jacobian products (1 by default); results do not depend on it
             
             LinearSolver* LS;
             SolverTraits* ST;
@@ -38,6 +51,15 @@ namespace hedra {
             double hTolerance;
             double xTolerance;
             double fooTolerance;
+            GNLineSearch lineSearch;
+            double armijoFactor;        //ARMIJO and CUBIC: the fraction of the linearly predicted decrease that a step must achieve
+            
+            //statistics of the last solve()
+            int numEnergyEvaluations;
+            int numJacobianEvaluations;
+            int numFactorizations;
+            
+            SolverTelemetry* telemetry; //optional per-iteration records and phase times (see SolverTelemetry.h); NULL by default
             
             //Input: pattern of matrix M by (iI,iJ) representation
             //Output: pattern of matrix M^T*M by (oI, oJ) representation
@@ -92,33 +114,130 @@ namespace hedra {
                               const Eigen::MatrixXi& S2D,
                               Eigen::VectorXd& oS)
             {
-                for (int i=0;i<S2D.rows();i++)
-                    oS(i)=iS(S2D(i,0))*iS(S2D(i,1));
+                matrix_values(iS, S2D, numThreads, oS);
             }
             
             //returns M^t*ivec by (I,J,S) representation
+            //uses the gather pattern from init() when (I,J,S) is the Jacobian of the traits
             void MultiplyAdjointVector(const Eigen::VectorXi& iI,
                                        const Eigen::VectorXi& iJ,
                                        const Eigen::VectorXd& iS,
                                        const Eigen::VectorXd& iVec,
                                        Eigen::VectorXd& oVec)
             {
+                if ((&iJ==&ST->JCols)&&(iJ.size()==adjColPerm.size())&&(oVec.size()==adjColStart.size()-1)){
+                    multiply_adjoint_vector(iI, iS, iVec, adjColStart, adjColPerm, numThreads, oVec);
+                    return;
+                }
                 oVec.setZero();
                 for (int i=0;i<iI.size();i++)
                     oVec(iJ(i))+=iS(i)*iVec(iI(i));
             }
             
             
+            //setting up the linear solver: either with the pattern of H=J^T*J, or directly with the pattern of J for matrix-free linear solvers
+            void analyze_system(std::false_type){
+                MatrixPattern(ST->JRows, ST->JCols,HRows,HCols,S2D);
+                HVals.resize(HRows.size());
+                LS->analyze(HRows,HCols,true);
+            }
+            
+            void analyze_system(std::true_type){
+                LS->analyze_jacobian(ST->JRows, ST->JCols, ST->xSize);
+            }
+            
+            bool factorize_system(std::false_type){
+                {
+                    SolverTelemetry::ScopedTimer timer(telemetry, MATRIX_VALUES);
+                    MatrixValues(HRows, HCols, ST->JVals, S2D, HVals);
+                }
+                SolverTelemetry::ScopedTimer timer(telemetry, FACTORIZE);
+                return LS->factorize(HVals,true);
+            }
+            
+            bool factorize_system(std::true_type){
+                SolverTelemetry::ScopedTimer timer(telemetry, FACTORIZE);
+                return LS->factorize_jacobian(ST->JVals, 0.0);
+            }
+            
+            //the traits and linear solver calls, timed into the telemetry
+            void timed_update_energy(const Eigen::VectorXd& currx){
+                SolverTelemetry::ScopedTimer timer(telemetry, UPDATE_ENERGY);
+                numEnergyEvaluations++;
+                ST->update_energy(currx);
+            }
+            
+            void timed_update_jacobian(const Eigen::VectorXd& currx){
+                SolverTelemetry::ScopedTimer timer(telemetry, UPDATE_JACOBIAN);
+                numJacobianEvaluations++;
+                ST->update_jacobian(currx);
+            }
+            
+            //ARMIJO and CUBIC: searches x=prevx+h*direction from h=1 until |EVec(x)|^2 <= prevE+armijoFactor*h*slope, where slope=-2*rhs.dot(direction) is the derivative of |EVec|^2 along the direction.
+            //returns false, with x=prevx, if the direction does not descend or h fell below hTolerance
+            bool sufficient_decrease_search(const Eigen::VectorXd& direction,
+                                            const Eigen::VectorXd& rhs,
+                                            const double prevE)
+            {
+                double slope=-2.0*rhs.dot(direction);
+                if (!(slope<0.0)){
+                    x=prevx;
+                    return false;
+                }
+                double h=1.0, prevh=0.0, prevEh=0.0;
+                while (h>hTolerance){
+                    x=prevx+h*direction;
+                    timed_update_energy(x);
+                    double Eh=ST->EVec.squaredNorm();
+                    if (Eh<=prevE+armijoFactor*h*slope)
+                        return true;
+                    
+                    double nexth=0.5*h;
+                    if (lineSearch==CUBIC){
+                        double r=Eh-prevE-slope*h;  //the excess over the linear model
+                        if (prevh==0.0){
+                            nexth=-slope*h*h/(2.0*r);  //the minimum of the quadratic through prevE, slope and Eh
+                        } else {
+                            //the minimum of the cubic through prevE, slope, Eh and the previous trial
+                            double prevr=prevEh-prevE-slope*prevh;
+                            double a=(r/(h*h)-prevr/(prevh*prevh))/(h-prevh);
+                            double b=(-prevh*r/(h*h)+h*prevr/(prevh*prevh))/(h-prevh);
+                            double discriminant=b*b-3.0*a*slope;
+                            if (a==0.0)
+                                nexth=-slope/(2.0*b);
+                            else if (discriminant>=0.0)
+                                nexth=(-b+std::sqrt(discriminant))/(3.0*a);
+                        }
+                        //safeguarding against too small or too large reductions
+                        if (!std::isfinite(nexth))
+                            nexth=0.5*h;
+                        nexth=std::min(std::max(nexth, 0.1*h), 0.5*h);
+                    }
+                    prevh=h;
+                    prevEh=Eh;
+                    h=nexth;
+                }
+                x=prevx;
+                return false;
+            }
+            
+            void timed_solve(const Eigen::MatrixXd& rhs, Eigen::MatrixXd& direction){
+                SolverTelemetry::ScopedTimer timer(telemetry, SOLVE);
+                LS->solve(rhs, direction);
+            }
+            
         public:
             
-            GNSolver(){};
+            GNSolver():numThreads(1), lineSearch(HALVING), armijoFactor(10e-5),
+            numEnergyEvaluations(0), numJacobianEvaluations(0), numFactorizations(0), telemetry(NULL){};
             
             void init(LinearSolver* _LS,
                       SolverTraits* _ST,
                       int _maxIterations=100,
                       double _xTolerance=10e-6,
                       double _hTolerance=10e-9,
-                      double _fooTolerance=10e7){
+                      double _fooTolerance=10e7,
+                      GNLineSearch _lineSearch=HALVING){
                 
                 LS=_LS;
                 ST=_ST;
@@ -126,11 +245,10 @@ namespace hedra {
                 hTolerance=_hTolerance;
                 xTolerance=_xTolerance;
                 fooTolerance=_fooTolerance;
+                lineSearch=_lineSearch;
                 //analysing pattern
-                MatrixPattern(ST->JRows, ST->JCols,HRows,HCols,S2D);
-                HVals.resize(HRows.size());
-                
-                LS->analyze(HRows,HCols,true);
+                adjoint_gather_pattern(ST->JCols, ST->xSize, adjColStart, adjColPerm);
+                analyze_system(is_matrix_free<LinearSolver>());
                 
                 d.resize(ST->xSize);
                 x.resize(ST->xSize);
@@ -147,8 +265,12 @@ namespace hedra {
                 using namespace std;
                 ST->initial_solution(x0);
                 prevx<<x0;
+                if (telemetry)
+                    telemetry->begin_solve();
+                int bigIteration=0;
                 int currIter=0;
                 bool stop=false;
+                numEnergyEvaluations=numJacobianEvaluations=numFactorizations=0;
                 double currError, prevError;
                 VectorXd rhs(ST->xSize);
                 MatrixXd direction;
@@ -159,47 +281,62 @@ namespace hedra {
                     currIter=0;
                     stop=false;
                     do{
+                        if (telemetry)
+                            telemetry->begin_iteration(bigIteration, currIter);
                         ST->pre_iteration(prevx);
-                        ST->update_energy(prevx);
-                        ST->update_jacobian(prevx);
+                        timed_update_energy(prevx);
+                        timed_update_jacobian(prevx);
                         if (verbose)
                             cout<<"Initial Energy for Iteration "<<currIter<<": "<<ST->EVec.template lpNorm<Infinity>()<<endl;
-                        MatrixValues(HRows, HCols, ST->JVals, S2D, HVals);
                         MultiplyAdjointVector(ST->JRows, ST->JCols, ST->JVals, -ST->EVec, rhs);
+                        if (telemetry){
+                            telemetry->current.energy=ST->EVec.squaredNorm();
+                            telemetry->current.firstOrderOptimality=rhs.template lpNorm<Infinity>();
+                        }
                         
                         //solving to get the GN direction
-                        if(!LS->factorize(HVals, true)) {
+                        numFactorizations++;
+                        if(!factorize_system(is_matrix_free<LinearSolver>())) {
                             // decomposition failed
-                            cout<<"Solver Failed to factorize! "<<endl;
+                            if (verbose)
+                                cout<<"Solver Failed to factorize! "<<endl;
+                            if (telemetry)
+                                telemetry->end_solve();
                             return false;
                         }
                         
-                        LS->solve(rhs,direction);
-                        cout<<"direction max"<<direction.template lpNorm<Infinity>()<<endl;
+                        timed_solve(rhs,direction);
+                        if (verbose)
+                            cout<<"direction max: "<<direction.template lpNorm<Infinity>()<<endl;
                         
-                        //doing a line search by decreasing by half until the energy goes down
-                        //TODO: more effective line search
                         prevEnergy<<ST->EVec;
                         prevError=prevEnergy.template lpNorm<Infinity>();
-                        cout<<"prevError: "<<prevError<<endl;
-                        double h=1.0;
-                        double t=0.0; //10e-4*direction.dot(rhs);
-                        do{
-                            x<<prevx+h*direction;
-                            ST->update_energy(x);
-                            currEnergy<<ST->EVec;
-                            currError=currEnergy.template lpNorm<Infinity>();
-                            //cout<<"currError: "<<currError<<endl;
-                            //cout<<"h="<<h<<endl;
-                            if (prevError-currError>=0.0)//h*t)
-                                break;
-                            
-                            h*=0.5;
-                            
-                        }while (h>hTolerance);
+                        bool isDecreasing;
+                        if (lineSearch==HALVING){
+                            //doing a line search by decreasing by half until the energy goes down
+                            double h=1.0;
+                            do{
+                                x<<prevx+h*direction;
+                                timed_update_energy(x);
+                                currEnergy<<ST->EVec;
+                                currError=currEnergy.template lpNorm<Infinity>();
+                                if (prevError-currError>=0.0)
+                                    break;
+                                
+                                h*=0.5;
+                                
+                            }while (h>hTolerance);
+                            isDecreasing=(prevError-currError>=0.0);
+                        } else {
+                            isDecreasing=sufficient_decrease_search(direction.col(0), rhs, prevEnergy.squaredNorm());
+                            if ((verbose)&&(isDecreasing))
+                                cout<<"Energy after line search: "<<ST->EVec.squaredNorm()<<endl;
+                        }
                         
-                        if (verbose){
-                            //cout<<"currError: "<<currError<<endl;
+                        if (telemetry){
+                            telemetry->current.stepNorm=(x-prevx).norm();
+                            telemetry->current.isAccepted=isDecreasing;
+                            telemetry->end_iteration();
                         }
                         
                         currIter++;
@@ -214,11 +351,20 @@ namespace hedra {
                         prevx<<x;
                         //The SolverTraits can order the optimization to stop by giving "true" of to continue by giving "false"
                         bool stopFromTraits=ST->post_iteration(x);
-                        stop = /*stop ||*/ stopFromTraits;
-                        if (stopFromTraits)
+                        if (lineSearch==HALVING)
+                            stop = /*stop ||*/ stopFromTraits;
+                        else {
+                            if ((verbose)&&(!isDecreasing))
+                                cout<<"Stopping since the line search found no decrease."<<endl;
+                            stop = stop || stopFromTraits || (!isDecreasing);
+                        }
+                        if (stopFromTraits&&verbose)
                             cout<<"ST->Post_iteration() gave a stop"<<endl;
                     }while ((currIter<=maxIterations)&&(!stop));
+                    bigIteration++;
                 }while (!ST->post_optimization(x));
+                if (telemetry)
+                    telemetry->end_solve();
                 return stop;
             }
         };
@@ -11,6 +11,10 @@
 #include <igl/sortrows.h>
 #include <igl/speye.h>
 #include <Eigen/Core>
+#include <hedra/jacobian_kernels.h>
+#include <hedra/is_matrix_free.h>
+#include <hedra/incremental_traits.h>
+#include <hedra/SolverTelemetry.h>
 #include <string>
 #include <vector>
 #include <list>
@@ -20,6 +24,13 @@
 namespace hedra {
     namespace optimization
     {
+        //why the last (inner) optimization of LMSolver::solve() stopped
+        enum LMStopReason{
+            FIRST_ORDER_OPTIMALITY,     //|J^T*EVec|_inf<fooTolerance
+            SMALL_STEP,                 //|direction|<xTolerance*|x|
+            TRAITS_STOP,                //post_iteration() of the traits returned true
+            MAX_ITERATIONS              //none of the above within maxIterations
+        };
         
         template<class LinearSolver, class SolverTraits>
         class LMSolver{
@@ -34,6 +45,8 @@ namespace hedra {
             Eigen::VectorXi HRows, HCols;  //(row,col) pairs for H=J^T*J matrix
             Eigen::VectorXd HVals;      //values for H matrix
             Eigen::MatrixXi S2D;        //single J to J^J indices
+            Eigen::VectorXi adjColStart, adjColPerm;  //column-sorted gather pattern of J for J^T*v
+            int numThreads;             //threads for the Jacobian products (1 by default); results do not depend on it
 
             LinearSolver* LS;
             SolverTraits* ST;
@@ -41,6 +54,19 @@ namespace hedra {
             double xTolerance;
             double fooTolerance;
             
+            //statistics of the last solve(), for comparisons with TRSolver
+            int numFactorizations;
+            int numAcceptedSteps;
+            int numRejectedSteps;
+            LMStopReason stopReason;
+            
+            SolverTelemetry* telemetry; //optional per-iteration records and phase times (see SolverTelemetry.h); NULL by default
+            
+            //with incremental traits (see incremental_traits.h), only the residuals of the variables that changed by more than this since they were last updated are recomputed; negative (default) for full updates
+            double incrementalThreshold;
+            IncrementalTracker energyTracker, jacobianTracker;
+            Eigen::VectorXi changedVariables;
+            
             /*void TestMatrixOperations(){
              
                 using namespace Eigen;
@@ -127,86 +153,7 @@ namespace hedra {
                                Eigen::VectorXi& oJ,
                                Eigen::MatrixXi& S2D)
             {
-                int CurrTri=0;
-                using namespace Eigen;
-                //std::list<int> oIlist;
-                //std::list<int> oJlist;
-                //std::list<std::pair<int, int> > S2Dlist;
-                int ISize=0, JSize=0, S2DSize=0;
-                do{
-                    int CurrRow=iI(CurrTri);
-                    int NumCurrTris=0;
-                    while ((CurrTri+NumCurrTris<iI.size())&&(iI(CurrTri+NumCurrTris)==CurrRow))
-                        NumCurrTris++;
-                    
-                    for (int i=CurrTri;i<CurrTri+NumCurrTris;i++){
-                        for (int j=CurrTri;j<CurrTri+NumCurrTris;j++){
-                            if (iJ(j)>=iJ(i)){
-                                /*oIlist.push_back(iJ(i));
-                                oJlist.push_back(iJ(j));
-                                S2Dlist.push_back(std::pair<int,int>(i,j));*/
-                                ISize++; JSize++; S2DSize++;
-                            }
-                        }
-                    }
-                    CurrTri+=NumCurrTris;
-                }while (CurrTri!=iI.size());
-                
-                ISize+=iJ.maxCoeff()+1;
-                JSize+=iJ.maxCoeff()+1;
-                
-                oI.resize(ISize);
-                oJ.resize(JSize);
-                S2D.resize(S2DSize,2);
-                
-                CurrTri=0;
-                int ICounter=0, JCounter=0, S2DCounter=0;
-                do{
-                    int CurrRow=iI(CurrTri);
-                    int NumCurrTris=0;
-                    while ((CurrTri+NumCurrTris<iI.size())&&(iI(CurrTri+NumCurrTris)==CurrRow))
-                        NumCurrTris++;
-                    
-                    for (int i=CurrTri;i<CurrTri+NumCurrTris;i++){
-                        for (int j=CurrTri;j<CurrTri+NumCurrTris;j++){
-                            if (iJ(j)>=iJ(i)){
-                                oI(ICounter++)=iJ(i);
-                                oJ(JCounter++)=iJ(j);
-                                S2D.row(S2DCounter++)<<i,j;
-                                /*oIlist.push_back(iJ(i));
-                                 oJlist.push_back(iJ(j));
-                                 S2Dlist.push_back(std::pair<int,int>(i,j));*/
-                            }
-                        }
-                    }
-                    CurrTri+=NumCurrTris;
-                }while (CurrTri!=iI.size());
-                
-                /*int oldIlistSize=oIlist.size();
-                int oldJlistSize=oJlist.size();
-                oIlist.resize(oldIlistSize+iJ.maxCoeff()+1);
-                oJlist.resize(oldJlistSize+iJ.maxCoeff()+1);*/
-                //triplets for miu
-                for (int i=0;i<iJ.maxCoeff()+1;i++){
-                    oI(ICounter+i)=i;
-                    oJ(JCounter+i)=i;
-                }
-                
-                /*oI.resize(oIlist.size());
-                oJ.resize(oJlist.size());
-                S2D.resize(S2Dlist.size(),2);
-                
-                int counter=0;
-                for (std::list<int>::const_iterator iter=oIlist.begin();iter!=oIlist.end();iter++)
-                    oI(counter++)=*iter;
-                
-                counter=0;
-                for (std::list<int>::const_iterator iter=oJlist.begin();iter!=oJlist.end();iter++)
-                    oJ(counter++)=*iter;
-                
-                counter=0;
-                for (std::list<std::pair<int, int> >::const_iterator iter=S2Dlist.begin();iter!=S2Dlist.end();iter++)
-                    S2D.row(counter++)<<iter->first, iter->second;*/
+                normal_equations_pattern(iI, iJ, oI, oJ, S2D);
             }
             
             //returns the values of M^T*M+miu*I by multiplication and aggregating from Single2double list.
@@ -218,48 +165,115 @@ namespace hedra {
                               const double miu,
                               Eigen::VectorXd& oS)
             {
-                for (int i=0;i<S2D.rows();i++)
-                    oS(i)=iS(S2D(i,0))*iS(S2D(i,1));
-                
-                //adding miu*I
-                for (int i=S2D.rows();i<oI.rows();i++)
-                    oS(i)=miu;
-                
+                normal_equations_values(iS, S2D, miu, numThreads, oS);
             }
             
-            //returns M^t*ivec by (I,J,S) representation
-            void MultiplyAdjointVector(const Eigen::VectorXi& iI,
-                                       const Eigen::VectorXi& iJ,
-                                       const Eigen::VectorXd& iS,
-                                       const Eigen::VectorXd& iVec,
+            //oVec=J^T*iVec for the Jacobian of the traits, by the gather pattern from init()
+            void MultiplyAdjointVector(const Eigen::VectorXd& iVec,
                                        Eigen::VectorXd& oVec)
             {
-                oVec.setZero();
-                for (int i=0;i<iI.size();i++)
-                    oVec(iJ(i))+=iS(i)*iVec(iI(i));
+                multiply_adjoint_vector(ST->JRows, ST->JVals, iVec, adjColStart, adjColPerm, numThreads, oVec);
+            }
+            
+            
+            //the pattern of H=J^T*J+miu*I, which matrix-free linear solvers do not need
+            void system_pattern(std::false_type){
+                MatrixPattern(ST->JRows, ST->JCols,HRows,HCols,S2D);
+            }
+            
+            void system_pattern(std::true_type){}
+            
+            //setting up the linear solver: either with the pattern of H=J^T*J+miu*I, or directly with the pattern of J for matrix-free linear solvers
+            void analyze_system(std::false_type){
+                HVals.resize(HRows.size());
+                LS->analyze(HRows,HCols, true);
+            }
+            
+            void analyze_system(std::true_type){
+                LS->analyze_jacobian(ST->JRows, ST->JCols, ST->xSize);
+            }
+            
+            bool factorize_system(const double miu, std::false_type){
+                {
+                    SolverTelemetry::ScopedTimer timer(telemetry, MATRIX_VALUES);
+                    MatrixValues(HRows, HCols, ST->JVals, S2D,  miu, HVals);
+                }
+                SolverTelemetry::ScopedTimer timer(telemetry, FACTORIZE);
+                return LS->factorize(HVals, true);
+            }
+            
+            bool factorize_system(const double miu, std::true_type){
+                SolverTelemetry::ScopedTimer timer(telemetry, FACTORIZE);
+                return LS->factorize_jacobian(ST->JVals, miu);
+            }
+            
+            //full updates, or partial updates of the residuals of the changed variables for incremental traits
+            void update_energy_system(const Eigen::VectorXd& currx, std::false_type){
+                ST->update_energy(currx);
+            }
+            
+            void update_energy_system(const Eigen::VectorXd& currx, std::true_type){
+                if ((incrementalThreshold<0.0)||(!energyTracker.changed_variables(currx, incrementalThreshold, changedVariables)))
+                    ST->update_energy(currx);
+                else
+                    ST->update_energy(currx, changedVariables);
+            }
+            
+            void update_jacobian_system(const Eigen::VectorXd& currx, std::false_type){
+                ST->update_jacobian(currx);
+            }
+            
+            void update_jacobian_system(const Eigen::VectorXd& currx, std::true_type){
+                if ((incrementalThreshold<0.0)||(!jacobianTracker.changed_variables(currx, incrementalThreshold, changedVariables)))
+                    ST->update_jacobian(currx);
+                else
+                    ST->update_jacobian(currx, changedVariables);
+            }
+            
+            //the traits and linear solver calls, timed into the telemetry
+            void timed_update_energy(const Eigen::VectorXd& currx){
+                SolverTelemetry::ScopedTimer timer(telemetry, UPDATE_ENERGY);
+                update_energy_system(currx, is_incremental<SolverTraits>());
+            }
+            
+            void timed_update_jacobian(const Eigen::VectorXd& currx){
+                SolverTelemetry::ScopedTimer timer(telemetry, UPDATE_JACOBIAN);
+                update_jacobian_system(currx, is_incremental<SolverTraits>());
             }
             
+            void timed_solve(const Eigen::MatrixXd& rhs, Eigen::MatrixXd& direction){
+                SolverTelemetry::ScopedTimer timer(telemetry, SOLVE);
+                LS->solve(rhs, direction);
+            }
             
         public:
             
-            LMSolver(){};
+            LMSolver():numThreads(1), numFactorizations(0), numAcceptedSteps(0), numRejectedSteps(0), stopReason(MAX_ITERATIONS), telemetry(NULL), incrementalThreshold(-1.0){};
             
             void init(LinearSolver* _LS,
                       SolverTraits* _ST,
                       int _maxIterations=100,
                       double _xTolerance=10e-9,
-                      double _fooTolerance=10e-9){
+                      double _fooTolerance=10e-9,
+                      const LMSolver* patternSolver=NULL){
                 
                 LS=_LS;
                 ST=_ST;
                 maxIterations=_maxIterations;
                 xTolerance=_xTolerance;
                 fooTolerance=_fooTolerance;
-                //analysing pattern
-                MatrixPattern(ST->JRows, ST->JCols,HRows,HCols,S2D);
-                HVals.resize(HRows.size());
-                
-                LS->analyze(HRows,HCols, true);
+                //analysing pattern, or copying it from an initialized solver whose traits have the same JRows, JCols and xSize (see BatchSolver.h)
+                if (patternSolver!=NULL){
+                    adjColStart=patternSolver->adjColStart;
+                    adjColPerm=patternSolver->adjColPerm;
+                    HRows=patternSolver->HRows;
+                    HCols=patternSolver->HCols;
+                    S2D=patternSolver->S2D;
+                } else {
+                    adjoint_gather_pattern(ST->JCols, ST->xSize, adjColStart, adjColPerm);
+                    system_pattern(is_matrix_free<LinearSolver>());
+                }
+                analyze_system(is_matrix_free<LinearSolver>());
                 
                 d.resize(ST->xSize);
                 x.resize(ST->xSize);
@@ -278,8 +292,11 @@ namespace hedra {
                 using namespace std;
                 ST->initial_solution(x0);
                 prevx<<x0;
+                numFactorizations=numAcceptedSteps=numRejectedSteps=0;
+                if (telemetry)
+                    telemetry->begin_solve();
+                int bigIteration=0;
                 int currIter=0;
-                bool stop=false;
                 double currError, prevError;
                 VectorXd rhs(ST->xSize);
                 VectorXd direction;
@@ -291,10 +308,8 @@ namespace hedra {
                 //estimating initial miu
                 double miu=0.0;
                 ST->update_jacobian(prevx);
-                MatrixValues(HRows, HCols, ST->JVals, S2D, miu, HVals);
-                for (int i=0;i<HRows.size();i++)
-                    if (HRows(i)==HCols(i))  //on the diagonal
-                        miu=(miu < HVals(i) ? HVals(i) : miu);
+                for (int i=0;i<ST->JVals.size();i++)  //the largest diagonal J_i*J_i product of J^T*J
+                    miu=(miu < ST->JVals(i)*ST->JVals(i) ? ST->JVals(i)*ST->JVals(i) : miu);
                 miu*=tau;
                 double initmiu=miu;
                if (verbose)
@@ -304,55 +319,76 @@ namespace hedra {
                 double gamma=3.0;
                 do{
                     currIter=0;
-                    stop=false;
+                    stopReason=MAX_ITERATIONS;
+                    //post_optimization() may change the traits between big iterations
+                    energyTracker.reset();
+                    jacobianTracker.reset();
                     do{
+                        if (telemetry){
+                            telemetry->begin_iteration(bigIteration, currIter);
+                            telemetry->current.miu=miu;
+                        }
                         ST->pre_iteration(prevx);
-                        ST->update_energy(prevx);
-                        ST->update_jacobian(prevx);
+                        timed_update_energy(prevx);
+                        timed_update_jacobian(prevx);
                         if (verbose)
                             cout<<"Initial Energy for Iteration "<<currIter<<": "<<ST->EVec.template squaredNorm()<<endl;
-                        MatrixValues(HRows, HCols, ST->JVals, S2D,  miu, HVals);
-                        MultiplyAdjointVector(ST->JRows, ST->JCols, ST->JVals, -ST->EVec, rhs);
+                        MultiplyAdjointVector(-ST->EVec, rhs);
                         
                         double firstOrderOptimality=rhs.template lpNorm<Infinity>();
                         if (verbose)
                             cout<<"firstOrderOptimality: "<<firstOrderOptimality<<endl;
+                        if (telemetry){
+                            telemetry->current.energy=ST->EVec.squaredNorm();
+                            telemetry->current.firstOrderOptimality=firstOrderOptimality;
+                        }
                         
                         if (firstOrderOptimality<fooTolerance){
                             x=prevx;
-                            if (verbose){
+                            stopReason=FIRST_ORDER_OPTIMALITY;
+                            if (verbose)
                                 cout<<"First-order optimality has been reached"<<endl;
-                                break;
-                            }
+                            break;
                         }
                         
                         //solving to get the GN direction
-                        if(!LS->factorize(HVals, true)) {
+                        numFactorizations++;
+                        if(!factorize_system(miu, is_matrix_free<LinearSolver>())) {
                             // decomposition failed
-                            cout<<"Solver Failed to factorize! "<<endl;
+                            if (verbose)
+                                cout<<"Solver Failed to factorize! "<<endl;
+                            if (telemetry)
+                                telemetry->end_solve();
                             return false;
                         }
                         
                         MatrixXd mRhs=rhs;
                         MatrixXd mDirection;
-                        LS->solve(mRhs,mDirection);
+                        timed_solve(mRhs,mDirection);
                         direction=mDirection.col(0);
                         if (verbose)
                             cout<<"direction magnitude: "<<direction.norm()<<endl;
                         if (direction.norm() < xTolerance * prevx.norm()){
                             x=prevx;
+                            stopReason=SMALL_STEP;
                             if (verbose)
                                 cout<<"Stopping since direction magnitude small."<<endl;
                             break;
                         }
                         VectorXd tryx=prevx+direction;
-                        ST->update_energy(prevx);
+                        timed_update_energy(prevx);
                         double prevE=ST->EVec.squaredNorm();
-                        ST->update_energy(tryx);
+                        timed_update_energy(tryx);
                         double currE=ST->EVec.squaredNorm();
                         
                         double rho=(prevE-currE)/(direction.dot(miu*direction+rhs));
+                        if (telemetry){
+                            telemetry->current.stepNorm=direction.norm();
+                            telemetry->current.isAccepted=(rho>0);
+                            telemetry->end_iteration();
+                        }
                         if (rho>0){
+                            numAcceptedSteps++;
                             x=tryx;
                             //if (verbose){
                                 //cout<<"Energy: "<<currE<<endl;
@@ -363,6 +399,7 @@ namespace hedra {
                             //if (verbose)
                             //    cout<<"rho, miu, nu: "<<rho<<","<<miu<<","<<nu<<endl;
                         } else {
+                            numRejectedSteps++;
                             x=prevx;
                             miu = miu*nu;
                             nu=2*nu;
@@ -372,6 +409,7 @@ namespace hedra {
                                                
                         //The SolverTraits can order the optimization to stop by giving "true" of to continue by giving "false"
                         if (ST->post_iteration(x)){
+                            stopReason=TRAITS_STOP;
                             if (verbose)
                                 cout<<"ST->Post_iteration() gave a stop"<<endl;
                             break;
@@ -379,7 +417,10 @@ namespace hedra {
                         currIter++;
                         prevx=x;
                     }while (currIter<=maxIterations);
+                    bigIteration++;
                 }while (!ST->post_optimization(x));
+                if (telemetry)
+                    telemetry->end_solve();
                 return true;
             }
         };
@@ -0,0 +1,279 @@
+// This file is part of libhedra, a library for polyhedral mesh processing
+//
+// Copyright (C) 2016 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+#ifndef HEDRA_MAPPED_HEDRA_MESH_H
+#define HEDRA_MAPPED_HEDRA_MESH_H
+#include <igl/igl_inline.h>
+#include <hedra/PolygonMesh.h>
+#include <Eigen/Core>
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <limits>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+namespace hedra
+{
+    //The binary .hedra mesh format (version 1):
+    //  a HedraFileHeader, followed by the sections below, each starting at a 64-byte aligned offset from the table in the header (0 for absent sections).
+    //  All arrays are in native (little-endian) byte order and in Eigen's default column-major layout, so they are used in place with Eigen::Map.
+    //
+    //  geometry (always):    V            numV by 3 doubles
+    //                        faceStart    numFaces+1 ints, the CSR offsets of the faces (see PolygonMesh.h)
+    //                        faceVertices numCorners ints
+    //  edge topology (optional, as polygonal_edge_topology on the PolygonMesh):
+    //                        EV, EF, EFi  numEdges by 2 ints
+    //                        FE           numCorners ints, FEs numCorners doubles
+    //                        innerEdges   numInnerEdges ints
+    //  DCEL (optional, as dcel on the PolygonMesh):
+    //                        VH numV ints, EH numEdges by 2 ints, FH numCorners ints
+    //                        HV, HE, HF, nextH, prevH, twinH  numHalfedges ints each
+
+    enum HedraFileSections{
+        HEDRA_V=0,
+        HEDRA_FACE_START,
+        HEDRA_FACE_VERTICES,
+        HEDRA_EV,
+        HEDRA_EF,
+        HEDRA_EFI,
+        HEDRA_FE,
+        HEDRA_FES,
+        HEDRA_INNER_EDGES,
+        HEDRA_VH,
+        HEDRA_EH,
+        HEDRA_FH,
+        HEDRA_HV,
+        HEDRA_HE,
+        HEDRA_HF,
+        HEDRA_NEXTH,
+        HEDRA_PREVH,
+        HEDRA_TWINH,
+        HEDRA_NUM_SECTIONS
+    };
+
+    const std::uint32_t HEDRA_FILE_VERSION=1;
+    const std::uint32_t HEDRA_ENDIAN_TAG=0x01020304;
+    const std::uint32_t HEDRA_HAS_TOPOLOGY=1;
+    const std::uint32_t HEDRA_HAS_DCEL=2;
+
+    struct HedraFileHeader{
+        char magic[8];              //"HEDRAMSH"
+        std::uint32_t version;
+        std::uint32_t endianTag;    //HEDRA_ENDIAN_TAG as written by the producing machine
+        std::uint32_t flags;        //HEDRA_HAS_TOPOLOGY | HEDRA_HAS_DCEL
+        std::uint32_t reserved;
+        std::int64_t numV, numFaces, numCorners, numEdges, numInnerEdges, numHalfedges;
+        std::uint64_t sectionOffset[HEDRA_NUM_SECTIONS];
+        std::uint64_t sectionSize[HEDRA_NUM_SECTIONS];   //in bytes
+    };
+
+    // A read-only memory mapping of a .hedra file. All accessors return Eigen::Maps directly into the mapping, so loading costs no parsing and no copies.
+    // open() validates the file once: the header, the section table against the file size, and the range of every index array (faces, edge topology and DCEL), so that untrusted files cannot make the maps index out of bounds. The coordinates (V and FEs) are only read when they are used.
+    // The maps are valid as long as the object is open; the object is not copyable.
+    class MappedHedraMesh{
+    public:
+        MappedHedraMesh():data(NULL), fileSize(0)
+#ifdef _WIN32
+        , fileHandle(INVALID_HANDLE_VALUE), mappingHandle(NULL)
+#endif
+        {}
+
+        ~MappedHedraMesh(){close();}
+
+        bool open(const std::string& fileName)
+        {
+            close();
+#ifdef _WIN32
+            fileHandle=CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+            if (fileHandle==INVALID_HANDLE_VALUE)
+                return false;
+            LARGE_INTEGER size;
+            if (!GetFileSizeEx(fileHandle, &size)){close(); return false;}
+            fileSize=(size_t)size.QuadPart;
+            if (fileSize<sizeof(HedraFileHeader)){close(); return false;}
+            mappingHandle=CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+            if (mappingHandle==NULL){close(); return false;}
+            data=(const char*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+            if (data==NULL){close(); return false;}
+#else
+            int fd=::open(fileName.c_str(), O_RDONLY);
+            if (fd<0)
+                return false;
+            struct stat fileStat;
+            if ((fstat(fd, &fileStat)!=0)||(fileStat.st_size<(off_t)sizeof(HedraFileHeader))){
+                ::close(fd);
+                return false;
+            }
+            fileSize=(size_t)fileStat.st_size;
+            void* mapping=mmap(NULL, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd);  //the mapping keeps the file
+            if (mapping==MAP_FAILED){
+                fileSize=0;
+                return false;
+            }
+            data=(const char*)mapping;
+#endif
+            if (!validate()){
+                close();
+                return false;
+            }
+            return true;
+        }
+
+        void close()
+        {
+#ifdef _WIN32
+            if (data!=NULL) UnmapViewOfFile(data);
+            if (mappingHandle!=NULL) CloseHandle(mappingHandle);
+            if (fileHandle!=INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+            mappingHandle=NULL;
+            fileHandle=INVALID_HANDLE_VALUE;
+#else
+            if (data!=NULL) munmap((void*)data, fileSize);
+#endif
+            data=NULL;
+            fileSize=0;
+        }
+
+        bool is_open() const {return data!=NULL;}
+        const HedraFileHeader& header() const {return *(const HedraFileHeader*)data;}
+        bool has_topology() const {return (header().flags & HEDRA_HAS_TOPOLOGY)!=0;}
+        bool has_dcel() const {return (header().flags & HEDRA_HAS_DCEL)!=0;}
+
+        int num_vertices() const {return (int)header().numV;}
+        int num_faces() const {return (int)header().numFaces;}
+        int num_edges() const {return (int)header().numEdges;}
+        int num_halfedges() const {return (int)header().numHalfedges;}
+
+        Eigen::Map<const Eigen::MatrixXd> V() const {return Eigen::Map<const Eigen::MatrixXd>(section<double>(HEDRA_V), header().numV, 3);}
+        PolygonMeshMap polygons() const {return PolygonMeshMap(section<int>(HEDRA_FACE_START), num_faces(), section<int>(HEDRA_FACE_VERTICES));}
+
+        //edge topology; only when has_topology()
+        Eigen::Map<const Eigen::MatrixXi> EV() const {return edge_matrix(HEDRA_EV);}
+        Eigen::Map<const Eigen::MatrixXi> EF() const {return edge_matrix(HEDRA_EF);}
+        Eigen::Map<const Eigen::MatrixXi> EFi() const {return edge_matrix(HEDRA_EFI);}
+        Eigen::Map<const Eigen::VectorXi> FE() const {return vector_section<int>(HEDRA_FE, header().numCorners);}
+        Eigen::Map<const Eigen::VectorXd> FEs() const {return vector_section<double>(HEDRA_FES, header().numCorners);}
+        Eigen::Map<const Eigen::VectorXi> innerEdges() const {return vector_section<int>(HEDRA_INNER_EDGES, header().numInnerEdges);}
+
+        //DCEL; only when has_dcel()
+        Eigen::Map<const Eigen::VectorXi> VH() const {return vector_section<int>(HEDRA_VH, header().numV);}
+        Eigen::Map<const Eigen::MatrixXi> EH() const {return edge_matrix(HEDRA_EH);}
+        Eigen::Map<const Eigen::VectorXi> FH() const {return vector_section<int>(HEDRA_FH, header().numCorners);}
+        Eigen::Map<const Eigen::VectorXi> HV() const {return vector_section<int>(HEDRA_HV, header().numHalfedges);}
+        Eigen::Map<const Eigen::VectorXi> HE() const {return vector_section<int>(HEDRA_HE, header().numHalfedges);}
+        Eigen::Map<const Eigen::VectorXi> HF() const {return vector_section<int>(HEDRA_HF, header().numHalfedges);}
+        Eigen::Map<const Eigen::VectorXi> nextH() const {return vector_section<int>(HEDRA_NEXTH, header().numHalfedges);}
+        Eigen::Map<const Eigen::VectorXi> prevH() const {return vector_section<int>(HEDRA_PREVH, header().numHalfedges);}
+        Eigen::Map<const Eigen::VectorXi> twinH() const {return vector_section<int>(HEDRA_TWINH, header().numHalfedges);}
+
+    private:
+        const char* data;
+        size_t fileSize;
+#ifdef _WIN32
+        HANDLE fileHandle;
+        HANDLE mappingHandle;
+#endif
+
+        MappedHedraMesh(const MappedHedraMesh&);
+        MappedHedraMesh& operator=(const MappedHedraMesh&);
+
+        template<typename Scalar>
+        const Scalar* section(const int s) const {return (const Scalar*)(data+header().sectionOffset[s]);}
+
+        template<typename Scalar>
+        Eigen::Map<const Eigen::Matrix<Scalar, Eigen::Dynamic, 1> > vector_section(const int s, const std::int64_t size) const {return Eigen::Map<const Eigen::Matrix<Scalar, Eigen::Dynamic, 1> >(section<Scalar>(s), size);}
+
+        Eigen::Map<const Eigen::MatrixXi> edge_matrix(const int s) const {return Eigen::Map<const Eigen::MatrixXi>(section<int>(s), header().numEdges, 2);}
+
+        //that the count entries of section s are in [minIndex, endIndex)
+        bool is_in_range(const int s, const std::int64_t count, const int minIndex, const std::int64_t endIndex) const
+        {
+            const int* indices=section<int>(s);
+            for (std::int64_t i=0;i<count;i++)
+                if ((indices[i]<minIndex)||(indices[i]>=endIndex))
+                    return false;
+            return true;
+        }
+
+        //the header, that every section that should be there is within the file with the right size, and that every index array indexes within its range
+        bool validate() const
+        {
+            const HedraFileHeader& h=header();
+            if ((std::memcmp(h.magic, "HEDRAMSH", 8)!=0)||(h.version!=HEDRA_FILE_VERSION)||(h.endianTag!=HEDRA_ENDIAN_TAG))
+                return false;
+            //the counts are int indices (and numFaces+1 is an int too), which also keeps the section sizes below from overflowing
+            const std::int64_t maxCount=std::numeric_limits<int>::max()-1;
+            if ((h.numV<0)||(h.numFaces<0)||(h.numCorners<0)||(h.numEdges<0)||(h.numInnerEdges<0)||(h.numHalfedges<0))
+                return false;
+            if ((h.numV>maxCount)||(h.numFaces>maxCount)||(h.numCorners>maxCount)||(h.numEdges>maxCount)||(h.numInnerEdges>maxCount)||(h.numHalfedges>maxCount))
+                return false;
+
+            std::int64_t expectedSize[HEDRA_NUM_SECTIONS]={
+                h.numV*3*8, (h.numFaces+1)*4, h.numCorners*4,
+                h.numEdges*2*4, h.numEdges*2*4, h.numEdges*2*4, h.numCorners*4, h.numCorners*8, h.numInnerEdges*4,
+                h.numV*4, h.numEdges*2*4, h.numCorners*4, h.numHalfedges*4, h.numHalfedges*4, h.numHalfedges*4, h.numHalfedges*4, h.numHalfedges*4, h.numHalfedges*4};
+            for (int s=0;s<HEDRA_NUM_SECTIONS;s++){
+                bool isNeeded=(s<=HEDRA_FACE_VERTICES)||((s<=HEDRA_INNER_EDGES) ? ((h.flags & HEDRA_HAS_TOPOLOGY)!=0) : ((h.flags & HEDRA_HAS_DCEL)!=0));
+                if (!isNeeded)
+                    continue;
+                //offset+size<=fileSize, without the sum that could wrap around
+                if ((h.sectionSize[s]!=(std::uint64_t)expectedSize[s])||(h.sectionOffset[s]<sizeof(HedraFileHeader))||(h.sectionOffset[s]%8!=0)||
+                    (h.sectionSize[s]>fileSize)||(h.sectionOffset[s]>fileSize-h.sectionSize[s]))
+                    return false;
+            }
+
+            //the faces are consecutive ranges of the corners, and every corner is a vertex
+            const int* faceStart=section<int>(HEDRA_FACE_START);
+            if ((faceStart[0]!=0)||(faceStart[h.numFaces]!=h.numCorners))
+                return false;
+            for (std::int64_t f=0;f<h.numFaces;f++)
+                if (faceStart[f+1]<faceStart[f])
+                    return false;
+            if (!is_in_range(HEDRA_FACE_VERTICES, h.numCorners, 0, h.numV))
+                return false;
+
+            //the edge topology: EF and EFi are -1 where an edge has no face, and otherwise a face and a position in it
+            if ((h.flags & HEDRA_HAS_TOPOLOGY)!=0){
+                if (!(is_in_range(HEDRA_EV, 2*h.numEdges, 0, h.numV)&&is_in_range(HEDRA_EF, 2*h.numEdges, -1, h.numFaces)&&
+                      is_in_range(HEDRA_FE, h.numCorners, 0, h.numEdges)&&is_in_range(HEDRA_INNER_EDGES, h.numInnerEdges, 0, h.numEdges)))
+                    return false;
+                const int* EF=section<int>(HEDRA_EF);
+                const int* EFi=section<int>(HEDRA_EFI);
+                for (std::int64_t i=0;i<2*h.numEdges;i++)
+                    if ((EF[i]==-1) ? (EFi[i]!=-1) : ((EFi[i]<0)||(EFi[i]>=faceStart[EF[i]+1]-faceStart[EF[i]])))
+                        return false;
+            }
+
+            //the DCEL: VH is -1 for unreferenced vertices, and EH and twinH for boundary edges
+            if ((h.flags & HEDRA_HAS_DCEL)!=0){
+                if (!(is_in_range(HEDRA_VH, h.numV, -1, h.numHalfedges)&&is_in_range(HEDRA_EH, 2*h.numEdges, -1, h.numHalfedges)&&
+                      is_in_range(HEDRA_FH, h.numCorners, 0, h.numHalfedges)&&is_in_range(HEDRA_HV, h.numHalfedges, 0, h.numV)&&
+                      is_in_range(HEDRA_HE, h.numHalfedges, 0, h.numEdges)&&is_in_range(HEDRA_HF, h.numHalfedges, 0, h.numFaces)&&
+                      is_in_range(HEDRA_NEXTH, h.numHalfedges, 0, h.numHalfedges)&&is_in_range(HEDRA_PREVH, h.numHalfedges, 0, h.numHalfedges)&&
+                      is_in_range(HEDRA_TWINH, h.numHalfedges, -1, h.numHalfedges)))
+                    return false;
+            }
+            return true;
+        }
+    };
+}
+
+
+#endif
@@ -0,0 +1,235 @@
+// This file is part of libhedra, a library for polyhedral mesh processing
+//
+// Copyright (C) 2016 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+#ifndef HEDRA_MATRIX_FREE_CG_WRAPPER_H
+#define HEDRA_MATRIX_FREE_CG_WRAPPER_H
+#include <igl/igl_inline.h>
+#include <hedra/is_matrix_free.h>
+#include <hedra/jacobian_kernels.h>
+#include <hedra/parallel_for.h>
+#include <Eigen/Core>
+#include <Eigen/Dense>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+
+namespace hedra {
+    namespace optimization
+    {
+        enum CGPreconditionerTypes{
+            JACOBI,         //the diagonal of J^T*J+miu*I
+            BLOCK_JACOBI    //the 3x3 diagonal blocks of J^T*J+miu*I, i.e. one per vertex in xyzxyz... arrangements
+        };
+
+        //A matrix-free preconditioned conjugate gradient linear solver for the LM/GN/SL solvers. It applies J^T*J+miu*I to a vector by one product with J and one with J^T, directly from the (JRows, JCols, JVals) of the traits, so the memory is linear in the nonzeros of J and there is no fill-in.
+        //Solving the system inexactly is usually enough for the outer solver: with isInexact, CG stops at the relative residual min(maxForcing, sqrt(|rhs|)) that makes the outer (inexact) Newton iterations converge superlinearly. Otherwise it stops at relTolerance.
+        class MatrixFreeCGWrapper{
+        public:
+            CGPreconditionerTypes preconditioner;
+            bool isInexact;
+            double maxForcing;       //upper bound on the relative residual in the inexact mode
+            double relTolerance;     //relative residual in the exact mode
+            int maxIterations;       //of CG per right-hand side
+            int numThreads;          //for the preconditioner and the products with J and J^T (1 by default)
+
+            int lastIterations;      //CG iterations of the last solve(), summed over the right-hand sides
+            double lastRelResidual;  //the largest relative residual of the last solve()
+
+            Eigen::VectorXi JRows, JCols;
+            Eigen::VectorXd JVals;
+            double miu;
+            int numRows, numCols;
+            Eigen::VectorXi rowStart, rowPerm;   //row gather pattern for J*v
+            Eigen::VectorXi colStart, colPerm;   //column gather pattern for J^T*v
+
+            //the preconditioner: JACOBI uses invDiag, BLOCK_JACOBI uses invBlocks for the first 3*numBlocks columns, and invDiag for the rest.
+            Eigen::VectorXd invDiag;
+            Eigen::MatrixXd invBlocks;           //3*numBlocks by 3 inverses of the diagonal blocks
+            Eigen::MatrixXi blockPairs;          //(i,j,slot): entries i and j of J in the same row and block add J_i*J_j to entry slot in [0,9) of the block of column JCols(i)
+            Eigen::VectorXi blockStart;          //offsets into blockPairs of the pairs of every block
+            int numBlocks;
+
+            MatrixFreeCGWrapper(const CGPreconditionerTypes _preconditioner=BLOCK_JACOBI,
+                                const bool _isInexact=true):
+            preconditioner(_preconditioner),
+            isInexact(_isInexact),
+            maxForcing(0.5),
+            relTolerance(10e-10),
+            maxIterations(1000),
+            numThreads(1),
+            lastIterations(0),
+            lastRelResidual(0.0),
+            miu(0.0),
+            numRows(0),
+            numCols(0),
+            numBlocks(0){}
+
+            //setting up the products with J of (_JRows, _JCols) pattern, which is constant throughout the optimization
+            bool analyze_jacobian(const Eigen::VectorXi& _JRows,
+                                  const Eigen::VectorXi& _JCols,
+                                  const int xSize){
+                JRows=_JRows;
+                JCols=_JCols;
+                numRows=(JRows.size()==0 ? 0 : JRows.maxCoeff()+1);
+                numCols=xSize;
+                adjoint_gather_pattern(JRows, numRows, rowStart, rowPerm);
+                adjoint_gather_pattern(JCols, numCols, colStart, colPerm);
+
+                if (preconditioner==BLOCK_JACOBI){
+                    numBlocks=numCols/3;
+                    std::vector<int> pairs;
+                    std::vector<int> pairBlocks;
+                    for (int r=0;r<numRows;r++){
+                        for (int k1=rowStart(r);k1<rowStart(r+1);k1++){
+                            int i=rowPerm(k1);
+                            if (JCols(i)>=3*numBlocks)
+                                continue;
+                            for (int k2=rowStart(r);k2<rowStart(r+1);k2++){
+                                int j=rowPerm(k2);
+                                if ((JCols(j)>=3*numBlocks)||(JCols(i)/3!=JCols(j)/3))
+                                    continue;
+                                pairs.push_back(i);
+                                pairs.push_back(j);
+                                pairs.push_back(3*(JCols(i)%3)+JCols(j)%3);
+                                pairBlocks.push_back(JCols(i)/3);
+                            }
+                        }
+                    }
+
+                    //grouping the pairs by blocks, so the blocks are computed in parallel without conflicts
+                    const int numPairs=(int)pairBlocks.size();
+                    blockStart=Eigen::VectorXi::Zero(numBlocks+1);
+                    for (int p=0;p<numPairs;p++)
+                        blockStart(pairBlocks[p]+1)++;
+                    for (int b=0;b<numBlocks;b++)
+                        blockStart(b+1)+=blockStart(b);
+                    Eigen::VectorXi currPos=blockStart.head(numBlocks);
+                    blockPairs.resize(numPairs,3);
+                    for (int p=0;p<numPairs;p++)
+                        blockPairs.row(currPos(pairBlocks[p])++)<<pairs[3*p], pairs[3*p+1], pairs[3*p+2];
+                    invBlocks.resize(3*numBlocks,3);
+                } else
+                    numBlocks=0;
+
+                return true;
+            }
+
+            //"factorization" only stores the values and builds the preconditioner of J^T*J+miu*I
+            bool factorize_jacobian(const Eigen::VectorXd& _JVals,
+                                    const double _miu){
+                JVals=_JVals;
+                miu=_miu;
+
+                invDiag.resize(numCols);
+                hedra::parallel_for(numCols, [&](const int begin, const int end, const int threadIndex){
+                    for (int c=begin;c<end;c++){
+                        double diag=miu;
+                        for (int k=colStart(c);k<colStart(c+1);k++)
+                            diag+=JVals(colPerm(k))*JVals(colPerm(k));
+                        invDiag(c)=(diag > 0.0 ? 1.0/diag : 1.0);  //unused variables are left as they are
+                    }
+                }, numThreads);
+
+                hedra::parallel_for(numBlocks, [&](const int begin, const int end, const int threadIndex){
+                    for (int b=begin;b<end;b++){
+                        Eigen::Matrix3d block=miu*Eigen::Matrix3d::Identity();
+                        for (int p=blockStart(b);p<blockStart(b+1);p++)
+                            block(blockPairs(p,2)/3, blockPairs(p,2)%3)+=JVals(blockPairs(p,0))*JVals(blockPairs(p,1));
+
+                        Eigen::Matrix3d invBlock;
+                        bool isInvertible;
+                        block.computeInverseWithCheck(invBlock, isInvertible);
+                        if (!isInvertible){  //falling back to Jacobi for rank-deficient blocks
+                            invBlock.setZero();
+                            for (int k=0;k<3;k++)
+                                invBlock(k,k)=invDiag(3*b+k);
+                        }
+                        invBlocks.block(3*b,0,3,3)=invBlock;
+                    }
+                }, numThreads);
+
+                return true;
+            }
+
+            //out=(J^T*J+miu*I)*v
+            void multiply(const Eigen::VectorXd& v,
+                          Eigen::VectorXd& Jv,
+                          Eigen::VectorXd& out){
+                multiply_adjoint_vector(JCols, JVals, v, rowStart, rowPerm, numThreads, Jv);
+                multiply_adjoint_vector(JRows, JVals, Jv, colStart, colPerm, numThreads, out);
+                out+=miu*v;
+            }
+
+            void precondition(const Eigen::VectorXd& r,
+                              Eigen::VectorXd& z){
+                hedra::parallel_for(numCols, [&](const int begin, const int end, const int threadIndex){
+                    for (int c=begin;c<end;c++){
+                        if (c<3*numBlocks)
+                            z(c)=invBlocks.row(c).dot(r.segment(3*(c/3),3));
+                        else
+                            z(c)=invDiag(c)*r(c);
+                    }
+                }, numThreads);
+            }
+
+            bool solve(const Eigen::MatrixXd& rhs,
+                       Eigen::MatrixXd& x){
+                using namespace Eigen;
+                x.conservativeResize(numCols, rhs.cols());
+                lastIterations=0;
+                lastRelResidual=0.0;
+                bool converged=true;
+                VectorXd r(numCols), z(numCols), p(numCols), Ap(numCols), Jv(numRows), xi(numCols);
+                for (int i=0;i<rhs.cols();i++){
+                    double bNorm=rhs.col(i).norm();
+                    xi.setZero();
+                    if (bNorm==0.0){
+                        x.col(i)=xi;
+                        continue;
+                    }
+
+                    double tolerance=(isInexact ? std::min(maxForcing, std::sqrt(bNorm)) : relTolerance)*bNorm;
+                    r=rhs.col(i);
+                    precondition(r,z);
+                    p=z;
+                    double rz=r.dot(z);
+                    double rNorm=bNorm;
+                    int currIter=0;
+                    while ((rNorm>tolerance)&&(currIter<maxIterations)){
+                        multiply(p, Jv, Ap);
+                        double pAp=p.dot(Ap);
+                        if (pAp<=0.0)  //J^T*J is only semi-definite without miu
+                            break;
+                        double alpha=rz/pAp;
+                        xi+=alpha*p;
+                        r-=alpha*Ap;
+                        rNorm=r.norm();
+                        precondition(r,z);
+                        double prevrz=rz;
+                        rz=r.dot(z);
+                        p=z+(rz/prevrz)*p;
+                        currIter++;
+                    }
+
+                    x.col(i)=xi;
+                    lastIterations+=currIter;
+                    lastRelResidual=std::max(lastRelResidual, rNorm/bNorm);
+                    converged=converged&&(rNorm<=tolerance);
+                }
+                return converged;
+            }
+        };
+
+        template<>
+        struct is_matrix_free<MatrixFreeCGWrapper> : std::true_type {};
+
+    }
+}
+
+
+#endif
@@ -9,6 +9,7 @@
 #define HEDRA_MOEBIUS_2D_EDGE_DEVIATION_TRAITS_H
 #include <igl/igl_inline.h>
 #include <Eigen/Core>
+#include <hedra/incremental_traits.h>
 #include <string>
 #include <vector>
 #include <cstdio>
@@ -56,10 +57,8 @@ namespace hedra { namespace optimization {
     Eigen::VectorXcd currPositions;
     Eigen::VectorXcd currE;    //edge deviations
     Eigen::VectorXcd currEdges;
-    Eigen::VectorXcd AMAPVec;
     Eigen::VectorXcd mobVec;
     Eigen::VectorXcd posVec;
-    Eigen::VectorXcd rigidVec;
     //Eigen::VectorXcd closeVec;
     Eigen::VectorXcd deviationVec;
     Eigen::VectorXcd origFCR;
@@ -89,6 +88,13 @@ namespace hedra { namespace optimization {
     
     Eigen::VectorXcd constVec;
     
+    //for partial updates (see incremental_traits.h)
+    Eigen::VectorXi varRowStart, varRows;  //the (real) residuals of every variable
+    std::vector<char> rowMarks;
+    std::vector<int> dirtyRows;
+    double energySmoothFactor, energyRigidFactor, energyPosFactor;        //the weights in the current EVec (0 before the first update)
+    double jacobianSmoothFactor, jacobianRigidFactor, jacobianPosFactor;  //the weights in the current JVals
+    
     void init(const Eigen::VectorXcd& _origVc,
               const Eigen::MatrixXi& _D,
               const Eigen::MatrixXi& _F,
@@ -128,8 +134,6 @@ namespace hedra { namespace optimization {
       d0.setFromTriplets(d0Tris.begin(), d0Tris.end());
       
       //Allocating intermediate and output vectors
-      AMAPVec.conservativeResize(EV.rows());
-      rigidVec.conservativeResize(EV.rows());
       posVec.conservativeResize(constIndices.size());
       //closeVec.conservativeResize(xSize/2);
       mobVec.conservativeResize(D.sum()-3*D.rows());
@@ -166,9 +170,9 @@ namespace hedra { namespace optimization {
       }
       
       if (!isExactDC && !isExactIAP)
-        EVec.conservativeResize(2*(AMAPVec.size()+rigidVec.size()+/*closeVec.size()+*/posVec.size()+mobVec.size()));
+        EVec.conservativeResize(2*(EV.rows()+EV.rows()+/*closeVec.size()+*/posVec.size()+mobVec.size()));
       else
-        EVec.conservativeResize(2*(AMAPVec.size()+rigidVec.size()+/*closeVec.size()+*/posVec.size()+mobVec.size()+deviationVec.size())+DCVec.size()+IAPVec.size());
+        EVec.conservativeResize(2*(EV.rows()+EV.rows()+/*closeVec.size()+*/posVec.size()+mobVec.size()+deviationVec.size())+DCVec.size()+IAPVec.size());
       
       
       if (!isExactDC && !isExactIAP)
@@ -346,6 +350,11 @@ namespace hedra { namespace optimization {
       }
       
       
+      variable_residual_adjacency(JRows, JCols, xSize, varRowStart, varRows);
+      rowMarks.assign(EVec.size(),0);
+      energySmoothFactor=energyRigidFactor=energyPosFactor=0.0;
+      jacobianSmoothFactor=jacobianRigidFactor=jacobianPosFactor=0.0;
+      
       //calibrating initSolution
       finalPositions.conservativeResize(origVc.rows());
       finalY.conservativeResize(origVc.rows());
@@ -364,57 +373,24 @@ namespace hedra { namespace optimization {
     
     void update_energy(const Eigen::VectorXd& x){
       
-      using namespace Eigen;
-      using namespace std;
-      
-      currSolution.array().real()<<x.head(x.size()/2);
-      currSolution.array().imag()<<x.tail(x.size()/2);
-      
-      currY<<currSolution.head(origVc.rows());
-      currPositions<<currSolution.segment(origVc.rows(),origVc.rows());
-      
-      for (int i=0;i<EV.rows();i++)
-        AMAPVec(i)=(currY(EV(i,0))*(origVc(EV(i,1))-origVc(EV(i,0)))*currY(EV(i,1))-(currPositions(EV(i,1))-currPositions(EV(i,0))));
-      
-      rigidVec<<d0*currY;
-      //closeVec<<(currSolution-initSolution);
-      
+      set_current_solution(x);
       update_constraints(x);
       
-      if (mobVec.size()!=0){
-        if (!isExactDC && !isExactIAP)
-          EVec<<smoothFactor*AMAPVec.real(), smoothFactor*rigidityFactor*rigidVec.real(), /*closeFactor*closeVec.real(),*/ posFactor*posVec.real(), mobVec.real(),
-          smoothFactor*AMAPVec.imag(), smoothFactor*rigidityFactor*rigidVec.imag(), /*closeFactor*closeVec.imag(), */posFactor*posVec.imag(), mobVec.imag();
-        
-        else{
-          if (isExactDC){
-            EVec<<smoothFactor*AMAPVec.real(), smoothFactor*rigidityFactor*rigidVec.real(), /*closeFactor*closeVec.real(), */posFactor*posVec.real(), mobVec.real(), deviationVec.real(),
-            smoothFactor*AMAPVec.imag(), smoothFactor*rigidityFactor*rigidVec.imag(), /*closeFactor*closeVec.imag(),*/ posFactor*posVec.imag(), mobVec.imag(), deviationVec.imag(),DCVec;
-            
-          }else if (isExactIAP){
-            EVec<<smoothFactor*AMAPVec.real(), smoothFactor*rigidityFactor*rigidVec.real(), /*closeFactor*closeVec.real(),*/ posFactor*posVec.real(), mobVec.real(), deviationVec.real(),
-            smoothFactor*AMAPVec.imag(), smoothFactor*rigidityFactor*rigidVec.imag(), /*closeFactor*closeVec.imag(),*/ posFactor*posVec.imag(), mobVec.imag(), deviationVec.imag(),IAPVec;
-          }
-        }
-      } else {
-        if (!isExactDC && !isExactIAP)
-          EVec<<smoothFactor*AMAPVec.real(), smoothFactor*rigidityFactor*rigidVec.real(), /*closeFactor*closeVec.real(),*/ posFactor*posVec.real(),
-          smoothFactor*AMAPVec.imag(), smoothFactor*rigidityFactor*rigidVec.imag(), /*closeFactor*closeVec.imag(), */posFactor*posVec.imag();
-        
-        else{
-          if (isExactDC){
-            EVec<<smoothFactor*AMAPVec.real(), smoothFactor*rigidityFactor*rigidVec.real(), /*closeFactor*closeVec.real(),*/ posFactor*posVec.real(), deviationVec.real(),
-            smoothFactor*AMAPVec.imag(), smoothFactor*rigidityFactor*rigidVec.imag(), /*closeFactor*closeVec.imag(),*/ posFactor*posVec.imag(), deviationVec.imag(),DCVec;
-            
-          }else if (isExactIAP){
-            EVec<<smoothFactor*AMAPVec.real(), smoothFactor*rigidityFactor*rigidVec.real(), /*closeFactor*closeVec.real(), */posFactor*posVec.real(), deviationVec.real(),
-            smoothFactor*AMAPVec.imag(), smoothFactor*rigidityFactor*rigidVec.imag(), /*closeFactor*closeVec.imag(), */posFactor*posVec.imag(), deviationVec.imag(),IAPVec;
-          }
-        }
-        
-      }
+      energySmoothFactor=smoothFactor;
+      energyRigidFactor=smoothFactor*rigidityFactor;
+      energyPosFactor=posFactor;
       
+      //the real parts of the complex residuals, then their imaginary parts, and then the DC\IAP residuals
+      for (int r=0;r<complexRowOffset;r++){
+        Complex residual=complex_residual(r);
+        EVec(r)=residual.real();
+        EVec(complexRowOffset+r)=residual.imag();
+      }
       
+      if (isExactDC)
+        EVec.tail(DCVec.size())=DCVec;
+      else if (isExactIAP)
+        EVec.tail(IAPVec.size())=IAPVec;
     }
     
     void update_constraints(const Eigen::VectorXd& x)
@@ -476,111 +452,208 @@ namespace hedra { namespace optimization {
     
     void update_jacobian(const Eigen::VectorXd& x){
       
-      using namespace Eigen;
-      using namespace std;
+      set_current_solution(x);
+      
+      int first, num;
+      for (int r=0;r<complexRowOffset;r++)
+        complex_jacobian_row(r, first, num);
+      
+      //updating real values from complex ones
+      update_real_jacobian(0, complexJRows.size());
       
+      /*************************Metric-Conformal and Intersection-Angle Preserving Constraints********************************/
+      if (isExactDC){
+        for (int i=0;i<EV.rows();i++){
+          JVals(DCTriOffset+2*i)=2.0*currE(i).real();
+          JVals(DCTriOffset+2*i+1)=2.0*currE(i).imag();
+          
+        }
+      }
+      
+      //IAP constraint jacobian are constant
+      
+      jacobianSmoothFactor=smoothFactor;
+      jacobianRigidFactor=smoothFactor*rigidityFactor;
+      jacobianPosFactor=posFactor;
+    }
+    
+    //[Real -imag; imag real] values of complex Jacobian values first..first+num-1
+    void update_real_jacobian(const int first, const int num){
+      for (int i=first;i<first+num;i++){
+        JVals(2*i)=   complexJVals(i).real();
+        JVals(2*i+1)=-complexJVals(i).imag();
+        JVals(2*i+2*complexJRows.size())= complexJVals(i).imag();
+        JVals(2*i+1+2*complexJRows.size())= complexJVals(i).real();
+      }
+    }
+    
+    /*************************Residuals and Jacobian rows, for the full and the partial updates (see incremental_traits.h)********************************/
+    //The real residual r<complexRowOffset and complexRowOffset+r are the real and imaginary parts of complex residual r, and depend on the same variables; the rest are the DC\IAP residuals.
+    //Partial updates only update EVec and JVals; the constraint vectors (posVec, mobVec, constVec etc.) are those of the last full update.
+    
+    void set_current_solution(const Eigen::VectorXd& x){
       currSolution.array().real()<<x.head(x.size()/2);
       currSolution.array().imag()<<x.tail(x.size()/2);
       
       currY<<currSolution.head(origVc.rows());
       currPositions<<currSolution.segment(origVc.rows(),origVc.rows());
-      
-      /*********************AMAPEnergy**********************/
-      for (int i=0;i<EV.rows();i++){
-        //Yi Derivative
-        complexJVals(4*i)=smoothFactor*currY(EV(i,1))*(origVc(EV(i,1))-origVc(EV(i,0)));
-        //Yj Derivative
-        complexJVals(4*i+1)=smoothFactor*currY(EV(i,0))*(origVc(EV(i,1))-origVc(EV(i,0)));
-        //wi derivative
-        complexJVals(4*i+2)=smoothFactor;
-        //wj derivative
-        complexJVals(4*i+3)=-smoothFactor;
+      if (isExactDC || isExactIAP)
+        currE<<currSolution.segment(origVc.rows()+origVc.rows(),EV.rows());
+    }
+    
+    //the vertices of the cross ratio of Moebius-equivalent constraint m
+    void mobius_vertices(const int m, int& vi, int& vj, int& vk, int& vl){
+      vi=complexJCols(mobTriOffset+4*m)-origVc.rows();
+      vj=complexJCols(mobTriOffset+4*m+1)-origVc.rows();
+      vk=complexJCols(mobTriOffset+4*m+2)-origVc.rows();
+      vl=complexJCols(mobTriOffset+4*m+3)-origVc.rows();
+    }
+    
+    //the weighted complex residual r for the current solution, as in update_energy()
+    Complex complex_residual(const int r){
+      if (r<rigidRowOffset){
+        int i=r-AMAPRowOffset;
+        return smoothFactor*(currY(EV(i,0))*(origVc(EV(i,1))-origVc(EV(i,0)))*currY(EV(i,1))-(currPositions(EV(i,1))-currPositions(EV(i,0))));
       }
-      
-      /*******************Rigidity Energy******************/
-      
-      for (int i=0;i<EV.rows();i++){
-        //Yi derivative
-        complexJVals(rigidTriOffset+2*i)=-smoothFactor*rigidityFactor;
-        //Yj derivative
-        complexJVals(rigidTriOffset+2*i+1)=smoothFactor*rigidityFactor;
+      if (r<posRowOffset){
+        int i=r-rigidRowOffset;
+        return smoothFactor*rigidityFactor*(currY(EV(i,1))-currY(EV(i,0)));
+      }
+      if (r<mobRowOffset){
+        int i=r-posRowOffset;
+        return posFactor*(currPositions(constIndices(i))-complexConstPoses(i));
+      }
+      if (r<mobRowOffset+origFCR.size()){
+        int m=r-mobRowOffset, vi, vj, vk, vl;
+        mobius_vertices(m, vi, vj, vk, vl);
+        Complex wi=currPositions(vi), wj=currPositions(vj), wk=currPositions(vk), wl=currPositions(vl);
+        return (wj-wi)*(wl-wk)-origFCR(m)*(wi-wl)*(wk-wj);
+      }
+      int i=r-deviationRowOffset;
+      return currY(EV(i,0))*(origVc(EV(i,1))-origVc(EV(i,0)))*currY(EV(i,1))-currE(i)*(currPositions(EV(i,1))-currPositions(EV(i,0)));
+    }
+    
+    //the complex Jacobian values of complex residual r for the current solution, as in update_jacobian(); returns their range in complexJVals
+    void complex_jacobian_row(const int r, int& first, int& num){
+      if (r<rigidRowOffset){
+        int i=r-AMAPRowOffset;
+        first=AMAPTriOffset+4*i; num=4;
+        complexJVals(first)=smoothFactor*currY(EV(i,1))*(origVc(EV(i,1))-origVc(EV(i,0)));
+        complexJVals(first+1)=smoothFactor*currY(EV(i,0))*(origVc(EV(i,1))-origVc(EV(i,0)));
+        complexJVals(first+2)=smoothFactor;
+        complexJVals(first+3)=-smoothFactor;
+      } else if (r<posRowOffset){
+        int i=r-rigidRowOffset;
+        first=rigidTriOffset+2*i; num=2;
+        complexJVals(first)=-smoothFactor*rigidityFactor;
+        complexJVals(first+1)=smoothFactor*rigidityFactor;
+      } else if (r<mobRowOffset){
+        first=posTriOffset+r-posRowOffset; num=1;
+        complexJVals(first)=posFactor;
+      } else if (r<mobRowOffset+origFCR.size()){
+        int m=r-mobRowOffset, vi, vj, vk, vl;
+        mobius_vertices(m, vi, vj, vk, vl);
+        Complex wi=currPositions(vi), wj=currPositions(vj), wk=currPositions(vk), wl=currPositions(vl);
+        first=mobTriOffset+4*m; num=4;
+        complexJVals(first)=-(wl-wk)-origFCR(m)*(wk-wj);
+        complexJVals(first+1)=(wl-wk)+origFCR(m)*(wi-wl);
+        complexJVals(first+2)=-(wj-wi)-origFCR(m)*(wi-wl);
+        complexJVals(first+3)=(wj-wi)+origFCR(m)*(wk-wj);
+      } else {
+        int i=r-deviationRowOffset;
+        first=deviationTriOffset+5*i; num=5;
+        complexJVals(first)=currY(EV(i,1))*(origVc(EV(i,1))-origVc(EV(i,0)));
+        complexJVals(first+1)=currY(EV(i,0))*(origVc(EV(i,1))-origVc(EV(i,0)));
+        complexJVals(first+2)=currE(i);
+        complexJVals(first+3)=-currE(i);
+        complexJVals(first+4)=-(currPositions(EV(i,1))-currPositions(EV(i,0)));
+      }
+    }
+    
+    void update_energy(const Eigen::VectorXd& x, const Eigen::VectorXi& changedVariables){
+      if ((energySmoothFactor==0.0)||(energyRigidFactor==0.0)||(energyPosFactor==0.0)){
+        update_energy(x);
+        return;
       }
       
-      //Closeness gradient is constant
+      set_current_solution(x);
       
-      /********************Positional soft Constraints**************************/
-      for (int i=0;i<constIndices.size();i++){
-        complexJVals(posTriOffset+i)=posFactor;
+      //rescaling the residuals whose weights changed since (smoothFactor is reduced in every post_iteration())
+      if (smoothFactor!=energySmoothFactor){
+        EVec.segment(AMAPRowOffset,EV.rows())*=smoothFactor/energySmoothFactor;
+        EVec.segment(complexRowOffset+AMAPRowOffset,EV.rows())*=smoothFactor/energySmoothFactor;
+        energySmoothFactor=smoothFactor;
+      }
+      if (smoothFactor*rigidityFactor!=energyRigidFactor){
+        EVec.segment(rigidRowOffset,EV.rows())*=smoothFactor*rigidityFactor/energyRigidFactor;
+        EVec.segment(complexRowOffset+rigidRowOffset,EV.rows())*=smoothFactor*rigidityFactor/energyRigidFactor;
+        energyRigidFactor=smoothFactor*rigidityFactor;
+      }
+      if (posFactor!=energyPosFactor){
+        EVec.segment(posRowOffset,constIndices.size())*=posFactor/energyPosFactor;
+        EVec.segment(complexRowOffset+posRowOffset,constIndices.size())*=posFactor/energyPosFactor;
+        energyPosFactor=posFactor;
       }
       
-      /*****************Mobius-Equivalent Constraints********/
-      
-      //the actual values are updated in the gradient
-      int mobCounter=0;
-      for (int i=0;i<D.rows();i++){
-        for (int j=0;j<D(i)-3;j++){
-          Complex wi=currPositions(F(i,j));
-          Complex wj=currPositions(F(i,j+1));
-          Complex wk=currPositions(F(i,j+2));
-          Complex wl=currPositions(F(i,j+3));
-          //MobVec(Counter++)=(Zj-Zi)*(Zl-Zk)-FCR(MobCounter)*(Zi-Zl)*(Zk-Zj);
-          
-          //wi derivative
-          complexJVals(mobTriOffset+4*mobCounter)=-(wl-wk)-origFCR(mobCounter)*(wk-wj);
-          //wj derivative
-          complexJVals(mobTriOffset+4*mobCounter+1)=(wl-wk)+origFCR(mobCounter)*(wi-wl);
-          //wk derivative
-          complexJVals(mobTriOffset+4*mobCounter+2)=-(wj-wi)-origFCR(mobCounter)*(wi-wl);
-          //wl derivative
-          complexJVals(mobTriOffset+4*mobCounter+3)=(wj-wi)+origFCR(mobCounter)*(wk-wj);
-          
-          mobCounter++;
-          
+      dirty_residuals(changedVariables, varRowStart, varRows, rowMarks, dirtyRows);
+      for (size_t i=0;i<dirtyRows.size();i++){
+        int r=dirtyRows[i];
+        if (r<complexRowOffset){
+          Complex residual=complex_residual(r);
+          EVec(r)=residual.real();
+          EVec(complexRowOffset+r)=residual.imag();
+        } else if (r>=2*complexRowOffset){
+          int e=r-2*complexRowOffset;
+          EVec(r)=(isExactDC ? std::norm(currE(e))-1.0 : currE(e).imag());
         }
       }
+    }
+    
+    void update_jacobian(const Eigen::VectorXd& x, const Eigen::VectorXi& changedVariables){
+      if ((jacobianSmoothFactor==0.0)||(jacobianRigidFactor==0.0)||(jacobianPosFactor==0.0)){
+        update_jacobian(x);
+        return;
+      }
       
+      set_current_solution(x);
       
-      if (isExactDC || isExactIAP){
-        /*****************Deviation constraints***************/
-        currE<<currSolution.segment(origVc.rows()+origVc.rows(),EV.rows());
+      //rescaling the values whose weights changed since; all real values are then updated
+      bool isRescaled=false;
+      if (smoothFactor!=jacobianSmoothFactor){
+        complexJVals.segment(AMAPTriOffset,4*EV.rows())*=smoothFactor/jacobianSmoothFactor;
+        jacobianSmoothFactor=smoothFactor;
+        isRescaled=true;
+      }
+      if (smoothFactor*rigidityFactor!=jacobianRigidFactor){
         for (int i=0;i<EV.rows();i++){
-          //Yi derivative
-          complexJVals(deviationTriOffset+5*i)=currY(EV(i,1))*(origVc(EV(i,1))-origVc(EV(i,0)));
-          //Yj derivative
-          complexJVals(deviationTriOffset+5*i+1)=currY(EV(i,0))*(origVc(EV(i,1))-origVc(EV(i,0)));
-          
-          //wi derivative
-          complexJVals(deviationTriOffset+5*i+2)=currE(i);
-          
-          //wj derivative
-          complexJVals(deviationTriOffset+5*i+3)=-currE(i);
-          
-          //E_ij derivatve
-          complexJVals(deviationTriOffset+5*i+4)=-(currPositions(EV(i,1))-currPositions(EV(i,0)));
+          complexJVals(rigidTriOffset+2*i)=-smoothFactor*rigidityFactor;
+          complexJVals(rigidTriOffset+2*i+1)=smoothFactor*rigidityFactor;
         }
+        jacobianRigidFactor=smoothFactor*rigidityFactor;
+        isRescaled=true;
       }
-      
-      //updating real values from complex ones
-      for (int i=0;i<complexJRows.size();i++){
-        JVals(2*i)=   complexJVals(i).real();
-        JVals(2*i+1)=-complexJVals(i).imag();
-        JVals(2*i+2*complexJRows.size())= complexJVals(i).imag();
-        JVals(2*i+1+2*complexJRows.size())= complexJVals(i).real();
+      if (posFactor!=jacobianPosFactor){
+        complexJVals.segment(posTriOffset,constIndices.size()).setConstant(posFactor);
+        jacobianPosFactor=posFactor;
+        isRescaled=true;
       }
       
-      
-      
-      /*************************Metric-Conformal and Intersection-Angle Preserving Constraints********************************/
-      if (isExactDC){
-        for (int i=0;i<EV.rows();i++){
-          JVals(DCTriOffset+2*i)=2.0*currE(i).real();
-          JVals(DCTriOffset+2*i+1)=2.0*currE(i).imag();
-          
+      dirty_residuals(changedVariables, varRowStart, varRows, rowMarks, dirtyRows);
+      for (size_t i=0;i<dirtyRows.size();i++){
+        int r=dirtyRows[i];
+        if (r<complexRowOffset){
+          int first, num;
+          complex_jacobian_row(r, first, num);
+          if (!isRescaled)
+            update_real_jacobian(first, num);
+        } else if ((r>=2*complexRowOffset)&&(isExactDC)){
+          int e=r-2*complexRowOffset;
+          JVals(DCTriOffset+2*e)=2.0*currE(e).real();
+          JVals(DCTriOffset+2*e+1)=2.0*currE(e).imag();
         }
       }
-      
-      //IAP constraint jacobian are constant
-      
+      if (isRescaled)
+        update_real_jacobian(0, complexJRows.size());
     }
     
     void initial_solution(Eigen::VectorXd& x0){
@@ -635,6 +708,8 @@ namespace hedra { namespace optimization {
     ~Moebius2DEdgeDeviationTraits(){}
   };
   
+  template<> struct is_incremental<Moebius2DEdgeDeviationTraits> : std::true_type {};
+  
 }}
 
 
@@ -0,0 +1,324 @@
+// This file is part of libhedra, a library for polygonal mesh processing
+//
+// Copyright (C) 2018 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+#ifndef HEDRA_MOEBIUS_REGULAR_TRAITS_H
+#define HEDRA_MOEBIUS_REGULAR_TRAITS_H
+#include <igl/igl_inline.h>
+#include <hedra/quaternionic_derivatives.h>
+#include <hedra/quaternionic_operations.h>
+#include <Eigen/Core>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+
+namespace hedra { namespace optimization {
+
+
+    //This traits class implements the "UnconstrainedTraits" concept for the Moebius regularity energy of moebius_regular_meshes.h, without Ceres: the residuals are those of CeresMRSolver (full cross ratios of the edge quads, length cross ratios of the face quads, and face normals of the triads), in the same variables (the positions, a cross-ratio vector per vertex and a normal per face).
+    //Ceres keeps the vectors on the unit sphere by a parameterization; here they are free, with a residual unitFactor*(|v|^2-1) for each, and are normalized in post_optimization().
+    //The Jacobian is analytic: every residual is a product of ratios of position differences, and the derivatives of a*X*b by X are those of quatDerivativeValues().
+    class MoebiusRegularTraits{
+    public:
+
+        //concept requirements
+        Eigen::VectorXi JRows, JCols;  //rows and column indices for the jacobian matrix
+        Eigen::VectorXd JVals;         //values for the jacobian matrix.
+        Eigen::VectorXd EVec;          //energy vector
+        Eigen::VectorXi JPerm;         //the place in JRows/JCols/JVals of every entry, in the order in which update_jacobian() computes them
+        int xSize;                     //size of the solution: 3*(#V-#handles) free positions, 3*#V cross-ratio vectors and 3*#F normals.
+
+        Eigen::MatrixXi quadVertexIndices;        //rows of wi,wj,wk,wl,... (the cross-ratio vector is of wi)
+        Eigen::MatrixXi quadFaceIndices;          //rows of wi,wj,wk,wl,...
+        Eigen::MatrixXi faceTriads;               //rows of wi,wj,wk,f (the normal is of f)
+        Eigen::VectorXi constIndices;
+        Eigen::VectorXi a2x;                      //the free position of every vertex in the solution, or -1 for the handles
+
+        //prescribed variables, as in CeresMRSolver
+        Eigen::VectorXd CRLengths;
+        Eigen::VectorXd CRAngles;    //arranged by quadVertexIndices
+        Eigen::VectorXd FNLengths;
+        Eigen::VectorXd FNAngles;    //arranged by faceTriads
+        Eigen::VectorXd faceCRLengths;
+
+        double CRFactor;
+        double FNFactor;
+        double unitFactor;
+
+        //the initial solution of every optimization, with the handles in positions, and its result afterwards
+        Eigen::MatrixXd positions;    //#V by 3
+        Eigen::MatrixXd crVectors;    //#V by 3
+        Eigen::MatrixXd normals;      //#F by 3
+
+        int numFreeVertices;
+        int CRVecOffset, FNVecOffset;   //of the cross-ratio vectors and the normals in the solution
+        int faceCRRowOffset, FNRowOffset, unitRowOffset;
+
+        //intermediate variables
+        Eigen::VectorXd derivatives;    //the 4x4 derivatives of a residual by the four differences of positions, row-major one after the other
+        Eigen::Vector4i rowSkips;
+
+        MoebiusRegularTraits():CRFactor(1.0), FNFactor(0.1), unitFactor(1.0){}
+
+        void init(const Eigen::MatrixXd& VOrig,
+                  const Eigen::MatrixXi& F,
+                  const Eigen::MatrixXi& _quadVertexIndices,
+                  const Eigen::MatrixXi& _quadFaceIndices,
+                  const Eigen::MatrixXi& _faceTriads,
+                  const Eigen::VectorXi& _constIndices)
+        {
+            using namespace Eigen;
+            using namespace std;
+
+            quadVertexIndices=_quadVertexIndices;
+            quadFaceIndices=_quadFaceIndices;
+            faceTriads=_faceTriads;
+            constIndices=_constIndices;
+
+            CRLengths.conservativeResize(quadVertexIndices.rows());
+            CRAngles.conservativeResize(quadVertexIndices.rows());
+            faceCRLengths.conservativeResize(quadFaceIndices.rows());
+            FNLengths.conservativeResize(faceTriads.rows());
+            FNAngles.conservativeResize(faceTriads.rows());
+
+            positions=VOrig;
+            crVectors.resize(VOrig.rows(),3);
+            normals.resize(F.rows(),3);
+
+            a2x=VectorXi::Zero(VOrig.rows());
+            for (int i=0;i<constIndices.size();i++)
+                a2x(constIndices(i))=-1;
+            numFreeVertices=0;
+            for (int i=0;i<VOrig.rows();i++)
+                if (a2x(i)!=-1)
+                    a2x(i)=numFreeVertices++;
+
+            CRVecOffset=3*numFreeVertices;
+            FNVecOffset=CRVecOffset+3*VOrig.rows();
+            xSize=FNVecOffset+3*F.rows();
+
+            faceCRRowOffset=4*quadVertexIndices.rows();
+            FNRowOffset=faceCRRowOffset+4*quadFaceIndices.rows();
+            unitRowOffset=FNRowOffset+4*faceTriads.rows();
+            EVec.resize(unitRowOffset+VOrig.rows()+F.rows());
+
+            derivatives.resize(64);
+            rowSkips<<0,4,8,12;
+
+            //the pattern, in the order in which update_jacobian() computes the values; the residual rows of a vertex recur with the next vertex, so it is sorted by rows below, as the solvers require
+            vector<int> rows, cols;
+            for (int i=0;i<quadVertexIndices.rows();i++){
+                for (int j=0;j<4;j++)
+                    add_position_pattern(4*i, quadVertexIndices(i,j), rows, cols);
+                add_vector_pattern(4*i, CRVecOffset+3*quadVertexIndices(i,0), rows, cols);
+            }
+
+            for (int i=0;i<quadFaceIndices.rows();i++)
+                for (int j=0;j<4;j++)
+                    add_position_pattern(faceCRRowOffset+4*i, quadFaceIndices(i,j), rows, cols);
+
+            for (int i=0;i<faceTriads.rows();i++){
+                for (int j=0;j<3;j++)
+                    add_position_pattern(FNRowOffset+4*i, faceTriads(i,j), rows, cols);
+                add_vector_pattern(FNRowOffset+4*i, FNVecOffset+3*faceTriads(i,3), rows, cols);
+            }
+
+            for (int i=0;i<VOrig.rows()+F.rows();i++)
+                for (int k=0;k<3;k++){
+                    rows.push_back(unitRowOffset+i);
+                    cols.push_back(CRVecOffset+3*i+k);
+                }
+
+            vector<int> order(rows.size());
+            for (size_t i=0;i<order.size();i++)
+                order[i]=(int)i;
+            std::stable_sort(order.begin(), order.end(), [&](const int a, const int b){return rows[a]<rows[b];});
+            JRows.resize(rows.size());
+            JCols.resize(cols.size());
+            JPerm.resize(rows.size());
+            for (size_t i=0;i<order.size();i++){
+                JRows(i)=rows[order[i]];
+                JCols(i)=cols[order[i]];
+                JPerm(order[i])=(int)i;
+            }
+            JVals.resize(JRows.size());
+        }
+
+        //the four rows of a residual by the position of a vertex, unless it is a handle
+        void add_position_pattern(const int row, const int vertex, std::vector<int>& rows, std::vector<int>& cols)
+        {
+            if (a2x(vertex)==-1)
+                return;
+            for (int r=0;r<4;r++)
+                for (int k=0;k<3;k++){
+                    rows.push_back(row+r);
+                    cols.push_back(3*a2x(vertex)+k);
+                }
+        }
+
+        //the imaginary rows of a residual by its own vector
+        void add_vector_pattern(const int row, const int col, std::vector<int>& rows, std::vector<int>& cols)
+        {
+            for (int k=0;k<3;k++){
+                rows.push_back(row+1+k);
+                cols.push_back(col+k);
+            }
+        }
+
+        //the position of a vertex as a pure quaternion, from the solution or from the handles
+        Eigen::RowVector4d vertex_quat(const Eigen::VectorXd& x, const int vertex) const
+        {
+            Eigen::RowVector4d q;
+            if (a2x(vertex)==-1)
+                q<<0.0, positions(vertex,0), positions(vertex,1), positions(vertex,2);
+            else
+                q<<0.0, x(3*a2x(vertex)), x(3*a2x(vertex)+1), x(3*a2x(vertex)+2);
+            return q;
+        }
+
+        //the derivatives of a residual by the position of a vertex, factor times the sum of the +/- derivatives (in "derivatives") by the differences of which it is the end or the start, without the real column of the pure quaternion.
+        void set_position_values(const int vertex, const int endDiff, const int startDiff, const double factor, int& currEntry)
+        {
+            if (a2x(vertex)==-1)
+                return;
+            for (int r=0;r<4;r++)
+                for (int k=0;k<3;k++)
+                    JVals(JPerm(currEntry++))=factor*(derivatives(16*endDiff+4*r+k+1)-derivatives(16*startDiff+4*r+k+1));
+        }
+
+        void initial_solution(Eigen::VectorXd& x0)
+        {
+            x0.resize(xSize);
+            for (int i=0;i<positions.rows();i++)
+                if (a2x(i)!=-1)
+                    x0.segment(3*a2x(i),3)=positions.row(i).transpose();
+
+            for (int i=0;i<crVectors.rows();i++)
+                x0.segment(CRVecOffset+3*i,3)=crVectors.row(i).transpose();
+
+            for (int i=0;i<normals.rows();i++)
+                x0.segment(FNVecOffset+3*i,3)=normals.row(i).transpose();
+        }
+
+        void pre_iteration(const Eigen::VectorXd& prevx){}
+        bool post_iteration(const Eigen::VectorXd& x){return false;}
+
+        void update_energy(const Eigen::VectorXd& x)
+        {
+            using namespace Eigen;
+
+            for (int i=0;i<quadVertexIndices.rows();i++){
+                RowVector4d qi=vertex_quat(x, quadVertexIndices(i,0));
+                RowVector4d qj=vertex_quat(x, quadVertexIndices(i,1));
+                RowVector4d qk=vertex_quat(x, quadVertexIndices(i,2));
+                RowVector4d ql=vertex_quat(x, quadVertexIndices(i,3));
+                RowVector4d cr; cr<<CRLengths(i)*cos(CRAngles(i)), CRLengths(i)*sin(CRAngles(i))*x.segment(CRVecOffset+3*quadVertexIndices(i,0),3).transpose();
+                EVec.segment(4*i,4)=CRFactor*(QMult(QMult(qj-qi, QInv(qk-qj)), QMult(ql-qk, QInv(qi-ql)))-cr).transpose();
+            }
+
+            for (int i=0;i<quadFaceIndices.rows();i++){
+                RowVector4d qi=vertex_quat(x, quadFaceIndices(i,0));
+                RowVector4d qj=vertex_quat(x, quadFaceIndices(i,1));
+                RowVector4d qk=vertex_quat(x, quadFaceIndices(i,2));
+                RowVector4d ql=vertex_quat(x, quadFaceIndices(i,3));
+                RowVector4d cr; cr<<-faceCRLengths(i), 0.0, 0.0, 0.0;
+                EVec.segment(faceCRRowOffset+4*i,4)=CRFactor*(QMult(QMult(qj-qi, QInv(qk-qj)), QMult(ql-qk, QInv(qi-ql)))-cr).transpose();
+            }
+
+            for (int i=0;i<faceTriads.rows();i++){
+                RowVector4d qi=vertex_quat(x, faceTriads(i,0));
+                RowVector4d qj=vertex_quat(x, faceTriads(i,1));
+                RowVector4d qk=vertex_quat(x, faceTriads(i,2));
+                RowVector4d fn; fn<<FNLengths(i)*cos(FNAngles(i)), FNLengths(i)*sin(FNAngles(i))*x.segment(FNVecOffset+3*faceTriads(i,3),3).transpose();
+                EVec.segment(FNRowOffset+4*i,4)=FNFactor*(QMult(qj-qi, QInv(qk-qj))-fn).transpose();
+            }
+
+            for (int i=0;i<EVec.size()-unitRowOffset;i++)
+                EVec(unitRowOffset+i)=unitFactor*(x.segment(CRVecOffset+3*i,3).squaredNorm()-1.0);
+        }
+
+        void update_jacobian(const Eigen::VectorXd& x)
+        {
+            using namespace Eigen;
+
+            RowVector4d unitQuat; unitQuat<<1.0, 0.0, 0.0, 0.0;
+            int currEntry=0;
+
+            //cross ratio (a*b^-1)*(c*d^-1) of the differences a=wj-wi, b=wk-wj, c=wl-wk and d=wi-wl. With P=a*b^-1 and Q=c*d^-1, the derivatives by a, b, c and d are of 1*X*(b^-1*Q), -P*X*(b^-1*Q), P*X*d^-1 and -PQ*X*d^-1 respectively.
+            //a vertex is the end of one difference and the start of the next, so wi gets d/dd-d/da, wj gets d/da-d/db, etc.
+            for (int i=0;i<quadVertexIndices.rows()+quadFaceIndices.rows();i++){
+                bool isFullCR=(i<quadVertexIndices.rows());
+                int quad=(isFullCR ? i : i-quadVertexIndices.rows());
+                const MatrixXi& quadIndices=(isFullCR ? quadVertexIndices : quadFaceIndices);
+                RowVector4d qi=vertex_quat(x, quadIndices(quad,0));
+                RowVector4d qj=vertex_quat(x, quadIndices(quad,1));
+                RowVector4d qk=vertex_quat(x, quadIndices(quad,2));
+                RowVector4d ql=vertex_quat(x, quadIndices(quad,3));
+
+                RowVector4d invb=QInv(qk-qj);
+                RowVector4d invd=QInv(qi-ql);
+                RowVector4d P=QMult(qj-qi, invb);
+                RowVector4d Q=QMult(ql-qk, invd);
+                RowVector4d invbQ=QMult(invb, Q);
+                quatDerivativeValues(derivatives, 0, rowSkips, unitQuat, invbQ, false, false);
+                quatDerivativeValues(derivatives, 16, rowSkips, -P, invbQ, false, false);
+                quatDerivativeValues(derivatives, 32, rowSkips, P, invd, false, false);
+                quatDerivativeValues(derivatives, 48, rowSkips, -QMult(P,Q), invd, false, false);
+
+                for (int j=0;j<4;j++)
+                    set_position_values(quadIndices(quad,j), (j+3)%4, j, CRFactor, currEntry);
+
+                if (isFullCR)
+                    for (int k=0;k<3;k++)
+                        JVals(JPerm(currEntry++))=-CRFactor*CRLengths(quad)*sin(CRAngles(quad));
+            }
+
+            //normal ratio a*b^-1, of which the derivatives by a and b are of 1*X*b^-1 and -P*X*b^-1.
+            for (int i=0;i<faceTriads.rows();i++){
+                RowVector4d qi=vertex_quat(x, faceTriads(i,0));
+                RowVector4d qj=vertex_quat(x, faceTriads(i,1));
+                RowVector4d qk=vertex_quat(x, faceTriads(i,2));
+
+                RowVector4d invb=QInv(qk-qj);
+                RowVector4d P=QMult(qj-qi, invb);
+                quatDerivativeValues(derivatives, 0, rowSkips, unitQuat, invb, false, false);
+                quatDerivativeValues(derivatives, 16, rowSkips, -P, invb, false, false);
+                derivatives.tail(32).setZero();
+
+                //wi is only the start of a, and wk only the end of b (the zero derivatives above stand for the missing differences)
+                set_position_values(faceTriads(i,0), 2, 0, FNFactor, currEntry);
+                set_position_values(faceTriads(i,1), 0, 1, FNFactor, currEntry);
+                set_position_values(faceTriads(i,2), 1, 2, FNFactor, currEntry);
+
+                for (int k=0;k<3;k++)
+                    JVals(JPerm(currEntry++))=-FNFactor*FNLengths(i)*sin(FNAngles(i));
+            }
+
+            for (int i=0;i<3*(EVec.size()-unitRowOffset);i++)
+                JVals(JPerm(currEntry++))=2.0*unitFactor*x(CRVecOffset+i);
+        }
+
+        bool post_optimization(const Eigen::VectorXd& x)
+        {
+            for (int i=0;i<positions.rows();i++)
+                if (a2x(i)!=-1)
+                    positions.row(i)=x.segment(3*a2x(i),3).transpose();
+
+            for (int i=0;i<crVectors.rows();i++)
+                crVectors.row(i)=x.segment(CRVecOffset+3*i,3).transpose().normalized();
+
+            for (int i=0;i<normals.rows();i++)
+                normals.row(i)=x.segment(FNVecOffset+3*i,3).transpose().normalized();
+
+            return true;
+        }
+    };
+
+} }
+
+
+#endif
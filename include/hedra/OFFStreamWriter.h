@@ -0,0 +1,182 @@
+// This file is part of libhedra, a library for polyhedral mesh processing
+//
+// Copyright (C) 2016 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+#ifndef HEDRA_OFF_STREAM_WRITER_H
+#define HEDRA_OFF_STREAM_WRITER_H
+#include <igl/igl_inline.h>
+#include <hedra/ascii_parsing.h>
+#include <Eigen/Core>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+
+namespace hedra
+{
+    // Writes an ascii OFF file incrementally: all vertices first, and then the faces, one by one or in blocks, as they are produced (e.g., by subdivision), so that a full mesh never needs to be held in memory.
+    // The text is formatted into a large buffer with format_int/format_double (see ascii_parsing.h), and written whenever the buffer is full.
+    // If the number of vertices and faces is not given to open(), a fixed-width header is written, and the counts are filled in by close().
+    class OFFStreamWriter{
+    public:
+        OFFStreamWriter():fileHandle(NULL), bufferUsed(0), numVertices(0), numFaces(0), expectedNumVertices(-1), expectedNumFaces(-1), success(false){}
+
+        ~OFFStreamWriter(){close();}
+
+        bool open(const std::string& fileName, const int _expectedNumVertices=-1, const int _expectedNumFaces=-1)
+        {
+            close();
+            fileHandle=std::fopen(fileName.c_str(), "wb");
+            if (fileHandle==NULL)
+                return false;
+            buffer.resize(1<<20);
+            bufferUsed=0;
+            numVertices=numFaces=0;
+            expectedNumVertices=_expectedNumVertices;
+            expectedNumFaces=_expectedNumFaces;
+            success=true;
+            write_header(expectedNumVertices, expectedNumFaces);
+            return true;
+        }
+
+        bool is_open() const {return fileHandle!=NULL;}
+        int num_vertices() const {return numVertices;}
+        int num_faces() const {return numFaces;}
+
+        bool write_vertex(const double x, const double y, const double z)
+        {
+            if (numFaces>0)  //vertices must all come before the faces
+                success=false;
+            if (!success)
+                return false;
+            reserve(3*(MAX_FORMATTED_NUMBER_LENGTH+1));
+            char* p=buffer.data()+bufferUsed;
+            p=format_double(p, x); *p++=' ';
+            p=format_double(p, y); *p++=' ';
+            p=format_double(p, z); *p++='\n';
+            bufferUsed=p-buffer.data();
+            numVertices++;
+            return true;
+        }
+
+        // V  #V by 3 vertex coordinates (any dense expression)
+        template<typename DerivedV>
+        bool write_vertices(const Eigen::MatrixBase<DerivedV>& V)
+        {
+            for (int i=0;i<V.rows();i++)
+                if (!write_vertex(V(i,0), V(i,1), V(i,2)))
+                    return false;
+            return true;
+        }
+
+        // writes a face with its vertex indices at vertices[0], vertices[stride],... (stride=F.rows() for a row of a column-major F)
+        bool write_face(const int degree, const int* vertices, const int stride=1)
+        {
+            if (!success)
+                return false;
+            reserve((degree+1)*(MAX_FORMATTED_NUMBER_LENGTH+1));
+            char* p=buffer.data()+bufferUsed;
+            p=format_int(p, degree);
+            for (int j=0;j<degree;j++){
+                *p++=' ';
+                p=format_int(p, vertices[j*stride]);
+            }
+            *p++='\n';
+            bufferUsed=p-buffer.data();
+            numFaces++;
+            return true;
+        }
+
+        // P  PolygonMesh, PolygonMeshMap or PaddedPolygons (see PolygonMesh.h)
+        template<class Polygons>
+        bool write_faces(const Polygons& P)
+        {
+            if (!success)
+                return false;
+            for (int f=0;f<P.num_faces();f++){
+                reserve((P.degree(f)+1)*(MAX_FORMATTED_NUMBER_LENGTH+1));
+                char* p=buffer.data()+bufferUsed;
+                p=format_int(p, P.degree(f));
+                for (int j=0;j<P.degree(f);j++){
+                    *p++=' ';
+                    p=format_int(p, P.vertex(f,j));
+                }
+                *p++='\n';
+                bufferUsed=p-buffer.data();
+                numFaces++;
+            }
+            return true;
+        }
+
+        // writes the rest of the buffer and the final counts. Returns false if any write failed, or if the counts differ from those given to open()
+        bool close()
+        {
+            if (fileHandle==NULL)
+                return false;
+            flush();
+            if ((expectedNumVertices<0)||(expectedNumFaces<0)){
+                if (std::fseek(fileHandle, 0, SEEK_SET)!=0)
+                    success=false;
+                write_header(numVertices, numFaces);
+                flush();
+            } else if ((expectedNumVertices!=numVertices)||(expectedNumFaces!=numFaces))
+                success=false;
+            if (std::fclose(fileHandle)!=0)
+                success=false;
+            fileHandle=NULL;
+            std::vector<char>().swap(buffer);
+            return success;
+        }
+
+    private:
+        FILE* fileHandle;
+        std::vector<char> buffer;
+        size_t bufferUsed;
+        int numVertices, numFaces;
+        int expectedNumVertices, expectedNumFaces;
+        bool success;
+
+        OFFStreamWriter(const OFFStreamWriter&);
+        OFFStreamWriter& operator=(const OFFStreamWriter&);
+
+        void flush()
+        {
+            if ((bufferUsed>0)&&(std::fwrite(buffer.data(), 1, bufferUsed, fileHandle)!=bufferUsed))
+                success=false;
+            bufferUsed=0;
+        }
+
+        void reserve(const size_t numBytes)
+        {
+            if (bufferUsed+numBytes>buffer.size()){
+                flush();
+                if (numBytes>buffer.size())
+                    buffer.resize(numBytes);
+            }
+        }
+
+        //with unknown (negative) counts, the header is padded to the width of any count, to be overwritten by close()
+        void write_header(const int headerNumVertices, const int headerNumFaces)
+        {
+            const bool isPadded=((expectedNumVertices<0)||(expectedNumFaces<0));
+            char* p=buffer.data()+bufferUsed;
+            *p++='O'; *p++='F'; *p++='F'; *p++='\n';
+            const int counts[2]={std::max(headerNumVertices,0), std::max(headerNumFaces,0)};
+            for (int k=0;k<2;k++){
+                char* countStart=p;
+                p=format_int(p, counts[k]);
+                while (isPadded&&(p-countStart<10))
+                    *p++=' ';
+                *p++=' ';
+            }
+            *p++='0'; *p++='\n';
+            bufferUsed=p-buffer.data();
+        }
+    };
+}
+
+
+#endif
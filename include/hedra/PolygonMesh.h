@@ -0,0 +1,126 @@
+// This file is part of libhedra, a library for polyhedral mesh processing
+//
+// Copyright (C) 2016 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+#ifndef HEDRA_POLYGON_MESH_H
+#define HEDRA_POLYGON_MESH_H
+#include <igl/igl_inline.h>
+#include <Eigen/Core>
+#include <vector>
+
+namespace hedra
+{
+    //Interchangeable views of the faces of a polygonal mesh, which the connectivity and per-face routines (polygonal_edge_topology, dcel, triangulate_mesh, planarity, polygonal_face_centers) accept as a template "Polygons" argument:
+    //
+    //  PolygonMesh       compressed (CSR) storage: the vertices of all faces one after the other, and the offset of every face. Memory and traversal scale with the actual number of corners sum(D).
+    //  PolygonMeshMap    the same CSR layout over external (e.g. memory-mapped) buffers.
+    //  PaddedPolygons    a zero-copy view of the usual (D,F) pair, where F is #F by max(D) and padded with -1.
+    //
+    //All provide num_faces(), degree(f), vertex(f,j), and corner(f,j): the linear index of the j-th corner of face f in "per-corner" data (e.g. FE, FEs and FH).
+    //Per-corner data has corner_rows() by corner_cols() entries: a #F by max(D) matrix for PaddedPolygons (exactly the legacy layout), and a sum(D) vector for PolygonMesh and PolygonMeshMap.
+    //
+    //The subdivision routines (vertex_insertion, catmull_clark and simplest_subdivision) also accept a PolygonMesh, but not without a copy: their subdivision data (OneRingSubdivisionData) is a virtual interface that keeps the coarse mesh as a padded (D,F), so the input is converted once with to_padded(). The fine mesh is written directly as a PolygonMesh.
+
+    class PolygonMesh{
+    public:
+        Eigen::VectorXi faceStart;      //#F+1 - offsets of the faces into faceVertices
+        Eigen::VectorXi faceVertices;   //sum(D) - vertex indices of the faces, face after face
+
+        PolygonMesh():faceStart(Eigen::VectorXi::Zero(1)){}
+
+        PolygonMesh(const Eigen::VectorXi& D, const Eigen::MatrixXi& F){from_padded(D,F);}
+
+        int num_faces() const {return faceStart.size()-1;}
+        int num_corners() const {return faceVertices.size();}
+        int degree(const int f) const {return faceStart(f+1)-faceStart(f);}
+        int vertex(const int f, const int j) const {return faceVertices(faceStart(f)+j);}
+        int corner(const int f, const int j) const {return faceStart(f)+j;}
+        int corner_rows() const {return faceVertices.size();}
+        int corner_cols() const {return 1;}
+
+        //the vertices of face f, without copying
+        Eigen::Map<const Eigen::VectorXi> face(const int f) const {return Eigen::Map<const Eigen::VectorXi>(faceVertices.data()+faceStart(f), degree(f));}
+
+        int max_degree() const{
+            int maxDegree=0;
+            for (int f=0;f<num_faces();f++)
+                maxDegree=(degree(f) > maxDegree ? degree(f) : maxDegree);
+            return maxDegree;
+        }
+
+        Eigen::VectorXi degrees() const {return faceStart.tail(num_faces())-faceStart.head(num_faces());}
+
+        //conversions from and to the legacy (D,F) pair, in one pass over the corners
+        void from_padded(const Eigen::VectorXi& D, const Eigen::MatrixXi& F){
+            faceStart.resize(D.size()+1);
+            faceStart(0)=0;
+            for (int f=0;f<D.size();f++)
+                faceStart(f+1)=faceStart(f)+D(f);
+            faceVertices.resize(faceStart(D.size()));
+            for (int f=0;f<D.size();f++)
+                for (int j=0;j<D(f);j++)
+                    faceVertices(faceStart(f)+j)=F(f,j);
+        }
+
+        void to_padded(Eigen::VectorXi& D, Eigen::MatrixXi& F) const{
+            D=degrees();
+            F=Eigen::MatrixXi::Constant(num_faces(), max_degree(), -1);
+            for (int f=0;f<num_faces();f++)
+                for (int j=0;j<degree(f);j++)
+                    F(f,j)=vertex(f,j);
+        }
+    };
+
+
+    //a read-only CSR view over external buffers (e.g. a memory-mapped .hedra file, see MappedHedraMesh.h), with the same layout as PolygonMesh
+    class PolygonMeshMap{
+    public:
+        Eigen::Map<const Eigen::VectorXi> faceStart;      //#F+1
+        Eigen::Map<const Eigen::VectorXi> faceVertices;   //sum(D)
+
+        PolygonMeshMap(const int* _faceStart, const int numFaces, const int* _faceVertices):
+        faceStart(_faceStart, numFaces+1), faceVertices(_faceVertices, _faceStart[numFaces]){}
+
+        PolygonMeshMap(const PolygonMesh& P):
+        faceStart(P.faceStart.data(), P.faceStart.size()), faceVertices(P.faceVertices.data(), P.faceVertices.size()){}
+
+        int num_faces() const {return faceStart.size()-1;}
+        int num_corners() const {return faceVertices.size();}
+        int degree(const int f) const {return faceStart(f+1)-faceStart(f);}
+        int vertex(const int f, const int j) const {return faceVertices(faceStart(f)+j);}
+        int corner(const int f, const int j) const {return faceStart(f)+j;}
+        int corner_rows() const {return faceVertices.size();}
+        int corner_cols() const {return 1;}
+
+        Eigen::Map<const Eigen::VectorXi> face(const int f) const {return Eigen::Map<const Eigen::VectorXi>(faceVertices.data()+faceStart(f), degree(f));}
+    };
+
+
+    //a view over D and F, which must outlive it; it cannot be built from temporaries
+    class PaddedPolygons{
+    public:
+        Eigen::Map<const Eigen::VectorXi> D;   //#F face degrees (also from a #F by 1 Eigen::MatrixXi)
+        const Eigen::MatrixXi* F;             //#F by max(D) - vertex indices in face
+
+        template<typename DerivedD>
+        PaddedPolygons(const Eigen::PlainObjectBase<DerivedD>& _D, const Eigen::MatrixXi& _F):D(_D.data(), _D.size()), F(&_F){}
+
+        template<typename DerivedD>
+        PaddedPolygons(const Eigen::PlainObjectBase<DerivedD>& _D, Eigen::MatrixXi&& _F)=delete;
+        template<typename DerivedD>
+        PaddedPolygons(Eigen::PlainObjectBase<DerivedD>&& _D, const Eigen::MatrixXi& _F)=delete;
+
+        int num_faces() const {return D.size();}
+        int degree(const int f) const {return D(f);}
+        int vertex(const int f, const int j) const {return (*F)(f,j);}
+        int corner(const int f, const int j) const {return f+F->rows()*j;}  //column-major, as Eigen::MatrixXi
+        int corner_rows() const {return F->rows();}
+        int corner_cols() const {return F->cols();}
+    };
+}
+
+
+#endif
@@ -11,6 +11,9 @@
 #include <igl/sortrows.h>
 #include <igl/speye.h>
 #include <Eigen/Core>
+#include <hedra/jacobian_kernels.h>
+#include <hedra/is_matrix_free.h>
+#include <hedra/SolverTelemetry.h>
 #include <string>
 #include <vector>
 #include <cstdio>
@@ -33,10 +36,13 @@ namespace hedra {
             Eigen::VectorXi HRows, HCols;  //(row,col) pairs for H=J^T*J matrix
             Eigen::VectorXd HVals;      //values for H matrix
             Eigen::MatrixXi S2D;        //single J to J^J indices
+            Eigen::VectorXi adjColStart, adjColPerm;  //column-sorted gather pattern of J for J^T*v
+            int numThreads;             //threads for the Jacobian products (1 by default); results do not depend on it
 
             LinearSolver* LS;
             SolverTraits* ST;
             
+            SolverTelemetry* telemetry; //optional per-iteration records and phase times (see SolverTelemetry.h); NULL by default
 
             //Input: pattern of matrix M by (iI,iJ) representation
             //Output: pattern of matrix M^T*M by (oI, oJ) representation
@@ -93,27 +99,72 @@ namespace hedra {
                               const Eigen::MatrixXi& S2D,
                               Eigen::VectorXd& oS)
             {
-                for (int i=0;i<S2D.rows();i++)
-                    oS(i)=iS(S2D(i,0))*iS(S2D(i,1));
+                matrix_values(iS, S2D, numThreads, oS);
                 
             }
             
             //returns M^t*ivec by (I,J,S) representation
+            //uses the gather pattern from init() when (I,J,S) is the Jacobian of the traits
             void MultiplyAdjointVector(const Eigen::VectorXi& iI,
                                        const Eigen::VectorXi& iJ,
                                        const Eigen::VectorXd& iS,
                                        const Eigen::VectorXd& iVec,
                                        Eigen::VectorXd& oVec)
             {
+                if ((&iJ==&ST->JCols)&&(iJ.size()==adjColPerm.size())&&(oVec.size()==adjColStart.size()-1)){
+                    multiply_adjoint_vector(iI, iS, iVec, adjColStart, adjColPerm, numThreads, oVec);
+                    return;
+                }
                 oVec.setZero();
                 for (int i=0;i<iI.size();i++)
                     oVec(iJ(i))+=iS(i)*iVec(iI(i));
             }
             
             
+            //setting up the linear solver: either with the pattern of H=J^T*J, or directly with the pattern of J for matrix-free linear solvers
+            void analyze_system(std::false_type){
+                MatrixPattern(ST->JRows, ST->JCols,HRows,HCols,S2D);
+                HVals.resize(HRows.size());
+                LS->analyze(HRows,HCols,true);
+            }
+            
+            void analyze_system(std::true_type){
+                LS->analyze_jacobian(ST->JRows, ST->JCols, ST->xSize);
+            }
+            
+            bool factorize_system(std::false_type){
+                {
+                    SolverTelemetry::ScopedTimer timer(telemetry, MATRIX_VALUES);
+                    MatrixValues(HRows, HCols, ST->JVals, S2D, HVals);
+                }
+                SolverTelemetry::ScopedTimer timer(telemetry, FACTORIZE);
+                return LS->factorize(HVals,true);
+            }
+            
+            bool factorize_system(std::true_type){
+                SolverTelemetry::ScopedTimer timer(telemetry, FACTORIZE);
+                return LS->factorize_jacobian(ST->JVals, 0.0);
+            }
+            
+            //the traits and linear solver calls, timed into the telemetry
+            void timed_update_energy(const Eigen::VectorXd& currx){
+                SolverTelemetry::ScopedTimer timer(telemetry, UPDATE_ENERGY);
+                ST->update_energy(currx);
+            }
+            
+            void timed_update_jacobian(const Eigen::VectorXd& currx){
+                SolverTelemetry::ScopedTimer timer(telemetry, UPDATE_JACOBIAN);
+                ST->update_jacobian(currx);
+            }
+            
+            void timed_solve(const Eigen::MatrixXd& rhs, Eigen::MatrixXd& direction){
+                SolverTelemetry::ScopedTimer timer(telemetry, SOLVE);
+                LS->solve(rhs, direction);
+            }
+            
         public:
             
-            SLSolver(){};
+            SLSolver():numThreads(1), telemetry(NULL){};
             
             void init(LinearSolver* _LS,
                       SolverTraits* _ST){
@@ -121,10 +172,8 @@ namespace hedra {
                 LS=_LS;
                 ST=_ST;
                 //analysing pattern
-                MatrixPattern(ST->JRows, ST->JCols,HRows,HCols,S2D);
-                HVals.resize(HRows.size());
-                
-                LS->analyze(HRows,HCols);
+                adjoint_gather_pattern(ST->JCols, ST->xSize, adjColStart, adjColPerm);
+                analyze_system(is_matrix_free<LinearSolver>());
                 
                 d.resize(ST->xSize);
                 x.resize(ST->xSize);
@@ -143,36 +192,55 @@ namespace hedra {
                 using namespace std;
                 ST->initial_solution(x0);
                 prevx<<x0;
+                if (telemetry)
+                    telemetry->begin_solve();
                 int currIter=0;
                 bool stop=false;
                 double currError, prevError;
                 VectorXd rhs(ST->xSize);
-                VectorXd direction;
+                MatrixXd direction;
                 if (verbose)
                     cout<<"******Beginning Optimization******"<<endl;
 
                 ST->update_jacobian(prevx);
                 do{
-                    ST->update_energy(prevx);
-                    ST->update_jacobian(prevx);
+                    //every iteration is a big iteration
+                    if (telemetry)
+                        telemetry->begin_iteration(currIter, 0);
+                    timed_update_energy(prevx);
+                    timed_update_jacobian(prevx);
                     ST->pre_iteration(prevx);
-                    MatrixValues(HRows, HCols, ST->JVals, S2D, HVals);
                     MultiplyAdjointVector(ST->JRows, ST->JCols, ST->JVals, -ST->EVec, rhs);
+                    if (telemetry){
+                        telemetry->current.energy=ST->EVec.squaredNorm();
+                        telemetry->current.firstOrderOptimality=rhs.template lpNorm<Infinity>();
+                    }
                     
                     //solving to get the GN direction
-                    if(!LS->factorize(HVals)) {
+                    if(!factorize_system(is_matrix_free<LinearSolver>())) {
                         // decomposition failed
-                        cout<<"Solver Failed to factorize! "<<endl;
+                        if (verbose)
+                            cout<<"Solver Failed to factorize! "<<endl;
+                        if (telemetry)
+                            telemetry->end_solve();
                         return false;
                     }
                         
-                    LS->solve(rhs,direction);
+                    timed_solve(rhs,direction);
                     x=prevx+direction;
-                    ST->update_energy(x);
-                    ST->update_jacobian(x);
+                    timed_update_energy(x);
+                    timed_update_jacobian(x);
+                    if (telemetry){
+                        telemetry->current.stepNorm=direction.norm();
+                        telemetry->current.isAccepted=true;
+                        telemetry->end_iteration();
+                    }
                     ST->post_iteration(x);
                     prevx=x;
+                    currIter++;
                 }while (!ST->post_optimization(x));
+                if (telemetry)
+                    telemetry->end_solve();
                 return true;
             }
         };
@@ -0,0 +1,195 @@
+// This file is part of libhedra, a library for polyhedral mesh processing
+//
+// Copyright (C) 2016 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+#ifndef HEDRA_SOLVER_TELEMETRY_H
+#define HEDRA_SOLVER_TELEMETRY_H
+#include <igl/igl_inline.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <ostream>
+#include <fstream>
+#include <limits>
+
+namespace hedra {
+    namespace optimization
+    {
+        //the timed phases of an iteration of LMSolver, GNSolver, SLSolver and TRSolver
+        enum SolverPhase{
+            UPDATE_ENERGY=0,    //SolverTraits::update_energy()
+            UPDATE_JACOBIAN,    //SolverTraits::update_jacobian()
+            MATRIX_VALUES,      //the values of J^T*J(+miu*I) (none for matrix-free linear solvers)
+            FACTORIZE,          //LinearSolver::factorize() or factorize_jacobian()
+            SOLVE,              //LinearSolver::solve()
+            NUM_SOLVER_PHASES
+        };
+
+        //One iteration (a trial step, accepted or rejected) of a solver
+        struct IterationRecord{
+            int bigIteration;               //the number of post_optimization() calls before it
+            int iteration;                  //within the big iteration
+            double energy;                  //|EVec|^2 at the linearization point
+            double firstOrderOptimality;    //|J^T*EVec|_inf at the linearization point
+            double miu;                     //the damping of J^T*J+miu*I (0 without damping)
+            double radius;                  //the trust-region radius (TRSolver with DOGLEG only, 0 otherwise)
+            double stepNorm;                //|x-prevx| of the step that was tried (0 if no step was tried)
+            bool isAccepted;
+            double phaseTimes[NUM_SOLVER_PHASES];  //in seconds
+        };
+
+        //Collects the iterations of a solve() of any of the solvers, when given to their "telemetry" member (NULL by default, and then nothing is measured).
+        //"callback" is called at the end of every iteration, e.g. for live plots or for logging, and the whole history can be written as JSON or CSV.
+        class SolverTelemetry{
+        public:
+            typedef std::chrono::steady_clock Clock;
+
+            std::vector<IterationRecord> iterations;
+            std::function<void(const IterationRecord&)> callback;
+            IterationRecord current;        //the iteration in progress, filled by the solver
+
+            //measures the time of a scope into the current iteration; does nothing with a NULL telemetry
+            class ScopedTimer{
+            public:
+                ScopedTimer(SolverTelemetry* _telemetry, const SolverPhase _phase):telemetry(_telemetry), phase(_phase){
+                    if (telemetry)
+                        start=Clock::now();
+                }
+                ~ScopedTimer(){
+                    if (telemetry)
+                        telemetry->current.phaseTimes[phase]+=std::chrono::duration<double>(Clock::now()-start).count();
+                }
+            private:
+                SolverTelemetry* telemetry;
+                SolverPhase phase;
+                Clock::time_point start;
+                ScopedTimer(const ScopedTimer&);
+                ScopedTimer& operator=(const ScopedTimer&);
+            };
+
+            SolverTelemetry():isPending(false){}
+
+            //called by the solver at the beginning of solve()
+            void begin_solve(){
+                iterations.clear();
+                isPending=false;
+            }
+
+            //starts a new iteration; the previous one is recorded if it was not yet
+            void begin_iteration(const int bigIteration, const int iteration){
+                end_iteration();
+                current.bigIteration=bigIteration;
+                current.iteration=iteration;
+                current.energy=current.firstOrderOptimality=std::numeric_limits<double>::quiet_NaN();
+                current.miu=current.radius=current.stepNorm=0.0;
+                current.isAccepted=false;
+                for (int i=0;i<NUM_SOLVER_PHASES;i++)
+                    current.phaseTimes[i]=0.0;
+                isPending=true;
+            }
+
+            //records the current iteration; an iteration that stops before trying a step is recorded as it is by the next begin_iteration() or end_solve()
+            void end_iteration(){
+                if (!isPending)
+                    return;
+                isPending=false;
+                iterations.push_back(current);
+                if (callback)
+                    callback(current);
+            }
+
+            void end_solve(){end_iteration();}
+
+            int num_accepted() const{
+                int numAccepted=0;
+                for (size_t i=0;i<iterations.size();i++)
+                    numAccepted+=(iterations[i].isAccepted ? 1 : 0);
+                return numAccepted;
+            }
+
+            //the total time of a phase over all iterations
+            double total_time(const SolverPhase phase) const{
+                double time=0.0;
+                for (size_t i=0;i<iterations.size();i++)
+                    time+=iterations[i].phaseTimes[phase];
+                return time;
+            }
+
+            static const char* phase_name(const SolverPhase phase){
+                static const char* names[NUM_SOLVER_PHASES]={"update_energy", "update_jacobian", "matrix_values", "factorize", "solve"};
+                return names[phase];
+            }
+
+            //{"iterations":[{"big_iteration":0,"iteration":0,...,"times":{"update_energy":...,...}},...],"total_times":{...}}
+            //non-finite values are written as null
+            bool write_JSON(std::ostream& os) const{
+                std::streamsize oldPrecision=os.precision(17);
+                os<<"{\"iterations\":[";
+                for (size_t i=0;i<iterations.size();i++){
+                    const IterationRecord& r=iterations[i];
+                    os<<(i==0 ? "\n" : ",\n")<<"{\"big_iteration\":"<<r.bigIteration<<",\"iteration\":"<<r.iteration;
+                    os<<",\"energy\":"; write_JSON_number(os, r.energy);
+                    os<<",\"first_order_optimality\":"; write_JSON_number(os, r.firstOrderOptimality);
+                    os<<",\"miu\":"; write_JSON_number(os, r.miu);
+                    os<<",\"radius\":"; write_JSON_number(os, r.radius);
+                    os<<",\"step_norm\":"; write_JSON_number(os, r.stepNorm);
+                    os<<",\"accepted\":"<<(r.isAccepted ? "true" : "false")<<",\"times\":{";
+                    for (int p=0;p<NUM_SOLVER_PHASES;p++)
+                        os<<(p==0 ? "" : ",")<<"\""<<phase_name(SolverPhase(p))<<"\":"<<r.phaseTimes[p];
+                    os<<"}}";
+                }
+                os<<"\n],\"total_times\":{";
+                for (int p=0;p<NUM_SOLVER_PHASES;p++)
+                    os<<(p==0 ? "" : ",")<<"\""<<phase_name(SolverPhase(p))<<"\":"<<total_time(SolverPhase(p));
+                os<<"}}\n";
+                os.precision(oldPrecision);
+                return !os.fail();
+            }
+
+            //one header line, and then one line per iteration
+            bool write_CSV(std::ostream& os) const{
+                std::streamsize oldPrecision=os.precision(17);
+                os<<"big_iteration,iteration,energy,first_order_optimality,miu,radius,step_norm,accepted";
+                for (int p=0;p<NUM_SOLVER_PHASES;p++)
+                    os<<","<<phase_name(SolverPhase(p));
+                os<<"\n";
+                for (size_t i=0;i<iterations.size();i++){
+                    const IterationRecord& r=iterations[i];
+                    os<<r.bigIteration<<","<<r.iteration<<","<<r.energy<<","<<r.firstOrderOptimality<<","<<r.miu<<","<<r.radius<<","<<r.stepNorm<<","<<(r.isAccepted ? 1 : 0);
+                    for (int p=0;p<NUM_SOLVER_PHASES;p++)
+                        os<<","<<r.phaseTimes[p];
+                    os<<"\n";
+                }
+                os.precision(oldPrecision);
+                return !os.fail();
+            }
+
+            bool write_JSON(const std::string& fileName) const{
+                std::ofstream os(fileName.c_str());
+                return (os.is_open() && write_JSON(os));
+            }
+
+            bool write_CSV(const std::string& fileName) const{
+                std::ofstream os(fileName.c_str());
+                return (os.is_open() && write_CSV(os));
+            }
+
+        private:
+            bool isPending;
+
+            static void write_JSON_number(std::ostream& os, const double value){
+                if ((value==value)&&(value-value==0.0))
+                    os<<value;
+                else
+                    os<<"null";
+            }
+        };
+    }
+}
+
+
+#endif
@@ -0,0 +1,376 @@
+// This file is part of libhedra, a library for polyhedral mesh processing
+//
+// Copyright (C) 2016 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+#ifndef HEDRA_TRUST_REGION_SOLVER_H
+#define HEDRA_TRUST_REGION_SOLVER_H
+#include <igl/igl_inline.h>
+#include <Eigen/Core>
+#include <hedra/jacobian_kernels.h>
+#include <hedra/is_matrix_free.h>
+#include <hedra/SolverTelemetry.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+
+namespace hedra {
+    namespace optimization
+    {
+        enum TRMethod{
+            DOGLEG,         //Powell's dogleg in a trust region: one factorization of J^T*J per accepted step, and none for rejected steps
+            GEODESIC_LM     //Levenberg-Marquardt with geodesic acceleration [Transtrum and Sethna 2012]: the velocity and the acceleration share one factorization of J^T*J+miu*I
+        };
+
+        //A trust-region solver for the same SolverTraits and LinearSolver concepts as LMSolver (see LMSolver.h and is_matrix_free.h).
+        //Unlike LMSolver, the traits are only linearized (pre_iteration(), update_jacobian()) and post_iteration() is only called after accepted steps, so that the factorization and the Jacobian are reused by rejected steps.
+        //The statistics of the last solve() (numFactorizations per numAcceptedSteps etc.) are kept for comparisons with LMSolver.
+        template<class LinearSolver, class SolverTraits>
+        class TRSolver{
+        public:
+            Eigen::VectorXd x;      //current solution; always updated
+            Eigen::VectorXd prevx;  //the solution of the previous accepted iteration
+            Eigen::VectorXd x0;     //the initial solution to the system
+            Eigen::VectorXd d;      //the last step taken.
+
+            Eigen::VectorXi HRows, HCols;  //(row,col) pairs for H=J^T*J+miu*I matrix
+            Eigen::VectorXd HVals;      //values for H matrix
+            Eigen::MatrixXi S2D;        //single J to J^J indices
+            Eigen::VectorXi adjColStart, adjColPerm;  //column-sorted gather pattern of J for J^T*v
+            Eigen::VectorXi rowStart, rowPerm;        //row-sorted gather pattern of J for J*v
+            int numThreads;             //threads for the Jacobian products (1 by default); results do not depend on it
+
+            LinearSolver* LS;
+            SolverTraits* ST;
+            int maxIterations;          //of trial steps, accepted or not
+            double xTolerance;
+            double fooTolerance;
+
+            TRMethod method;
+            double regularization;      //DOGLEG: miu of the Gauss-Newton step, relative to the largest diagonal entry of J^T*J (it is only semi-definite with gauge freedoms)
+            double accelerationRatio;   //GEODESIC_LM: the largest accepted 2|a|/|v| between the acceleration and the velocity
+            double fdStep;              //GEODESIC_LM: finite-difference step for the second directional derivative of the residuals
+
+            //statistics of the last solve()
+            int numFactorizations;
+            int numAcceptedSteps;
+            int numRejectedSteps;
+            int numEnergyEvaluations;
+            int numJacobianEvaluations;
+
+            SolverTelemetry* telemetry; //optional per-iteration records and phase times (see SolverTelemetry.h); NULL by default
+
+            //oVec=J^T*iVec
+            void MultiplyAdjointVector(const Eigen::VectorXd& iVec,
+                                       Eigen::VectorXd& oVec)
+            {
+                multiply_adjoint_vector(ST->JRows, ST->JVals, iVec, adjColStart, adjColPerm, numThreads, oVec);
+            }
+
+            //oVec=J*iVec
+            void MultiplyVector(const Eigen::VectorXd& iVec,
+                                Eigen::VectorXd& oVec)
+            {
+                multiply_adjoint_vector(ST->JCols, ST->JVals, iVec, rowStart, rowPerm, numThreads, oVec);
+            }
+
+
+            //setting up the linear solver: either with the pattern of H=J^T*J+miu*I, or directly with the pattern of J for matrix-free linear solvers
+            void analyze_system(std::false_type){
+                normal_equations_pattern(ST->JRows, ST->JCols, HRows, HCols, S2D);
+                HVals.resize(HRows.size());
+                LS->analyze(HRows,HCols, true);
+            }
+
+            void analyze_system(std::true_type){
+                LS->analyze_jacobian(ST->JRows, ST->JCols, ST->xSize);
+            }
+
+            bool factorize_system(const double miu, std::false_type){
+                {
+                    SolverTelemetry::ScopedTimer timer(telemetry, MATRIX_VALUES);
+                    normal_equations_values(ST->JVals, S2D, miu, numThreads, HVals);
+                }
+                SolverTelemetry::ScopedTimer timer(telemetry, FACTORIZE);
+                return LS->factorize(HVals, true);
+            }
+
+            bool factorize_system(const double miu, std::true_type){
+                SolverTelemetry::ScopedTimer timer(telemetry, FACTORIZE);
+                return LS->factorize_jacobian(ST->JVals, miu);
+            }
+
+            bool factorize(const double miu){
+                numFactorizations++;
+                return factorize_system(miu, is_matrix_free<LinearSolver>());
+            }
+
+            void solve_system(const Eigen::VectorXd& rhs, Eigen::VectorXd& direction){
+                Eigen::MatrixXd mRhs=rhs;
+                Eigen::MatrixXd mDirection;
+                SolverTelemetry::ScopedTimer timer(telemetry, SOLVE);
+                LS->solve(mRhs,mDirection);
+                direction=mDirection.col(0);
+            }
+
+            double energy(const Eigen::VectorXd& currx){
+                numEnergyEvaluations++;
+                SolverTelemetry::ScopedTimer timer(telemetry, UPDATE_ENERGY);
+                ST->update_energy(currx);
+                return ST->EVec.squaredNorm();
+            }
+
+            //the largest diagonal J_i*J_i product of J^T*J
+            double max_diagonal(){
+                double maxDiag=0.0;
+                for (int i=0;i<ST->JVals.size();i++)
+                    maxDiag=(maxDiag < ST->JVals(i)*ST->JVals(i) ? ST->JVals(i)*ST->JVals(i) : maxDiag);
+                return maxDiag;
+            }
+
+            //the point on the dogleg path (Cauchy point, then Gauss-Newton step gn) of length radius, where sd=-alpha*g is the Cauchy point
+            void dogleg_step(const Eigen::VectorXd& gn,
+                             const Eigen::VectorXd& sd,
+                             const Eigen::VectorXd& rhs,
+                             const double radius,
+                             Eigen::VectorXd& step){
+                if (gn.norm()<=radius){
+                    step=gn;
+                } else if (sd.norm()>=radius){
+                    step=(radius/rhs.norm())*rhs;
+                } else {
+                    Eigen::VectorXd diff=gn-sd;
+                    double a=diff.squaredNorm();
+                    double b=2.0*sd.dot(diff);
+                    double c=sd.squaredNorm()-radius*radius;
+                    double beta=(-b+std::sqrt(b*b-4.0*a*c))/(2.0*a);
+                    step=sd+beta*diff;
+                }
+            }
+
+        public:
+
+            TRSolver():numThreads(1), method(DOGLEG), regularization(10e-10), accelerationRatio(0.75), fdStep(0.1),
+            numFactorizations(0), numAcceptedSteps(0), numRejectedSteps(0), numEnergyEvaluations(0), numJacobianEvaluations(0), telemetry(NULL){};
+
+            void init(LinearSolver* _LS,
+                      SolverTraits* _ST,
+                      int _maxIterations=100,
+                      double _xTolerance=10e-9,
+                      double _fooTolerance=10e-9,
+                      TRMethod _method=DOGLEG){
+
+                LS=_LS;
+                ST=_ST;
+                maxIterations=_maxIterations;
+                xTolerance=_xTolerance;
+                fooTolerance=_fooTolerance;
+                method=_method;
+                //analysing pattern
+                adjoint_gather_pattern(ST->JCols, ST->xSize, adjColStart, adjColPerm);
+                adjoint_gather_pattern(ST->JRows, ST->EVec.size(), rowStart, rowPerm);
+                analyze_system(is_matrix_free<LinearSolver>());
+
+                d.resize(ST->xSize);
+                x.resize(ST->xSize);
+                x0.resize(ST->xSize);
+                prevx.resize(ST->xSize);
+            }
+
+            //factorizations per accepted step of the last solve()
+            double factorizations_per_accepted_step() const {return (numAcceptedSteps>0 ? (double)numFactorizations/(double)numAcceptedSteps : (double)numFactorizations);}
+
+            bool solve(const bool verbose) {
+
+                using namespace Eigen;
+                using namespace std;
+                ST->initial_solution(x0);
+                prevx<<x0;
+                x=x0;
+                numFactorizations=numAcceptedSteps=numRejectedSteps=numEnergyEvaluations=numJacobianEvaluations=0;
+                if (telemetry)
+                    telemetry->begin_solve();
+                int bigIteration=0;
+
+                VectorXd rhs(ST->xSize), gn(ST->xSize), sd(ST->xSize), a(ST->xSize), aRhs(ST->xSize);
+                VectorXd r0, Jv(ST->EVec.size()), Jd(ST->EVec.size());
+                if (verbose)
+                    cout<<"******Beginning Optimization******"<<endl;
+
+                //LM damping, as in LMSolver
+                const double tau=10e-3;
+                const double beta=2.0;
+                const double gamma=3.0;
+                double miu=-1.0, nu=beta;
+                double radius=-1.0;  //DOGLEG: the initial radius is the length of the first Gauss-Newton step
+
+                do{
+                    int currIter=0;
+                    bool isLinearized=false;
+                    double prevE=0.0;
+                    double firstOrderOptimality=0.0;
+                    do{
+                        if (telemetry)
+                            telemetry->begin_iteration(bigIteration, currIter);
+                        if (!isLinearized){
+                            ST->pre_iteration(prevx);
+                            prevE=energy(prevx);
+                            r0=ST->EVec;
+                            {
+                                SolverTelemetry::ScopedTimer timer(telemetry, UPDATE_JACOBIAN);
+                                ST->update_jacobian(prevx);
+                            }
+                            numJacobianEvaluations++;
+                            if (verbose)
+                                cout<<"Initial Energy for Iteration "<<currIter<<": "<<prevE<<endl;
+                            MultiplyAdjointVector(-r0, rhs);
+
+                            firstOrderOptimality=rhs.template lpNorm<Infinity>();
+                            if (telemetry){
+                                telemetry->current.energy=prevE;
+                                telemetry->current.firstOrderOptimality=firstOrderOptimality;
+                            }
+                            if (verbose)
+                                cout<<"firstOrderOptimality: "<<firstOrderOptimality<<endl;
+                            if (firstOrderOptimality<fooTolerance){
+                                x=prevx;
+                                if (verbose)
+                                    cout<<"First-order optimality has been reached"<<endl;
+                                break;
+                            }
+
+                            if (method==DOGLEG){
+                                //the Gauss-Newton step, and the Cauchy point -alpha*g with alpha=|g|^2/|J*g|^2
+                                double miuGN=regularization*max_diagonal();
+                                while (!factorize(miuGN)){
+                                    if ((miuGN==0.0)||(!std::isfinite(miuGN))){
+                                        if (verbose)
+                                            cout<<"Solver Failed to factorize! "<<endl;
+                                        if (telemetry)
+                                            telemetry->end_solve();
+                                        return false;
+                                    }
+                                    miuGN*=10.0;
+                                }
+                                solve_system(rhs, gn);
+                                MultiplyVector(rhs, Jv);
+                                double JgNorm2=Jv.squaredNorm();
+                                sd=(JgNorm2>0.0 ? rhs.squaredNorm()/JgNorm2 : 0.0)*rhs;
+                                if (radius<0.0)
+                                    radius=gn.norm();
+                            } else if (miu<0.0)
+                                miu=tau*max_diagonal();
+                            isLinearized=true;
+                        }
+
+                        if (telemetry){
+                            telemetry->current.energy=prevE;
+                            telemetry->current.firstOrderOptimality=firstOrderOptimality;
+                            if (method==DOGLEG)
+                                telemetry->current.radius=radius;
+                            else
+                                telemetry->current.miu=miu;
+                        }
+                        if (method==DOGLEG){
+                            dogleg_step(gn, sd, rhs, radius, d);
+                        } else {
+                            //velocity and acceleration with the same factorization
+                            if(!factorize(miu)) {
+                                if (verbose)
+                                    cout<<"Solver Failed to factorize! "<<endl;
+                                if (telemetry)
+                                    telemetry->end_solve();
+                                return false;
+                            }
+                            solve_system(rhs, d);
+                            MultiplyVector(d, Jv);
+                            energy(prevx+fdStep*d);
+                            VectorXd rvv=(2.0/fdStep)*((ST->EVec-r0)/fdStep-Jv);
+                            MultiplyAdjointVector(-rvv, aRhs);
+                            solve_system(aRhs, a);
+                            d+=0.5*a;
+                        }
+
+                        if (verbose)
+                            cout<<"direction magnitude: "<<d.norm()<<endl;
+                        if (d.norm() < xTolerance * prevx.norm()){
+                            x=prevx;
+                            if (verbose)
+                                cout<<"Stopping since direction magnitude small."<<endl;
+                            break;
+                        }
+
+                        //the actual reduction against the reduction of the linear model |r0+J*d|^2. The acceleration corrects for the curvature that the linear model does not see, so with GEODESIC_LM the model is of the velocity alone
+                        if (method==DOGLEG)
+                            MultiplyVector(d, Jd);
+                        double predictedReduction=prevE-(r0+(method==DOGLEG ? Jd : Jv)).squaredNorm();
+                        VectorXd tryx=prevx+d;
+                        double currE=energy(tryx);
+                        double rho=(predictedReduction>0.0 ? (prevE-currE)/predictedReduction : -1.0);
+                        bool isAccepted=(rho>0.0);
+                        if (method==GEODESIC_LM)
+                            isAccepted=isAccepted&&(2.0*a.norm()<=accelerationRatio*(d-0.5*a).norm());
+                        if (telemetry){
+                            telemetry->current.stepNorm=d.norm();
+                            telemetry->current.isAccepted=isAccepted;
+                            telemetry->end_iteration();
+                        }
+
+                        if (method==DOGLEG){
+                            if (rho>0.75)
+                                radius=std::max(radius, 3.0*d.norm());
+                            else if (rho<0.25)
+                                radius=d.norm()/2.0;
+                        } else if (isAccepted){
+                            miu*=(1.0/gamma > 1.0-(beta-1.0)*pow(2.0*rho-1.0,3) ? 1.0/gamma : 1.0-(beta-1.0)*pow(2.0*rho-1.0,3));
+                            nu=beta;
+                        } else {
+                            miu*=nu;
+                            nu*=2.0;
+                        }
+
+                        currIter++;
+                        if (!isAccepted){
+                            numRejectedSteps++;
+                            x=prevx;
+                            if ((method==DOGLEG)&&(radius < xTolerance * (prevx.norm()+xTolerance))){
+                                if (verbose)
+                                    cout<<"Stopping since the trust region is small."<<endl;
+                                break;
+                            }
+                            continue;
+                        }
+
+                        numAcceptedSteps++;
+                        x=tryx;
+                        isLinearized=false;
+                        //The SolverTraits can order the optimization to stop by giving "true" of to continue by giving "false"
+                        if (ST->post_iteration(x)){
+                            if (verbose)
+                                cout<<"ST->Post_iteration() gave a stop"<<endl;
+                            break;
+                        }
+                        prevx=x;
+                    }while (currIter<=maxIterations);
+                    prevx=x;
+                    bigIteration++;
+                }while (!ST->post_optimization(x));
+                if (telemetry)
+                    telemetry->end_solve();
+
+                if (verbose)
+                    cout<<"Factorizations: "<<numFactorizations<<", accepted steps: "<<numAcceptedSteps<<", rejected steps: "<<numRejectedSteps<<endl;
+                return true;
+            }
+        };
+
+    }
+}
+
+
+#endif
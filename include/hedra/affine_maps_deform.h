@@ -11,10 +11,10 @@
 #include <igl/igl_inline.h>
 #include <igl/setdiff.h>
 #include <Eigen/Core>
-#include <Eigen/SparseQR>
 #include <Eigen/Geometry>
 #include <Eigen/SVD>
 #include <vector>
+#include <hedra/CholmodSolverWrapper.h>
 #include <igl/matlab_format.h>
 
 
@@ -37,7 +37,7 @@ namespace hedra
         Eigen::SparseMatrix<double> AFull, A;  //energy matrices (full and substituted)
         Eigen::SparseMatrix<double> CFull, C;  //constraint matrices
         Eigen::SparseMatrix<double> W;          //weight matrix for energy
-        Eigen::SparseQR<Eigen::SparseMatrix<double, Eigen::ColMajor>, Eigen::COLAMDOrdering<int> >  solver;
+        hedra::optimization::SparseQRSolver solver;  //the KKT system is indefinite, so it is factorized by QR; SuiteSparseQR with HEDRA_WITH_CHOLMOD (see CholmodSolverWrapper.h)
         AffineEnergyTypes aet;
         double sqrtBendFactor;
         Eigen::VectorXi h;  //handle indices
@@ -347,8 +347,7 @@ namespace hedra
        
         BigMat.setFromTriplets(BigMatTris.begin(), BigMatTris.end());
          //std::cout<<igl::matlab_format(BigMat,"BigMat")<<std::endl;
-        adata.solver.analyzePattern(BigMat);
-        adata.solver.factorize(BigMat);
+        adata.solver.compute(BigMat);
     }
     
     
@@ -0,0 +1,211 @@
+// This file is part of libhedra, a library for polyhedral mesh processing
+//
+// Copyright (C) 2016 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+#ifndef HEDRA_ASCII_PARSING_H
+#define HEDRA_ASCII_PARSING_H
+#include <igl/igl_inline.h>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <clocale>
+
+#if (__cplusplus >= 201703L) || (defined(_MSVC_LANG) && (_MSVC_LANG >= 201703L))
+#include <charconv>
+#endif
+
+//Helpers for the ascii mesh readers and writers: the file is read into one buffer, and numbers are parsed and formatted in place, without streams or per-number allocations.
+//Doubles are parsed with std::from_chars and formatted with std::to_chars (shortest round-trip form) when the standard library supports them for floating point (C++17), which are locale-independent and exact; otherwise with strtod and "%.17g", which are exact but follow the C locale.
+//In the latter case, '.' is used as the decimal point whatever that of the C locale (LC_NUMERIC) is, so that the files do not depend on the locale of the reader or the writer.
+
+namespace hedra
+{
+    // reads a whole file into buffer, followed by a terminating '\0'
+    IGL_INLINE bool read_file_buffer(const std::string& fileName,
+                                     std::vector<char>& buffer)
+    {
+        FILE* fileHandle=std::fopen(fileName.c_str(), "rb");
+        if (fileHandle==NULL)
+            return false;
+        std::fseek(fileHandle, 0, SEEK_END);
+        long fileSize=std::ftell(fileHandle);
+        std::fseek(fileHandle, 0, SEEK_SET);
+        if (fileSize<0){
+            std::fclose(fileHandle);
+            return false;
+        }
+        buffer.resize(fileSize+1);
+        size_t readSize=std::fread(buffer.data(), 1, fileSize, fileHandle);
+        std::fclose(fileHandle);
+        buffer[readSize]='\0';
+        buffer.resize(readSize+1);
+        return (readSize==(size_t)fileSize);
+    }
+
+    inline const char* skip_blanks(const char* p, const char* end)
+    {
+        while ((p<end)&&((*p==' ')||(*p=='\t')||(*p=='\r')))
+            p++;
+        return p;
+    }
+
+    // the beginning of the next line
+    inline const char* next_line(const char* p, const char* end)
+    {
+        const char* newLine=(const char*)std::memchr(p, '\n', end-p);
+        return (newLine==NULL ? end : newLine+1);
+    }
+
+    // parses an integer after blanks (not newlines), and advances p past it
+    inline bool parse_int(const char*& p, const char* end, int& value)
+    {
+        const char* q=skip_blanks(p, end);
+        bool isNegative=false;
+        if ((q<end)&&((*q=='-')||(*q=='+'))){
+            isNegative=(*q=='-');
+            q++;
+        }
+        if ((q==end)||(*q<'0')||(*q>'9'))
+            return false;
+        long long result=0;
+        while ((q<end)&&(*q>='0')&&(*q<='9'))
+            result=10*result+(*q++-'0');
+        value=(int)(isNegative ? -result : result);
+        p=q;
+        return true;
+    }
+
+#if !(defined(__cpp_lib_to_chars) && (__cpp_lib_to_chars >= 201611L))
+    // the characters of a number for strtod in the classic locale (including hexadecimal, "inf" and "nan(...)")
+    inline bool is_classic_number_char(const char c)
+    {
+        return (((c>='0')&&(c<='9'))||((c>='a')&&(c<='z'))||((c>='A')&&(c<='Z'))||(c=='+')||(c=='-')||(c=='.')||(c=='(')||(c==')')||(c=='_'));
+    }
+
+    // strtod of the number at q with '.' as the decimal point, for a C locale with another one: the number is copied with the decimal point of the locale instead. Returns the end of the number in q (q if there is none).
+    inline const char* strtod_classic(const char* q, const char* end, double& value)
+    {
+        const char* numberEnd=q;
+        while ((numberEnd<end)&&(is_classic_number_char(*numberEnd)))
+            numberEnd++;
+        std::string number(q, numberEnd);
+        size_t pointPosition=number.find('.');
+        const std::string decimalPoint=std::localeconv()->decimal_point;
+        if (pointPosition!=std::string::npos)
+            number.replace(pointPosition, 1, decimalPoint);
+        char* parsedEnd;
+        value=std::strtod(number.c_str(), &parsedEnd);
+        size_t parsedLength=parsedEnd-number.c_str();
+        if ((pointPosition!=std::string::npos)&&(parsedLength>pointPosition))  //past the decimal point of the locale
+            parsedLength-=decimalPoint.size()-1;
+        return q+parsedLength;
+    }
+#endif
+
+    // parses a double after blanks (not newlines), and advances p past it
+    inline bool parse_double(const char*& p, const char* end, double& value)
+    {
+        const char* q=skip_blanks(p, end);
+        if ((q<end)&&(*q=='+'))  //from_chars does not accept a leading '+'
+            q++;
+        if ((q==end)||(*q=='\n'))
+            return false;
+#if defined(__cpp_lib_to_chars) && (__cpp_lib_to_chars >= 201611L)
+        std::from_chars_result result=std::from_chars(q, end, value);
+        if (result.ec!=std::errc())
+            return false;
+        p=result.ptr;
+#else
+        //the buffers of read_file_buffer are null-terminated, so strtod stops within them. If the decimal point of the locale is not '.', strtod stops at a '.', or reads that of the locale (e.g., ','), which is not part of a number in the classic locale.
+        char* strtodEnd;
+        value=std::strtod(q, &strtodEnd);
+        const char* numberEnd=strtodEnd;
+        bool isClassic=((numberEnd==end)||(*numberEnd!='.'));
+        for (const char* c=q;(c<numberEnd)&&(isClassic);c++)
+            isClassic=is_classic_number_char(*c);
+        if (!isClassic)
+            numberEnd=strtod_classic(q, end, value);
+        if ((numberEnd==q)||(numberEnd>end))
+            return false;
+        p=numberEnd;
+#endif
+        return true;
+    }
+
+    // skips blanks, newlines and '#' comments up to the next token, and returns it (end if there is none)
+    inline const char* next_token(const char* p, const char* end)
+    {
+        while (p<end){
+            if ((*p==' ')||(*p=='\t')||(*p=='\r')||(*p=='\n'))
+                p++;
+            else if (*p=='#')
+                p=next_line(p, end);
+            else
+                break;
+        }
+        return p;
+    }
+
+    // if the line starting at p has only blanks or a comment
+    inline bool is_empty_line(const char* p, const char* end)
+    {
+        p=skip_blanks(p, end);
+        return ((p==end)||(*p=='\n')||(*p=='#'));
+    }
+
+    // the largest number of characters written by format_int or format_double
+    const int MAX_FORMATTED_NUMBER_LENGTH=32;
+
+    // writes an integer at p, and returns the end of it
+    inline char* format_int(char* p, const int value)
+    {
+        unsigned int magnitude=(value<0 ? 0u-(unsigned int)value : (unsigned int)value);
+        if (value<0)
+            *p++='-';
+        char digits[12];
+        int numDigits=0;
+        do{
+            digits[numDigits++]=(char)('0'+magnitude%10);
+            magnitude/=10;
+        }while (magnitude>0);
+        while (numDigits>0)
+            *p++=digits[--numDigits];
+        return p;
+    }
+
+    // the characters that "%.17g" writes for a double, other than the decimal point
+    inline bool is_formatted_double_char(const char c)
+    {
+        return (((c>='0')&&(c<='9'))||(c=='-')||(c=='+')||(c=='e')||(c=='i')||(c=='n')||(c=='f')||(c=='a'));
+    }
+
+    // writes a double at p, such that parse_double reads it back exactly, and returns the end of it
+    inline char* format_double(char* p, const double value)
+    {
+#if defined(__cpp_lib_to_chars) && (__cpp_lib_to_chars >= 201611L)
+        return std::to_chars(p, p+MAX_FORMATTED_NUMBER_LENGTH, value).ptr;
+#else
+        char* numberEnd=p+std::snprintf(p, MAX_FORMATTED_NUMBER_LENGTH, "%.17g", value);
+        //the decimal point of the locale (e.g., ',', or several bytes) is replaced by '.'
+        char* pointStart=p;
+        while ((pointStart<numberEnd)&&(is_formatted_double_char(*pointStart)))
+            pointStart++;
+        if (pointStart==numberEnd)
+            return numberEnd;
+        char* pointEnd=pointStart;
+        while ((pointEnd<numberEnd)&&(!is_formatted_double_char(*pointEnd)))
+            pointEnd++;
+        *pointStart='.';
+        std::memmove(pointStart+1, pointEnd, numberEnd-pointEnd);
+        return numberEnd-(pointEnd-pointStart-1);
+#endif
+    }
+}
+
+
+#endif
@@ -0,0 +1,95 @@
+// This file is part of libhedra, a library for polyhedral mesh processing
+//
+// Copyright (C) 2016 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+#ifndef HEDRA_BUILD_CONNECTIVITY_H
+#define HEDRA_BUILD_CONNECTIVITY_H
+#include <igl/igl_inline.h>
+#include <hedra/PolygonMesh.h>
+#include <hedra/parallel_for.h>
+#include <hedra/polygonal_edge_topology.h>
+#include <hedra/dcel.h>
+#include <hedra/subdivision_basics.h>
+#include <Eigen/Core>
+
+
+namespace hedra
+{
+    // Builds the full connectivity of a mesh in one stage: the edge topology (polygonal_edge_topology), the halfedge structure (dcel), and the vertex stars (vertex_stars), each in parallel over numThreads.
+    // The results are identical to calling the three functions serially.
+    
+    //input:
+    //  P               PolygonMesh or PaddedPolygons (see PolygonMesh.h)
+    //  numThreads      the number of threads (serial by default, as in the three functions; hedra::default_num_threads() uses the hardware concurrency)
+    
+    // Output:
+    //  EV, FE, EF, EFi, FEs, innerEdges            as in polygonal_edge_topology
+    //  VH, EH, FH, HV, HE, HF, nextH, prevH, twinH  as in dcel
+    //  vertexValences, starVertices, starHalfedges, ringFaces, isBoundaryVertex     as in vertex_stars
+    template<class Polygons, typename DerivedFE, typename DerivedFEs, typename DerivedFH>
+    IGL_INLINE void build_connectivity(const Polygons& P,
+                                       Eigen::MatrixXi& EV,
+                                       Eigen::PlainObjectBase<DerivedFE>& FE,
+                                       Eigen::MatrixXi& EF,
+                                       Eigen::MatrixXi& EFi,
+                                       Eigen::PlainObjectBase<DerivedFEs>& FEs,
+                                       Eigen::VectorXi& innerEdges,
+                                       Eigen::VectorXi& VH,
+                                       Eigen::MatrixXi& EH,
+                                       Eigen::PlainObjectBase<DerivedFH>& FH,
+                                       Eigen::VectorXi& HV,
+                                       Eigen::VectorXi& HE,
+                                       Eigen::VectorXi& HF,
+                                       Eigen::VectorXi& nextH,
+                                       Eigen::VectorXi& prevH,
+                                       Eigen::VectorXi& twinH,
+                                       Eigen::VectorXi& vertexValences,
+                                       Eigen::MatrixXi& starVertices,
+                                       Eigen::MatrixXi& starHalfedges,
+                                       Eigen::MatrixXi& ringFaces,
+                                       Eigen::VectorXi& isBoundaryVertex,
+                                       const int numThreads=1)
+    {
+        hedra::polygonal_edge_topology(P, EV, FE, EF, EFi, FEs, innerEdges, numThreads);
+        hedra::dcel(P, EV, EF, EFi, innerEdges, VH, EH, FH, HV, HE, HF, nextH, prevH, twinH, numThreads);
+        hedra::vertex_stars(EV, VH, EH, FH, HV, HE, HF, nextH, prevH, twinH, vertexValences, starVertices, starHalfedges, ringFaces, isBoundaryVertex, numThreads);
+    }
+    
+    //input:
+    //  D  eigen int vector     #F by 1 - face degrees
+    //  F  eigen int matrix     #F by max(D) - vertex indices in face
+    // Output:
+    //  as above, where FE, FEs and FH are #F by max(D)
+    IGL_INLINE void build_connectivity(const Eigen::VectorXi& D,
+                                       const Eigen::MatrixXi& F,
+                                       Eigen::MatrixXi& EV,
+                                       Eigen::MatrixXi& FE,
+                                       Eigen::MatrixXi& EF,
+                                       Eigen::MatrixXi& EFi,
+                                       Eigen::MatrixXd& FEs,
+                                       Eigen::VectorXi& innerEdges,
+                                       Eigen::VectorXi& VH,
+                                       Eigen::MatrixXi& EH,
+                                       Eigen::MatrixXi& FH,
+                                       Eigen::VectorXi& HV,
+                                       Eigen::VectorXi& HE,
+                                       Eigen::VectorXi& HF,
+                                       Eigen::VectorXi& nextH,
+                                       Eigen::VectorXi& prevH,
+                                       Eigen::VectorXi& twinH,
+                                       Eigen::VectorXi& vertexValences,
+                                       Eigen::MatrixXi& starVertices,
+                                       Eigen::MatrixXi& starHalfedges,
+                                       Eigen::MatrixXi& ringFaces,
+                                       Eigen::VectorXi& isBoundaryVertex,
+                                       const int numThreads=1)
+    {
+        build_connectivity(PaddedPolygons(D,F), EV, FE, EF, EFi, FEs, innerEdges, VH, EH, FH, HV, HE, HF, nextH, prevH, twinH, vertexValences, starVertices, starHalfedges, ringFaces, isBoundaryVertex, numThreads);
+    }
+}
+
+
+#endif
@@ -9,6 +9,8 @@
 #define HEDRA_CATMULL_CLARK_H
 #include <igl/igl_inline.h>
 #include <hedra/polygonal_face_centers.h>
+#include <hedra/PolygonMesh.h>
+#include <hedra/OFFStreamWriter.h>
 #include <hedra/dcel.h>
 #include <hedra/vertex_valences.h>
 #include <hedra/vertex_insertion.h>
@@ -53,6 +55,48 @@ namespace hedra
     return true;
   }
   
+  //streaming version: the fine mesh is written directly to an open OFFStreamWriter, to which nothing has been written yet, so that the last (and largest) level of subdivision is never held in memory.
+  IGL_INLINE bool catmull_clark(const Eigen::MatrixXd& V,
+                                const Eigen::VectorXi& D,
+                                const Eigen::MatrixXi& F,
+                                const int& st,
+                                hedra::OFFStreamWriter& fineWriter)
+  {
+    switch (st){
+      case hedra::LINEAR_SUBDIVISION: {
+        hedra::LinearCCSubdivisionData lsd;
+        return vertex_insertion(V, D, F, lsd, fineWriter);
+      }
+      case hedra::CANONICAL_MOEBIUS_SUBDIVISION: {
+        hedra::MoebiusCCSubdivisionData msd;
+        return vertex_insertion(V, D, F, msd, fineWriter);
+      }
+      default: return false;
+    }
+  }
+  
+  //PolygonMesh version (see PolygonMesh.h for what is copied)
+  IGL_INLINE bool catmull_clark(const Eigen::MatrixXd& V,
+                                const hedra::PolygonMesh& P,
+                                const int& st,
+                                Eigen::MatrixXd& fineV,
+                                hedra::PolygonMesh& fineP)
+  {
+    Eigen::VectorXi D;
+    Eigen::MatrixXi F;
+    P.to_padded(D,F);
+    switch (st){
+      case hedra::LINEAR_SUBDIVISION: {
+        hedra::LinearCCSubdivisionData lsd;
+        return vertex_insertion(V, D, F, lsd, fineV, fineP);
+      }
+      case hedra::CANONICAL_MOEBIUS_SUBDIVISION: {
+        hedra::MoebiusCCSubdivisionData msd;
+        return vertex_insertion(V, D, F, msd, fineV, fineP);
+      }
+      default: return false;
+    }
+  }
   
 }
 
@@ -8,78 +8,250 @@
 #ifndef HEDRA_CHECK_TRAITS_H
 #define HEDRA_CHECK_TRAITS_H
 #include <igl/igl_inline.h>
+#include <hedra/parallel_for.h>
 #include <Eigen/Core>
 #include <string>
 #include <vector>
 #include <cstdio>
+#include <cmath>
+#include <iostream>
 
 namespace hedra {
     namespace optimization
     {
-        //This function checks the Jacobian of a traits class that is put for optimization by approximate finite differences, and reports the difference. It is important to use after coding, but it is not for the actual optimization process, since it is really brute-force and slow.
+        //Greedy (Curtis-Powell-Reid) coloring of the columns of a sparse Jacobian: two columns get different colors if they have a nonzero in the same row, so that all the columns of a color can be perturbed together in finite differences, and every row then changes by at most one of them.
+        //Input:
+        //  JRows, JCols   the Jacobian pattern (repetitions are allowed)
+        //  numRows        the number of residuals
+        //  xSize          the number of variables
+        //Output:
+        //  colors         xSize colors in [0,numColors); variables that appear in no entry get color 0
+        //Returns numColors.
+        IGL_INLINE int color_jacobian_columns(const Eigen::VectorXi& JRows,
+                                              const Eigen::VectorXi& JCols,
+                                              const int numRows,
+                                              const int xSize,
+                                              Eigen::VectorXi& colors)
+        {
+            //the entries by column and by row, as offsets and indices
+            Eigen::VectorXi colStart=Eigen::VectorXi::Zero(xSize+1), rowStart=Eigen::VectorXi::Zero(numRows+1);
+            for (int i=0;i<JCols.size();i++){
+                colStart(JCols(i)+1)++;
+                rowStart(JRows(i)+1)++;
+            }
+            for (int i=0;i<xSize;i++)
+                colStart(i+1)+=colStart(i);
+            for (int i=0;i<numRows;i++)
+                rowStart(i+1)+=rowStart(i);
+            Eigen::VectorXi colRows(JCols.size()), rowCols(JRows.size());
+            Eigen::VectorXi colPos=colStart.head(xSize), rowPos=rowStart.head(numRows);
+            for (int i=0;i<JCols.size();i++){
+                colRows(colPos(JCols(i))++)=JRows(i);
+                rowCols(rowPos(JRows(i))++)=JCols(i);
+            }
+
+            //every column takes the smallest color not used by an earlier column that shares a row with it
+            colors.resize(xSize);
+            std::vector<int> forbidden;   //forbidden[c]==col if color c is taken by a neighbor of col
+            int numColors=1;
+            for (int col=0;col<xSize;col++){
+                for (int i=colStart(col);i<colStart(col+1);i++){
+                    int row=colRows(i);
+                    for (int j=rowStart(row);j<rowStart(row+1);j++){
+                        int other=rowCols(j);
+                        if (other<col)
+                            forbidden[colors(other)]=col;
+                    }
+                }
+                int color=0;
+                while ((color<(int)forbidden.size())&&(forbidden[color]==col))
+                    color++;
+                if (color==(int)forbidden.size())
+                    forbidden.push_back(-1);
+                colors(col)=color;
+                numColors=std::max(numColors, color+1);
+            }
+            return numColors;
+        }
+
+        //The result of check_traits(), per residual block
+        struct TraitsCheckResult{
+            int numColors;                      //the number of groups of structurally independent variables, each perturbed together
+            Eigen::VectorXd maxRelativeError;   //the maximum of |FD-J|/max(1,|J|) over the declared entries of the block
+            Eigen::VectorXi maxErrorRow;        //the residual and the variable where it is attained (-1 for blocks without entries)
+            Eigen::VectorXi maxErrorCol;
+            Eigen::VectorXi numUndeclared;      //the residuals that changed by a group of variables without any of them declared in the residual's row, which means that the pattern is missing entries
+            double maxError;                    //the maximum over all blocks
+        };
+
+        //This function checks the Jacobian of a traits class that is put for optimization by approximate (central) finite differences, and reports the difference. It is important to use after coding, but it is not for the actual optimization process.
+        //The variables are colored by the declared pattern (color_jacobian_columns()) and all the variables of a color are perturbed together, so that the cost is two calls to update_energy() per color rather than per variable, and is practical for big meshes (e.g., 20-30 colors for a triangle mesh). Since every residual depends on at most one variable of a color, the differences of the residuals give the entries of the Jacobian column by column; entries that are missing from the pattern show as changed residuals that declare none of the perturbed variables.
+        //Input:
+        //  Traits          the traits, whose update_energy() and update_jacobian() are checked; they are evaluated at x again when returning
+        //  x               the solution to check at
+        //  blockStart      the first residual of every block (e.g., of every energy term), in increasing order, where the errors are reported separately; empty for a single block
+        //  numThreads      the colors are divided between the threads, with a copy of Traits for every additional thread. The default is a single thread. More threads need traits whose copies are independent (deep-copy semantics): traits that hold pointers to objects they change while evaluating (e.g., AugmentedLagrangianTraits, whose copies share the ConstraintTraits) would be changed by all the threads at once.
+        //  verbose         prints the largest discrepancies and the summary per block
         template<class SolverTraits>
-        void check_traits(SolverTraits& Traits){
+        TraitsCheckResult check_traits(SolverTraits& Traits,
+                                       const Eigen::VectorXd& x,
+                                       const Eigen::VectorXi& blockStart=Eigen::VectorXi(),
+                                       const int numThreads=1,
+                                       const bool verbose=true){
             using namespace Eigen;
             using namespace std;
-            cout<<"WARNING: FE gradient checking, reducing performance!!!"<<endl;
-            cout<<"******************************************************"<<endl;
-            VectorXd CurrSolution(Traits.xSize);
-            CurrSolution<<VectorXd::Random(Traits.xSize, 1);
-            
-            cout<<"Solution Size: "<<Traits.xSize<<endl;
-            
-            Traits.update_energy(CurrSolution);
-            Traits.update_jacobian(CurrSolution);
-         
-            int MaxRow=Traits.JRows.maxCoeff()+1;
-            vector<Triplet<double> > GradTris;
-            
-            for (int i=0;i<Traits.JRows.size();i++)
-                GradTris.push_back(Triplet<double>(Traits.JRows(i), Traits.JCols(i), Traits.JVals(i)));
-            
-            
-            SparseMatrix<double> TraitGradient(MaxRow, CurrSolution.size());
-            TraitGradient.setFromTriplets(GradTris.begin(),GradTris.end());
-            
-            SparseMatrix<double> FEGradient(MaxRow, CurrSolution.size());
-            vector<Triplet<double> > FEGradientTris;
-            for (int i=0;i<CurrSolution.size();i++){
-                VectorXd vh(CurrSolution.size()); vh.setZero(); vh(i)=10e-5;
-                Traits.update_energy(CurrSolution+vh);
-                Traits.update_jacobian(CurrSolution+vh);
-                VectorXd EnergyPlus=Traits.EVec;
-                Traits.update_energy(CurrSolution-vh);
-                Traits.update_jacobian(CurrSolution-vh);
-                VectorXd EnergyMinus=Traits.EVec;
-                VectorXd CurrGradient=(EnergyPlus-EnergyMinus)/(2*10e-5);
-                //cout<<CurrGradient<<endl;
-                for (int j=0;j<CurrGradient.size();j++)
-                    if (abs(CurrGradient(j))>10e-7)
-                        FEGradientTris.push_back(Triplet<double>(j,i,CurrGradient(j)));
+            const double h=10e-5;
+            const double tolerance=10e-7;
+            const int maxPrinted=20;
+
+            Traits.update_energy(x);
+            Traits.update_jacobian(x);
+            const int numRows=Traits.EVec.size();
+
+            VectorXi blocks=blockStart;
+            if (blocks.size()==0)
+                blocks=VectorXi::Zero(1);
+            else if (blocks(0)!=0){
+                blocks.resize(blockStart.size()+1);
+                blocks<<0, blockStart;
             }
-            
-            FEGradient.setFromTriplets(FEGradientTris.begin(), FEGradientTris.end());
-            SparseMatrix<double> DiffMat=FEGradient-TraitGradient;
-            double maxcoeff=-32767.0;
-            int Maxi,Maxj;
-            for (int k=0; k<DiffMat.outerSize(); ++k)
-                for (SparseMatrix<double>::InnerIterator it(DiffMat,k); it; ++it){
-                    if (maxcoeff<abs(it.value())){
-                        maxcoeff=abs(it.value());
-                        Maxi=it.row();
-                        Maxj=it.col();
-                        
+            const int numBlocks=blocks.size();
+            VectorXi rowBlock(numRows);
+            for (int b=0;b<numBlocks;b++)
+                rowBlock.segment(blocks(b), (b==numBlocks-1 ? numRows : blocks(b+1))-blocks(b)).setConstant(b);
+
+            VectorXi colors;
+            int numColors=color_jacobian_columns(Traits.JRows, Traits.JCols, numRows, Traits.xSize, colors);
+
+            //the variables of every color, and the entries of every variable
+            VectorXi colorStart=VectorXi::Zero(numColors+1), colStart=VectorXi::Zero(Traits.xSize+1);
+            for (int i=0;i<Traits.xSize;i++)
+                colorStart(colors(i)+1)++;
+            for (int i=0;i<Traits.JCols.size();i++)
+                colStart(Traits.JCols(i)+1)++;
+            for (int i=0;i<numColors;i++)
+                colorStart(i+1)+=colorStart(i);
+            for (int i=0;i<Traits.xSize;i++)
+                colStart(i+1)+=colStart(i);
+            VectorXi colorVariables(Traits.xSize), colEntries(Traits.JCols.size());
+            VectorXi colorPos=colorStart.head(numColors), colPos=colStart.head(Traits.xSize);
+            for (int i=0;i<Traits.xSize;i++)
+                colorVariables(colorPos(colors(i))++)=i;
+            for (int i=0;i<Traits.JCols.size();i++)
+                colEntries(colPos(Traits.JCols(i))++)=i;
+            const VectorXd JVals=Traits.JVals;
+
+            //the per-thread state: a copy of the traits (the first thread uses Traits itself) and the partial results
+            int numChunks=std::max(1, std::min(numThreads, numColors));
+            std::vector<SolverTraits> threadTraits(numChunks-1, Traits);
+            std::vector<VectorXd> threadMaxError(numChunks, VectorXd::Constant(numBlocks, -1.0));
+            std::vector<VectorXi> threadMaxRow(numChunks, VectorXi::Constant(numBlocks, -1)), threadMaxCol(numChunks, VectorXi::Constant(numBlocks, -1));
+            std::vector<VectorXi> threadUndeclared(numChunks, VectorXi::Zero(numBlocks));
+            std::vector<std::vector<Vector4d> > threadReports(numChunks);  //(row, col, J, FD) of the discrepancies, or col=-1 for undeclared changes
+
+            parallel_for(numColors, [&](const int begin, const int end, const int t){
+                SolverTraits& currTraits=(t==0 ? Traits : threadTraits[t-1]);
+                VectorXd currx=x;
+                VectorXd declared=VectorXd::Zero(numRows);
+                VectorXi rowMarks=VectorXi::Constant(numRows, -1);
+                for (int color=begin;color<end;color++){
+                    for (int i=colorStart(color);i<colorStart(color+1);i++)
+                        currx(colorVariables(i))=x(colorVariables(i))+h;
+                    currTraits.update_energy(currx);
+                    VectorXd EnergyPlus=currTraits.EVec;
+                    for (int i=colorStart(color);i<colorStart(color+1);i++)
+                        currx(colorVariables(i))=x(colorVariables(i))-h;
+                    currTraits.update_energy(currx);
+                    VectorXd FDGradient=(EnergyPlus-currTraits.EVec)/(2*h);
+                    for (int i=colorStart(color);i<colorStart(color+1);i++)
+                        currx(colorVariables(i))=x(colorVariables(i));
+
+                    for (int i=colorStart(color);i<colorStart(color+1);i++){
+                        int col=colorVariables(i);
+                        //repeated entries are summed, as in the solvers
+                        for (int j=colStart(col);j<colStart(col+1);j++)
+                            declared(Traits.JRows(colEntries(j)))+=JVals(colEntries(j));
+                        for (int j=colStart(col);j<colStart(col+1);j++){
+                            int row=Traits.JRows(colEntries(j));
+                            if (rowMarks(row)==color)
+                                continue;
+                            rowMarks(row)=color;
+                            double error=std::abs(FDGradient(row)-declared(row))/std::max(1.0, std::abs(declared(row)));
+                            int b=rowBlock(row);
+                            if (error>threadMaxError[t](b)){
+                                threadMaxError[t](b)=error;
+                                threadMaxRow[t](b)=row;
+                                threadMaxCol[t](b)=col;
+                            }
+                            if ((error>tolerance)&&((int)threadReports[t].size()<maxPrinted))
+                                threadReports[t].push_back(Vector4d(row, col, declared(row), FDGradient(row)));
+                        }
+                        for (int j=colStart(col);j<colStart(col+1);j++)
+                            declared(Traits.JRows(colEntries(j)))=0.0;
+                    }
+
+                    for (int row=0;row<numRows;row++){
+                        if ((rowMarks(row)==color)||(std::abs(FDGradient(row))<=tolerance))
+                            continue;
+                        threadUndeclared[t](rowBlock(row))++;
+                        if ((int)threadReports[t].size()<maxPrinted)
+                            threadReports[t].push_back(Vector4d(row, -1, color, FDGradient(row)));
                     }
-                    if (abs(it.value())>10e-7){
-                        cout<<"Gradient Discrepancy at: ("<<it.row()<<","<<it.col()<<") of "<<it.value()<<endl;
-                        cout<<"Our Value: "<<TraitGradient.coeffRef(it.row(), it.col())<<endl;
-                        cout<<"Computed Value: "<<FEGradient.coeffRef(it.row(), it.col())<<endl;
+                }
+            }, numThreads, 1);
+
+            //combining the threads in order, so that the result does not depend on their timing
+            TraitsCheckResult result;
+            result.numColors=numColors;
+            result.maxRelativeError=VectorXd::Zero(numBlocks);
+            result.maxErrorRow=VectorXi::Constant(numBlocks, -1);
+            result.maxErrorCol=VectorXi::Constant(numBlocks, -1);
+            result.numUndeclared=VectorXi::Zero(numBlocks);
+            for (int t=0;t<numChunks;t++){
+                for (int b=0;b<numBlocks;b++){
+                    if (threadMaxError[t](b)>result.maxRelativeError(b)||((result.maxErrorRow(b)==-1)&&(threadMaxRow[t](b)!=-1))){
+                        result.maxRelativeError(b)=threadMaxError[t](b);
+                        result.maxErrorRow(b)=threadMaxRow[t](b);
+                        result.maxErrorCol(b)=threadMaxCol[t](b);
                     }
                 }
-            cout<<"Maximum gradient difference: "<<maxcoeff<<endl;
-            cout<<"At Location: ("<<Maxi<<","<<Maxj<<")"<<endl;
-            
-            
+                result.numUndeclared+=threadUndeclared[t];
+            }
+            result.maxError=result.maxRelativeError.maxCoeff();
+
+            Traits.update_energy(x);
+            Traits.update_jacobian(x);
+
+            if (verbose){
+                cout<<"Finite-difference gradient checking of "<<Traits.xSize<<" variables in "<<numColors<<" colors"<<endl;
+                int numPrinted=0;
+                for (int t=0;t<numChunks;t++){
+                    for (size_t i=0;(i<threadReports[t].size())&&(numPrinted<maxPrinted);i++,numPrinted++){
+                        const Vector4d& report=threadReports[t][i];
+                        if (report(1)>=0)
+                            cout<<"Gradient Discrepancy at: ("<<(int)report(0)<<","<<(int)report(1)<<"), Our Value: "<<report(2)<<", Computed Value: "<<report(3)<<endl;
+                        else
+                            cout<<"Undeclared dependency of residual "<<(int)report(0)<<" on a variable of color "<<(int)report(2)<<", Computed Value: "<<report(3)<<endl;
+                    }
+                }
+                for (int b=0;b<numBlocks;b++){
+                    cout<<"Block "<<b<<" (residuals from "<<blocks(b)<<"): maximum relative difference "<<result.maxRelativeError(b);
+                    if (result.maxErrorRow(b)!=-1)
+                        cout<<" at ("<<result.maxErrorRow(b)<<","<<result.maxErrorCol(b)<<")";
+                    cout<<", "<<result.numUndeclared(b)<<" undeclared dependencies"<<endl;
+                }
+            }
+            return result;
+        }
+
+        //checks at a random solution
+        template<class SolverTraits>
+        TraitsCheckResult check_traits(SolverTraits& Traits,
+                                       const Eigen::VectorXi& blockStart=Eigen::VectorXi(),
+                                       const int numThreads=1,
+                                       const bool verbose=true){
+            Eigen::VectorXd CurrSolution=Eigen::VectorXd::Random(Traits.xSize);
+            return check_traits(Traits, CurrSolution, blockStart, numThreads, verbose);
         }
     }
 }
@@ -12,6 +12,7 @@
 #include <Eigen/Sparse>
 #include <hedra/Moebius2DEdgeDeviationTraits.h>
 #include <hedra/EigenSolverWrapper.h>
+#include <hedra/CachedOrdering.h>
 #include <hedra/LMSolver.h>
 //#include <hedra/complex_cross_ratio.h>
 
@@ -74,9 +75,9 @@ namespace hedra{
     VectorXcd complexConstPoses;
     
     //optimization operators
-    hedra::optimization::EigenSolverWrapper<Eigen::SimplicialLLT<Eigen::SparseMatrix<double> > > deformLinearSolver;
+    hedra::optimization::EigenSolverWrapper<Eigen::SimplicialLLT<Eigen::SparseMatrix<double>, Eigen::Lower, hedra::optimization::CachedOrdering<Eigen::AMDOrdering<int> > > > deformLinearSolver;
     hedra::optimization::Moebius2DEdgeDeviationTraits deformTraits;
-    hedra::optimization::LMSolver<hedra::optimization::EigenSolverWrapper<Eigen::SimplicialLLT<Eigen::SparseMatrix<double> > >,hedra::optimization::Moebius2DEdgeDeviationTraits> deformSolver;
+    hedra::optimization::LMSolver<hedra::optimization::EigenSolverWrapper<Eigen::SimplicialLLT<Eigen::SparseMatrix<double>, Eigen::Lower, hedra::optimization::CachedOrdering<Eigen::AMDOrdering<int> > > >,hedra::optimization::Moebius2DEdgeDeviationTraits> deformSolver;
     
   };
   
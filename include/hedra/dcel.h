@@ -9,8 +9,11 @@
 #define HEDRA_DCEL_H
 
 #include <igl/igl_inline.h>
+#include <hedra/PolygonMesh.h>
+#include <hedra/parallel_for.h>
 #include <Eigen/Core>
 #include <vector>
+#include <atomic>
 
 
 namespace hedra
@@ -20,8 +23,7 @@ namespace hedra
     // and traversing, and the data structure is again only Eigen vectors and matrices.
     
     //input:
-    //  D           #F by 1 - face degrees
-    //  F           #F by max(D) - vertex indices in face
+    //  P           PolygonMesh or PaddedPolygons (see PolygonMesh.h)
     //  EV          #E by 2 - edge vertex indices
     //  EF          #E by 2 - edge face indices (EF(i,0) is left face, EF(i,1)=-1 if boundary
     //  EFi         #E by 2 - position of edge in face by EF
@@ -29,98 +31,130 @@ namespace hedra
     
     // Output:
     // the number of halfedges can be determined by H=|HV/HE/HF|. It is 2*[Inner edges]+[Boundary Edges]
-    // VH   #V by 1 - Vertex to outgoing halfedge (into HE)
+    // VH   #V by 1 - Vertex to outgoing halfedge (into HE), or -1 for unreferenced vertices
     // EH   #E by 2 - edge to halfedge, where EH(i,0) halfedge is positively oriented, and EH(i,1)=-1 when boundary.
-    // FH   #F by max(D) - face to (correctly oriented) halfedge s.t. the origin vertex of FH(i,j) is F(i,j)
+    // FH   per-corner (P.corner(i,j)) face to (correctly oriented) halfedge s.t. the origin vertex of FH at corner (i,j) is vertex j of face i; #F by max(D) for PaddedPolygons, sum(D) by 1 for PolygonMesh
     // HV   #H by 1 - origin vertex of the halfedge
     // HE   #H by 1 - edge carrying this halfedge. It does not say which direction.
     // HF   #F by 1 - face containing halfedge
     // nextH, prevH, twinH - #H by 1 DCEL traversing operations. twinH(i)=-1 for boundary edges.
+    // numThreads: the loops run in parallel chunks, with results identical to the serial run.
     
-    IGL_INLINE void dcel(const Eigen::MatrixXi& D,
-                         const Eigen::MatrixXi& F,
+    template<class Polygons, typename DerivedFH>
+    IGL_INLINE void dcel(const Polygons& P,
                          const Eigen::MatrixXi& EV,
                          const Eigen::MatrixXi& EF,
                          const Eigen::MatrixXi& EFi,
                          const Eigen::VectorXi& innerEdges,
                          Eigen::VectorXi& VH,
                          Eigen::MatrixXi& EH,
-                         Eigen::MatrixXi& FH,
+                         Eigen::PlainObjectBase<DerivedFH>& FH,
                          Eigen::VectorXi& HV,
                          Eigen::VectorXi& HE,
                          Eigen::VectorXi& HF,
                          Eigen::VectorXi& nextH,
                          Eigen::VectorXi& prevH,
-                         Eigen::VectorXi& twinH)
+                         Eigen::VectorXi& twinH,
+                         const int numThreads=1)
     {
         //doing a local halfedge structure for polygonal meshes
-        EH=Eigen::MatrixXi::Constant(EV.rows(),2,-1);
-        int numH=0;
-        
-        for (int i=0;i<EF.rows();i++){
-            if (EF(i,0)!=-1)
-                EH(i,0)=numH++;
-            if (EF(i,1)!=-1)
-                EH(i,1)=numH++;
-        }
+        //the halfedges are numbered in the order of the edges, so each chunk of edges numbers its halfedges from a prefix sum over the previous chunks, and every loop below writes disjoint entries
+        const int numE=EV.rows();
+        EH=Eigen::MatrixXi::Constant(numE,2,-1);
+        std::vector<int> chunkH(std::max(numThreads,1)+1,0);
+        hedra::parallel_for(numE, [&](const int begin, const int end, const int threadIndex){
+            for (int i=begin;i<end;i++)
+                chunkH[threadIndex+1]+=(EF(i,0)!=-1)+(EF(i,1)!=-1);
+        }, numThreads);
+        for (size_t t=0;t+1<chunkH.size();t++)
+            chunkH[t+1]+=chunkH[t];
+        const int numH=chunkH.back();
         
+        hedra::parallel_for(numE, [&](const int begin, const int end, const int threadIndex){
+            int currH=chunkH[threadIndex];
+            for (int i=begin;i<end;i++){
+                if (EF(i,0)!=-1)
+                    EH(i,0)=currH++;
+                if (EF(i,1)!=-1)
+                    EH(i,1)=currH++;
+            }
+        }, numThreads);
         
-        //halfedges to edge
+        //halfedges to edge, vertex, twin and face, and faces to halfedges
         HE.conservativeResize(numH);
-        for (int i=0;i<EH.rows();i++){
-            if (EH(i,0)!=-1)
-                HE(EH(i,0))=i;
-            if (EH(i,1)!=-1)
-                HE(EH(i,1))=i;
-        }
-        
-        //halfedge to vertex and vice versa
         HV.conservativeResize(numH);
-        VH.conservativeResize(EV.maxCoeff()+1);
-        for (int i=0;i<EV.rows();i++){
-            if (EH(i,0)!=-1){
-                HV(EH(i,0))=EV(i,0);
-                VH(EV(i,0))=EH(i,0);
-            }
-            if (EH(i,1)!=-1){
-                HV(EH(i,1))=EV(i,1);
-                VH(EV(i,1))=EH(i,1);
-            }
-        }
-        
-        //halfedge to twin
+        HF.resize(numH);
         twinH=Eigen::VectorXi::Constant(numH, -1);
-        for (int i=0;i<EH.rows();i++)
-            if ((EH(i,0)!=-1)&&(EH(i,1)!=-1)){
-                twinH(EH(i,0))=EH(i,1);
-                twinH(EH(i,1))=EH(i,0);
+        FH.resize(P.corner_rows(), P.corner_cols());
+        hedra::parallel_for(numE, [&](const int begin, const int end, const int threadIndex){
+            for (int i=begin;i<end;i++){
+                for (int k=0;k<2;k++){
+                    if (EH(i,k)==-1)
+                        continue;
+                    HE(EH(i,k))=i;
+                    HV(EH(i,k))=EV(i,k);
+                    HF(EH(i,k))=EF(i,k);
+                    FH.coeffRef(P.corner(EF(i,k),EFi(i,k)))=EH(i,k);
+                }
+                if ((EH(i,0)!=-1)&&(EH(i,1)!=-1)){
+                    twinH(EH(i,0))=EH(i,1);
+                    twinH(EH(i,1))=EH(i,0);
+                }
             }
+        }, numThreads);
         
-        //faces to halfedges and vice versa
-        FH.resize(F.rows(), F.cols());
-        HF.resize(numH);
-        for (int i=0;i<EF.rows();i++){
-            if (EF(i,0)!=-1){
-                FH(EF(i,0),EFi(i,0))=EH(i,0);
-                HF(EH(i,0))=EF(i,0);
-            }
-            if (EF(i,1)!=-1){
-                FH(EF(i,1),EFi(i,1))=EH(i,1);
-                HF(EH(i,1))=EF(i,1);
+        //vertex to (the last) outgoing halfedge
+        VH.conservativeResize(EV.maxCoeff()+1);
+        std::vector<std::atomic<int> > lastH(VH.size());
+        for (int v=0;v<VH.size();v++)
+            lastH[v].store(-1, std::memory_order_relaxed);
+        hedra::parallel_for(numH, [&](const int begin, const int end, const int threadIndex){
+            for (int h=begin;h<end;h++){
+                int prevMax=lastH[HV(h)].load(std::memory_order_relaxed);
+                while ((prevMax<h)&&(!lastH[HV(h)].compare_exchange_weak(prevMax, h, std::memory_order_relaxed)));
             }
-        }
+        }, numThreads);
+        for (int v=0;v<VH.size();v++)
+            VH(v)=lastH[v].load(std::memory_order_relaxed);  //-1 for vertices that are not in any face
         
         //halfedge to next and prev
         nextH.conservativeResize(HE.rows());
         prevH.conservativeResize(HE.rows());
-        for (int i=0;i<D.rows();i++){
-            for (int j=0;j<D(i);j++){
-                nextH(FH(i,j))=FH(i,(j+1)%D(i));
-                prevH(FH(i,(j+1)%D(i)))=FH(i,j);
+        hedra::parallel_for(P.num_faces(), [&](const int begin, const int end, const int threadIndex){
+            for (int i=begin;i<end;i++){
+                for (int j=0;j<P.degree(i);j++){
+                    const int currH=FH.coeff(P.corner(i,j));
+                    const int nextFH=FH.coeff(P.corner(i,(j+1)%P.degree(i)));
+                    nextH(currH)=nextFH;
+                    prevH(nextFH)=currH;
+                }
             }
-        }
+        }, numThreads);
         
     }
+    
+    //input:
+    //  D           #F by 1 - face degrees
+    //  F           #F by max(D) - vertex indices in face
+    //  rest as above, where FH is #F by max(D) - FH(i,j) has origin vertex F(i,j)
+    IGL_INLINE void dcel(const Eigen::MatrixXi& D,
+                         const Eigen::MatrixXi& F,
+                         const Eigen::MatrixXi& EV,
+                         const Eigen::MatrixXi& EF,
+                         const Eigen::MatrixXi& EFi,
+                         const Eigen::VectorXi& innerEdges,
+                         Eigen::VectorXi& VH,
+                         Eigen::MatrixXi& EH,
+                         Eigen::MatrixXi& FH,
+                         Eigen::VectorXi& HV,
+                         Eigen::VectorXi& HE,
+                         Eigen::VectorXi& HF,
+                         Eigen::VectorXi& nextH,
+                         Eigen::VectorXi& prevH,
+                         Eigen::VectorXi& twinH)
+    {
+        dcel(PaddedPolygons(D,F), EV, EF, EFi, innerEdges, VH, EH, FH, HV, HE, HF, nextH, prevH, twinH);
+    }
 
 }
 
@@ -0,0 +1,45 @@
+// This file is part of libhedra, a library for polyhedral mesh processing
+//
+// Copyright (C) 2016 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+#ifndef HEDRA_HEDRA_OFF_CONVERSION_H
+#define HEDRA_HEDRA_OFF_CONVERSION_H
+#include <igl/igl_inline.h>
+#include <hedra/polygonal_read_OFF.h>
+#include <hedra/polygonal_write_OFF.h>
+#include <hedra/MappedHedraMesh.h>
+#include <hedra/polygonal_write_hedra.h>
+#include <Eigen/Core>
+#include <string>
+
+namespace hedra
+{
+    // converts an ascii OFF file to a binary .hedra file, optionally with the cached connectivity (see polygonal_write_hedra)
+    IGL_INLINE bool convert_OFF_to_hedra(const std::string OFFFileName,
+                                         const std::string hedraFileName,
+                                         const bool cacheConnectivity=false)
+    {
+        Eigen::MatrixXd V;
+        Eigen::VectorXi D;
+        Eigen::MatrixXi F;
+        if (!hedra::polygonal_read_OFF(OFFFileName, V, D, F))
+            return false;
+        return hedra::polygonal_write_hedra(hedraFileName, V, D, F, cacheConnectivity);
+    }
+
+    // converts a binary .hedra file to an ascii OFF file, writing directly from the mapped file
+    IGL_INLINE bool convert_hedra_to_OFF(const std::string hedraFileName,
+                                         const std::string OFFFileName)
+    {
+        MappedHedraMesh mappedMesh;
+        if (!mappedMesh.open(hedraFileName))
+            return false;
+        return hedra::polygonal_write_OFF(OFFFileName, mappedMesh.V(), mappedMesh.polygons());
+    }
+}
+
+
+#endif
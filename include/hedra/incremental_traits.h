@@ -0,0 +1,139 @@
+// This file is part of libhedra, a library for polyhedral mesh processing
+//
+// Copyright (C) 2016 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+#ifndef HEDRA_INCREMENTAL_TRAITS_H
+#define HEDRA_INCREMENTAL_TRAITS_H
+#include <igl/igl_inline.h>
+#include <Eigen/Core>
+#include <type_traits>
+#include <vector>
+#include <cmath>
+
+namespace hedra { namespace optimization {
+
+    //Tells the solvers that a SolverTraits also implements partial updates:
+    //  update_energy(x, changedVariables) and update_jacobian(x, changedVariables)
+    //where EVec (resp. JVals) were computed by an earlier update_energy() (resp. update_jacobian()) call, and x only differs from the solution of that call in changedVariables. The traits then only recompute the residuals (rows of J) that depend on changedVariables.
+    //Any other change of state between the calls (e.g., of weights by post_iteration()) is the responsibility of the traits, and pre_iteration() and post_iteration() must not recompute EVec or JVals themselves; the solvers start over with full updates in every big iteration.
+    //The solvers only use the partial updates with a non-negative threshold (e.g., LMSolver::incrementalThreshold), which is useful when only a part of the solution moves, as when dragging a handle.
+    //Incremental traits specialize this to std::true_type.
+    template<class SolverTraits>
+    struct is_incremental : std::false_type {};
+
+    //The adjacency from every variable to the residuals (rows of J) that depend on it, as the sorted rows varRows(varRowStart(v)..varRowStart(v+1)-1) of variable v.
+    //Input:
+    //  JRows, JCols  the Jacobian pattern
+    //  xSize         the number of variables
+    //Output:
+    //  varRowStart   xSize+1 offsets into varRows
+    //  varRows       the residual indices, without repetitions
+    IGL_INLINE void variable_residual_adjacency(const Eigen::VectorXi& JRows,
+                                                const Eigen::VectorXi& JCols,
+                                                const int xSize,
+                                                Eigen::VectorXi& varRowStart,
+                                                Eigen::VectorXi& varRows)
+    {
+        //counting sort of the entries by column, which keeps the rows of every column in the order of the entries
+        Eigen::VectorXi colStart=Eigen::VectorXi::Zero(xSize+1);
+        for (int i=0;i<JCols.size();i++)
+            colStart(JCols(i)+1)++;
+        for (int v=0;v<xSize;v++)
+            colStart(v+1)+=colStart(v);
+        Eigen::VectorXi colRows(JCols.size());
+        Eigen::VectorXi position=colStart.head(xSize);
+        for (int i=0;i<JCols.size();i++)
+            colRows(position(JCols(i))++)=JRows(i);
+
+        //removing repeated rows of a variable (e.g., the real and imaginary parts of the same residual)
+        varRowStart.resize(xSize+1);
+        varRows.resize(JCols.size());
+        int numEntries=0;
+        for (int v=0;v<xSize;v++){
+            varRowStart(v)=numEntries;
+            for (int i=colStart(v);i<colStart(v+1);i++){
+                bool isRepeated=false;
+                for (int j=varRowStart(v);j<numEntries;j++)
+                    if (varRows(j)==colRows(i)){
+                        isRepeated=true;
+                        break;
+                    }
+                if (!isRepeated)
+                    varRows(numEntries++)=colRows(i);
+            }
+        }
+        varRowStart(xSize)=numEntries;
+        varRows.conservativeResize(numEntries);
+    }
+
+    //The residuals that depend on any of the changed variables.
+    //Input:
+    //  changedVariables        indices into the solution
+    //  varRowStart, varRows    from variable_residual_adjacency()
+    //  rowMarks                of the size of the residuals, all 0 (they are reset before returning)
+    //Output:
+    //  dirtyRows               each dirty residual once, in no particular order
+    IGL_INLINE void dirty_residuals(const Eigen::VectorXi& changedVariables,
+                                    const Eigen::VectorXi& varRowStart,
+                                    const Eigen::VectorXi& varRows,
+                                    std::vector<char>& rowMarks,
+                                    std::vector<int>& dirtyRows)
+    {
+        dirtyRows.clear();
+        for (int i=0;i<changedVariables.size();i++){
+            int v=changedVariables(i);
+            for (int j=varRowStart(v);j<varRowStart(v+1);j++){
+                if (!rowMarks[varRows(j)]){
+                    rowMarks[varRows(j)]=1;
+                    dirtyRows.push_back(varRows(j));
+                }
+            }
+        }
+        for (size_t i=0;i<dirtyRows.size();i++)
+            rowMarks[dirtyRows[i]]=0;
+    }
+
+    //Keeps, for a solver, the value of every variable when the residuals depending on it were last recomputed, and finds the variables that changed by more than a threshold since.
+    //The error of a partial update is thus bounded by the threshold, and does not accumulate over iterations; a threshold of 0 gives the same values as full updates.
+    class IncrementalTracker{
+    public:
+        Eigen::VectorXd refx;   //the value of every variable at its last recomputation
+        bool isValid;           //false before the first (full) update
+
+        IncrementalTracker():isValid(false){}
+
+        void reset(){isValid=false;}
+
+        //returns false if everything must be updated (the first time after reset()); otherwise changedVariables holds the changed variables, whose reference values are updated to x
+        bool changed_variables(const Eigen::VectorXd& x,
+                               const double threshold,
+                               Eigen::VectorXi& changedVariables)
+        {
+            if ((!isValid)||(refx.size()!=x.size())){
+                refx=x;
+                isValid=true;
+                return false;
+            }
+            int numChanged=0;
+            for (int i=0;i<x.size();i++)
+                if (std::abs(x(i)-refx(i))>threshold)
+                    numChanged++;
+            changedVariables.resize(numChanged);
+            numChanged=0;
+            for (int i=0;i<x.size();i++){
+                if (std::abs(x(i)-refx(i))>threshold){
+                    changedVariables(numChanged++)=i;
+                    refx(i)=x(i);
+                }
+            }
+            return true;
+        }
+    };
+
+} }
+
+
+#endif
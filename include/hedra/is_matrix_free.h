@@ -0,0 +1,24 @@
+// This file is part of libhedra, a library for polyhedral mesh processing
+//
+// Copyright (C) 2016 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+#ifndef HEDRA_IS_MATRIX_FREE_H
+#define HEDRA_IS_MATRIX_FREE_H
+#include <type_traits>
+
+namespace hedra { namespace optimization {
+
+    //Tells the solvers which interface a LinearSolver implements:
+    //  false (default): analyze(HRows, HCols, Symmetric), factorize(HVals, Symmetric), solve(rhs, x) on the assembled H=J^T*J(+miu*I).
+    //  true: analyze_jacobian(JRows, JCols, xSize), factorize_jacobian(JVals, miu), solve(rhs, x), where H is never assembled.
+    //Matrix-free linear solvers specialize this to std::true_type.
+    template<class LinearSolver>
+    struct is_matrix_free : std::false_type {};
+
+} }
+
+
+#endif
@@ -0,0 +1,148 @@
+// This file is part of libhedra, a library for polyhedral mesh processing
+//
+// Copyright (C) 2016 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+#ifndef HEDRA_JACOBIAN_KERNELS_H
+#define HEDRA_JACOBIAN_KERNELS_H
+#include <igl/igl_inline.h>
+#include <hedra/parallel_for.h>
+#include <Eigen/Core>
+
+//Multithreaded kernels for the Jacobian products that the LM/TR/GN/SL solvers compute every iteration, and the shared pattern of their normal equations. All of them are deterministic and give bitwise-identical results for every number of threads.
+
+namespace hedra { namespace optimization {
+
+    // Computes the column-sorted permutation of the (row, col) representation of a sparse matrix, so that M^T*v can be computed column by column without write conflicts.
+    // The sort is stable, so every column keeps the entries in their original order, and the products sum in the same order as the serial scatter.
+    // Inputs:
+    //  iJ          #nnz column indices
+    //  numCols     the number of columns of M
+    // Outputs:
+    //  colStart    numCols+1 offsets into colPerm of each column
+    //  colPerm     #nnz entry indices, sorted by columns
+    IGL_INLINE void adjoint_gather_pattern(const Eigen::VectorXi& iJ,
+                                           const int numCols,
+                                           Eigen::VectorXi& colStart,
+                                           Eigen::VectorXi& colPerm)
+    {
+        colStart=Eigen::VectorXi::Zero(numCols+1);
+        for (int i=0;i<iJ.size();i++)
+            colStart(iJ(i)+1)++;
+        for (int i=0;i<numCols;i++)
+            colStart(i+1)+=colStart(i);
+
+        Eigen::VectorXi currPos=colStart.head(numCols);
+        colPerm.resize(iJ.size());
+        for (int i=0;i<iJ.size();i++)
+            colPerm(currPos(iJ(i))++)=i;
+    }
+
+    // Computes the pattern of M^T*M+miu*I, the normal equations of the LM/TR solvers, from the pattern of M. Only the upper triangle is stored, and the last numCols entries are the diagonal for miu.
+    // Inputs:
+    //  iI, iJ      #nnz (row, col) pattern of M, sorted by rows (not necessarily columns)
+    // Outputs:
+    //  oI, oJ      (row, col) pattern of M^T*M+miu*I
+    //  S2D         the pairs of entries of M whose product is aggregated into each of the first S2D.rows() entries of oI, oJ (Single2Double)
+    IGL_INLINE void normal_equations_pattern(const Eigen::VectorXi& iI,
+                                             const Eigen::VectorXi& iJ,
+                                             Eigen::VectorXi& oI,
+                                             Eigen::VectorXi& oJ,
+                                             Eigen::MatrixXi& S2D)
+    {
+        //counting the pairs in every row, and then filling them
+        int numPairs=0;
+        int currTri=0;
+        do{
+            int numCurrTris=0;
+            while ((currTri+numCurrTris<iI.size())&&(iI(currTri+numCurrTris)==iI(currTri)))
+                numCurrTris++;
+            for (int i=currTri;i<currTri+numCurrTris;i++)
+                for (int j=currTri;j<currTri+numCurrTris;j++)
+                    if (iJ(j)>=iJ(i))
+                        numPairs++;
+            currTri+=numCurrTris;
+        }while (currTri!=iI.size());
+        
+        int numCols=iJ.maxCoeff()+1;
+        oI.resize(numPairs+numCols);
+        oJ.resize(numPairs+numCols);
+        S2D.resize(numPairs,2);
+        
+        int counter=0;
+        currTri=0;
+        do{
+            int numCurrTris=0;
+            while ((currTri+numCurrTris<iI.size())&&(iI(currTri+numCurrTris)==iI(currTri)))
+                numCurrTris++;
+            for (int i=currTri;i<currTri+numCurrTris;i++){
+                for (int j=currTri;j<currTri+numCurrTris;j++){
+                    if (iJ(j)>=iJ(i)){
+                        oI(counter)=iJ(i);
+                        oJ(counter)=iJ(j);
+                        S2D.row(counter++)<<i,j;
+                    }
+                }
+            }
+            currTri+=numCurrTris;
+        }while (currTri!=iI.size());
+        
+        //triplets for miu
+        for (int i=0;i<numCols;i++){
+            oI(numPairs+i)=i;
+            oJ(numPairs+i)=i;
+        }
+    }
+    
+    // Computes the values oS(i)=iS(S2D(i,0))*iS(S2D(i,1)) of M^T*M from the single-to-double map of normal_equations_pattern(), in parallel.
+    // prerequisite - oS is allocated to at least S2D.rows()
+    IGL_INLINE void matrix_values(const Eigen::VectorXd& iS,
+                                  const Eigen::MatrixXi& S2D,
+                                  const int numThreads,
+                                  Eigen::VectorXd& oS)
+    {
+        hedra::parallel_for(S2D.rows(), [&](const int begin, const int end, const int threadIndex){
+            for (int i=begin;i<end;i++)
+                oS(i)=iS(S2D(i,0))*iS(S2D(i,1));
+        }, numThreads);
+    }
+
+    // Computes the values of M^T*M+miu*I in the pattern of normal_equations_pattern().
+    // prerequisite - oS is allocated to the size of its oI
+    IGL_INLINE void normal_equations_values(const Eigen::VectorXd& iS,
+                                            const Eigen::MatrixXi& S2D,
+                                            const double miu,
+                                            const int numThreads,
+                                            Eigen::VectorXd& oS)
+    {
+        matrix_values(iS, S2D, numThreads, oS);
+        for (int i=S2D.rows();i<oS.size();i++)
+            oS(i)=miu;
+    }
+
+    // Computes oVec=M^T*iVec for M in (iI, iJ, iS) representation, in parallel over the columns, using the gather pattern from adjoint_gather_pattern().
+    // prerequisite - oVec is allocated to colStart.size()-1
+    IGL_INLINE void multiply_adjoint_vector(const Eigen::VectorXi& iI,
+                                            const Eigen::VectorXd& iS,
+                                            const Eigen::VectorXd& iVec,
+                                            const Eigen::VectorXi& colStart,
+                                            const Eigen::VectorXi& colPerm,
+                                            const int numThreads,
+                                            Eigen::VectorXd& oVec)
+    {
+        hedra::parallel_for(colStart.size()-1, [&](const int begin, const int end, const int threadIndex){
+            for (int c=begin;c<end;c++){
+                double sum=0.0;
+                for (int k=colStart(c);k<colStart(c+1);k++)
+                    sum+=iS(colPerm(k))*iVec(iI(colPerm(k)));
+                oVec(c)=sum;
+            }
+        }, numThreads);
+    }
+
+} }
+
+
+#endif
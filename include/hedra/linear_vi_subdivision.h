@@ -9,6 +9,7 @@
 #define HEDRA_LINEAR_VI_SUBDIVISION_H
 #include <igl/igl_inline.h>
 #include <hedra/vertex_valences.h>
+#include <hedra/build_connectivity.h>
 #include <hedra/polygonal_edge_topology.h>
 #include <hedra/dcel.h>
 #include <hedra/subdivision_basics.h>
@@ -27,9 +28,7 @@ namespace hedra
     
     void setup(const Eigen::MatrixXd& _V, const Eigen::VectorXi& _D, const Eigen::MatrixXi& _F){
       V=_V; D=_D; F=_F;
-      hedra::polygonal_edge_topology(D, F, EV, FE, EF, EFi, FEs, innerEdges);
-      hedra::dcel(D, F, EV,EF,EFi,innerEdges,VH,EH,FH,HV,HE,HF,nextH, prevH,twinH);
-      hedra::vertex_stars(EV,VH,EH,FH,HV,HE,HF,nextH,prevH,twinH,vertexValences,starVertices,starHalfedges,ringFaces,isBoundaryVertex);
+      hedra::build_connectivity(D, F, EV, FE, EF, EFi, FEs, innerEdges, VH, EH, FH, HV, HE, HF, nextH, prevH, twinH, vertexValences, starVertices, starHalfedges, ringFaces, isBoundaryVertex);
     }
     //there is no special canonical forms for linear subdivision
     Eigen::MatrixXd original2Canonical(const int, const Eigen::MatrixXd& origPoints){return origPoints;}
@@ -33,6 +33,7 @@ namespace hedra
   }
   
   //Computes the point p on the edge jm with combinatorial edges ij, jk, jm, mn, ml
+  //Every row is a separate blend; the rows are computed in chunks by the quaternion chunk kernels, without intermediate batches.
   IGL_INLINE Eigen::MatrixXd moebius_six_points_blend(const Eigen::MatrixXd& vi,
                                                       const Eigen::MatrixXd& vj,
                                                       const Eigen::MatrixXd& vk,
@@ -41,37 +42,47 @@ namespace hedra
                                                       const Eigen::MatrixXd& vn)
   {
     using namespace Eigen;
-    MatrixXd qi(vi.rows(),4); qi<<VectorXd::Zero(vi.rows()),vi;
-    MatrixXd qj(vi.rows(),4); qj<<VectorXd::Zero(vj.rows()),vj;
-    MatrixXd qk(vi.rows(),4); qk<<VectorXd::Zero(vk.rows()),vk;
-    MatrixXd ql(vi.rows(),4); ql<<VectorXd::Zero(vl.rows()),vl;
-    MatrixXd qm(vi.rows(),4); qm<<VectorXd::Zero(vm.rows()),vm;
-    MatrixXd qn(vi.rows(),4); qn<<VectorXd::Zero(vn.rows()),vn;
-    
-    VectorXd qjmNorm=(qj-qm).rowwise().norm();
-    
     double wj=0.5;
-    MatrixXd Unit=MatrixXd::Zero(qi.rows(),4); Unit.col(0).setOnes();
-    
-    MatrixXd mijl=QMultN(QMultN(qm-qi, QInvN(qi-qj)), QMultN((qj-ql), QInvN(ql-qm)));
-    MatrixXd mijn=QMultN(QMultN(qm-qi, QInvN(qi-qj)), QMultN((qj-qn), QInvN(qn-qm)));
-    MatrixXd mkjn=QMultN(QMultN(qm-qk, QInvN(qk-qj)), QMultN((qj-qn), QInvN(qn-qm)));
     
-    MatrixXd smijl=QExpN(QLogN(mijl)*0.5);
-    MatrixXd smkjn=QExpN(QLogN(mkjn)*0.5);;
-    MatrixXd r2=QMultN(QMultN(QInvN(smijl),mijn),QInv(smkjn));
-    MatrixXd mijp=QMultN(smijl,QExpN(QLogN(r2)*0.5))*((1.0-wj)/wj);
-    
-    MatrixXd p=QMult(QInv(QMult(QMult(qi-qj, QInv(qm-qi)), -mijp)+Unit),QMult(QMult(qi-qj, QInv(qm-qi)),QMult(-mijp,qm))+qj);
-    for (int i=0;i<vi.rows();i++)
-      if (qjmNorm(i)<10e-6)
-        p.row(i)<<0.0,vj.row(i);
+    MatrixXd p(vi.rows(),3);
+    QuatChunk qi, qj, qk, ql, qm, qn;
+    for (int start=0;start<vi.rows();start+=QuatChunk::MaxSize){
+      int size=QChunkSize(vi.rows(), start);
+      qi.load_pure(vi, start, size);
+      qj.load_pure(vj, start, size);
+      qk.load_pure(vk, start, size);
+      ql.load_pure(vl, start, size);
+      qm.load_pure(vm, start, size);
+      qn.load_pure(vn, start, size);
+      
+      QuatChunk mijl=QMultChunk(QRatioChunk(qm, qi, qi, qj), QRatioChunk(qj, ql, ql, qm));
+      QuatChunk mijn=QMultChunk(QRatioChunk(qm, qi, qi, qj), QRatioChunk(qj, qn, qn, qm));
+      QuatChunk mkjn=QMultChunk(QRatioChunk(qm, qk, qk, qj), QRatioChunk(qj, qn, qn, qm));
+      
+      QuatChunk smijl=QPowChunk(mijl, 0.5);
+      QuatChunk smkjn=QPowChunk(mkjn, 0.5);
+      QuatChunk r2=QMultChunk(QMultChunk(QInvChunk(smijl), mijn), QInvChunk(smkjn));
+      QuatChunk mijp=QMultChunk(smijl, QPowChunk(r2, 0.5))*((1.0-wj)/wj);
+      
+      QuatChunk ijmi=QRatioChunk(qi, qj, qm, qi);
+      QuatChunk denominator=QMultChunk(ijmi, -mijp);
+      denominator.r+=1.0;
+      QuatChunk pChunk=QMultChunk(QInvChunk(denominator), QMultChunk(ijmi, QMultChunk(-mijp, qm))+qj);
+      
+      //a degenerate edge jm is its own point
+      QuatChunk::Component jmNorm=((qj.x-qm.x).square()+(qj.y-qm.y).square()+(qj.z-qm.z).square()).sqrt();
+      pChunk.x=(jmNorm<10e-6).select(qj.x, pChunk.x);
+      pChunk.y=(jmNorm<10e-6).select(qj.y, pChunk.y);
+      pChunk.z=(jmNorm<10e-6).select(qj.z, pChunk.z);
+      pChunk.store_pure(p, start);
+    }
     
-    return p.block(0,1,p.rows(),3);
+    return p;
     
   }
   
   //computes the midpoint p to form the series a-b-p-c-d
+  //Every row is a separate blend, computed in chunks as in moebius_six_points_blend().
   IGL_INLINE Eigen::MatrixXd moebius_four_points_blend(const Eigen::MatrixXd& va,
                                                        const Eigen::MatrixXd& vb,
                                                        const Eigen::MatrixXd& vc,
@@ -80,59 +91,41 @@ namespace hedra
     using namespace Eigen;
     double wb=0.5;
     
-    VectorXd normab=(va-vb).rowwise().squaredNorm();
-    VectorXd normcd=(vc-vd).rowwise().squaredNorm();
-    MatrixXd qa(va.rows(),4); qa<<VectorXd::Zero(va.rows()),va;
-    MatrixXd qb(vb.rows(),4); qb<<VectorXd::Zero(va.rows()),vb;
-    MatrixXd qc(vc.rows(),4); qc<<VectorXd::Zero(va.rows()),vc;
-    MatrixXd qd(vd.rows(),4); qd<<VectorXd::Zero(va.rows()),vd;
-    
-    /* std::cout<<"qa: "<<qa<<std::endl;
-     std::cout<<"qb: "<<qb<<std::endl;
-     std::cout<<"qc: "<<qc<<std::endl;
-     std::cout<<"qd: "<<qd<<std::endl;*/
-    
-    MatrixXd cabd=QMultN(QMultN(qa-qc, QInvN(qb-qa)), QMultN((qd-qb), QInvN(qc-qd)));
-    
-    //std::cout<<"cabd: "<<cabd<<std::endl;
-    
-    RowVector4d minusOneQuat; minusOneQuat<<-1.0,0.0,0.0,0.0;
-    
-    MatrixXd cabp=-QExpN(QLogN(cabd)*0.5)*((1.0-wb)/wb);
-    //std::cout<<"cabp: "<<cabp<<std::endl;
-    for (int i=0;i<va.rows();i++)
-      if ((cabd.row(i)-minusOneQuat).squaredNorm()<10e-4){  //-1,0,0,0 square root not well defined
-        RowVector3d faceNormal=QMult(qa.row(i)-qc.row(i), QInv(qb.row(i)-qa.row(i))).tail(3).normalized();
-        cabp.row(i)<<0,faceNormal;
-      }
-    
-    MatrixXd Unit=MatrixXd::Zero(qa.rows(),4); Unit.col(0).setOnes();
-    
-    MatrixXd p=QMultN(QInvN(QMultN(QMultN(qb-qa, QInvN(qa-qc)), cabp)+Unit),QMultN(QMultN(qb-qa, QInvN(qa-qc)),QMultN(cabp,qc))+qb);
-    
-    //MatrixXd p1=QMultN(QInvN(QMultN(QMultN(qb-qa, QInvN(qa-qc)), cabp)+Unit),QMultN(QMultN(qb-qa, QInvN(qa-qc)),QMultN(cabp,qc))+qb);
-    //MatrixXd p2=QMultN(QInvN(QMultN(QMultN(qb-qa, QInvN(qa-qc)), -cabp)+Unit),QMultN(QMultN(qb-qa, QInvN(qa-qc)),QMultN(-cabp,qc))+qb);
-    
-    //std::cout<<"p: "<<p<<std::endl;
-    
-    for (int i=0;i<va.rows();i++){
-      if (normab(i)<10e-14)
-        p.row(i)<<0.0,va.row(i);
-      else if (normcd(i)<10e-14)
-        p.row(i)<<0.0,vd.row(i);
-      /*else {
-       RowVector4d midEdge=qb.row(i)*wb+qc.row(i)*(1.0-wb);
-       double dist1=(p1.row(i)-midEdge).squaredNorm();
-       double dist2=(p2.row(i)-midEdge).squaredNorm();
-       
-       if (dist1>dist2)
-       p.row(i)=p2.row(i);
-       else
-       p.row(i)=p1.row(i);
-       }*/
+    MatrixXd p(va.rows(),3);
+    QuatChunk qa, qb, qc, qd;
+    for (int start=0;start<va.rows();start+=QuatChunk::MaxSize){
+      int size=QChunkSize(va.rows(), start);
+      qa.load_pure(va, start, size);
+      qb.load_pure(vb, start, size);
+      qc.load_pure(vc, start, size);
+      qd.load_pure(vd, start, size);
+      
+      QuatChunk acba=QRatioChunk(qa, qc, qb, qa);
+      QuatChunk cabd=QMultChunk(acba, QRatioChunk(qd, qb, qc, qd));
+      QuatChunk cabp=-QPowChunk(cabd, 0.5)*((1.0-wb)/wb);
+      
+      //-1,0,0,0 square root not well defined: the face normal instead
+      QuatChunk::Mask isMinusOne=((cabd.r+1.0).square()+cabd.x.square()+cabd.y.square()+cabd.z.square()<10e-4);
+      QuatChunk::Component normalNorm=(acba.x.square()+acba.y.square()+acba.z.square()).sqrt();
+      cabp.r=isMinusOne.select(0.0, cabp.r);
+      cabp.x=isMinusOne.select(acba.x/normalNorm, cabp.x);
+      cabp.y=isMinusOne.select(acba.y/normalNorm, cabp.y);
+      cabp.z=isMinusOne.select(acba.z/normalNorm, cabp.z);
+      
+      QuatChunk baac=QRatioChunk(qb, qa, qa, qc);
+      QuatChunk denominator=QMultChunk(baac, cabp);
+      denominator.r+=1.0;
+      QuatChunk pChunk=QMultChunk(QInvChunk(denominator), QMultChunk(baac, QMultChunk(cabp, qc))+qb);
       
+      //degenerate edges ab (or cd) give a (or d)
+      QuatChunk::Component normab=(qa.x-qb.x).square()+(qa.y-qb.y).square()+(qa.z-qb.z).square();
+      QuatChunk::Component normcd=(qc.x-qd.x).square()+(qc.y-qd.y).square()+(qc.z-qd.z).square();
+      pChunk.x=(normab<10e-14).select(qa.x, (normcd<10e-14).select(qd.x, pChunk.x));
+      pChunk.y=(normab<10e-14).select(qa.y, (normcd<10e-14).select(qd.y, pChunk.y));
+      pChunk.z=(normab<10e-14).select(qa.z, (normcd<10e-14).select(qd.z, pChunk.z));
+      pChunk.store_pure(p, start);
     }
-    return p.block(0,1,p.rows(),3);
+    return p;
   }
   
 }
@@ -8,7 +8,12 @@
 #ifndef HEDRA_MOEBIUS_REGULAR_MESHES_H
 #define HEDRA_MOEBIUS_REGULAR_MESHES_H
 
+#ifndef HEDRA_WITHOUT_CERES
 #include <hedra/CeresMRSolver.h>
+#endif
+#include <hedra/MoebiusRegularTraits.h>
+#include <hedra/LMSolver.h>
+#include <hedra/EigenSolverWrapper.h>
 #include <hedra/quaternionic_operations.h>
 #include <hedra/quat_cross_ratio.h>
 #include <hedra/quat_normals.h>
@@ -16,6 +21,8 @@
 #include <hedra/dcel.h>
 #include <hedra/planarity.h>
 #include <hedra/willmore_energy.h>
+#include <igl/boundary_loop.h>
+#include <igl/PI.h>
 
 namespace hedra
 {
@@ -102,7 +109,28 @@ namespace hedra
     Eigen::VectorXd convErrors; //last process convergence errors
     
     //optimization operators
+#ifndef HEDRA_WITHOUT_CERES
     CeresMRSolver CSolver;
+#endif
+    
+    //the native solver, which is used instead of CSolver with useNativeSolver (set before setup_moebius_regular()), and always when compiled with HEDRA_WITHOUT_CERES
+    typedef hedra::optimization::EigenSolverWrapper<Eigen::SimplicialLLT<Eigen::SparseMatrix<double> > > NativeLinearSolver;
+    hedra::optimization::MoebiusRegularTraits MRTraits;
+    NativeLinearSolver MRLinearSolver;
+    hedra::optimization::LMSolver<NativeLinearSolver, hedra::optimization::MoebiusRegularTraits> MRLMSolver;
+    bool useNativeSolver;
+    int maxNativeIterations;
+    
+    //With a persistent solution, compute_moebius_regular() leaves the solution in the solver between calls, and only copies the handles in and the positions (VDeform) out; the cross-ratio vectors and normals are then read from CSolver.cr_vectors() and CSolver.normals() (or MRTraits.crVectors and MRTraits.normals) instead of VCR and FN, which keep their initial values.
+    //It is useful with CeresSolveConfig::warmStartTrustRegion for repeated (e.g., interactive) calls.
+    bool persistentSolution;
+    bool isSolverCurrent;  //if the solution in the solver is that of the last call
+    
+#ifndef HEDRA_WITHOUT_CERES
+    MoebiusRegularData():useNativeSolver(false), maxNativeIterations(250), persistentSolution(false), isSolverCurrent(false){}
+#else
+    MoebiusRegularData():useNativeSolver(true), maxNativeIterations(250), persistentSolution(false), isSolverCurrent(false){}
+#endif
     
  
     //assuming the angle is [0, pi] always.
@@ -389,11 +417,19 @@ namespace hedra
                                         const Eigen::MatrixXd& FEs,
                                         const Eigen::VectorXi& innerEdges,
                                         const Eigen::VectorXi& constIndices,
-                                        MoebiusRegularData& MRData){
+                                        MoebiusRegularData& MRData
+#ifndef HEDRA_WITHOUT_CERES
+                                        ,const CeresSolveConfig& solveConfig=CeresSolveConfig()
+#endif
+                                        ){
     
     using namespace Eigen;
     using namespace std;
     
+#ifndef HEDRA_WITHOUT_CERES
+    MRData.CSolver.config=solveConfig;
+#endif
+    MRData.isSolverCurrent=false;
     MRData.F=F;
     MRData.D=D;
     
@@ -597,19 +633,32 @@ namespace hedra
     MRData.deformER=MRData.origER;
     MRData.deformW=MRData.origW;
     
-    MRData.CSolver.CRLengths=MRData.patternCRLengths;
-    MRData.CSolver.CRAngles=MRData.patternCRAngles;
-    MRData.CSolver.FNLengths=MRData.patternFNLengths;
-    MRData.CSolver.FNAngles=MRData.patternFNAngles;
-    MRData.CSolver.faceCRLengths=MRData.patternFaceCRLengths;
-    MRData.CSolver.faceCRAngles=MRData.patternFaceCRAngles;
-    
-    //ComputeMeanCurvature(VValences, QuadVertexIndices, OrigVq, H);
-    
-    MRData.CSolver.init(MRData.QOrig, D, F, EV, MRData.quadVertexIndices, MRData.quadFaceIndices, MRData.faceTriads);
-    
     MRData.constIndices = constIndices;
-    MRData.CSolver.set_constant_handles(constIndices);
+    
+    if (MRData.useNativeSolver){
+      MRData.MRTraits.init(MRData.VOrig, F, MRData.quadVertexIndices, MRData.quadFaceIndices, MRData.faceTriads, constIndices);
+      MRData.MRTraits.CRLengths=MRData.patternCRLengths;
+      MRData.MRTraits.CRAngles=MRData.patternCRAngles;
+      MRData.MRTraits.FNLengths=MRData.patternFNLengths;
+      MRData.MRTraits.FNAngles=MRData.patternFNAngles;
+      MRData.MRTraits.faceCRLengths=MRData.patternFaceCRLengths;
+      MRData.MRLMSolver.init(&MRData.MRLinearSolver, &MRData.MRTraits, MRData.maxNativeIterations);
+    }
+#ifndef HEDRA_WITHOUT_CERES
+    else {
+      MRData.CSolver.CRLengths=MRData.patternCRLengths;
+      MRData.CSolver.CRAngles=MRData.patternCRAngles;
+      MRData.CSolver.FNLengths=MRData.patternFNLengths;
+      MRData.CSolver.FNAngles=MRData.patternFNAngles;
+      MRData.CSolver.faceCRLengths=MRData.patternFaceCRLengths;
+      MRData.CSolver.faceCRAngles=MRData.patternFaceCRAngles;
+      
+      //ComputeMeanCurvature(VValences, QuadVertexIndices, OrigVq, H);
+      
+      MRData.CSolver.init(MRData.QOrig, D, F, EV, MRData.quadVertexIndices, MRData.quadFaceIndices, MRData.faceTriads);
+      MRData.CSolver.set_constant_handles(constIndices);
+    }
+#endif
     return true;
   }
   
@@ -622,39 +671,54 @@ namespace hedra
                                           Eigen::MatrixXd& VRegular)
   {
     
-    //composing initial solution
-    
-    for (int i=0;i<MRData.QOrig.rows();i++)
-      for (int j=0;j<3;j++)
-        MRData.CSolver.currSolution[3*i+j]=MRData.VDeform(i,j);
-    
-    for (int i=0;i<MRData.QOrig.rows();i++)
-      for (int j=0;j<3;j++)
-        MRData.CSolver.currSolution[3*MRData.QOrig.rows()+3*i+j]=MRData.VCR(i,j);
-    
-    for (int i=0;i<MRData.F.rows();i++)
-      for (int j=0;j<3;j++)
-        MRData.CSolver.currSolution[3*MRData.QOrig.rows()+3*MRData.QOrig.rows()+3*i+j]=MRData.FN(i,j);
-    
-    
-    for (int i=0;i<MRData.constIndices.size();i++)
-      for (int j=0;j<3;j++)
-        MRData.CSolver.currSolution[3*MRData.constIndices(i)+j]=constPoses(i,j);
-    
-    
-    MRData.CSolver.solve(MRCoeff, ERCoeff, outputProgress);
-    
-    for (int i=0;i<MRData.QOrig.rows();i++)
-      MRData.VDeform.row(i)<<MRData.CSolver.currSolution[3*i],MRData.CSolver.currSolution[3*i+1],MRData.CSolver.currSolution[3*i+2];
-    
+    if (MRData.useNativeSolver){
+      //composing initial solution
+      if ((!MRData.persistentSolution)||(!MRData.isSolverCurrent)){
+        MRData.MRTraits.positions=MRData.VDeform;
+        MRData.MRTraits.crVectors=MRData.VCR;
+        MRData.MRTraits.normals=MRData.FN;
+        MRData.isSolverCurrent=MRData.persistentSolution;
+      }
+      
+      for (int i=0;i<MRData.constIndices.size();i++)
+        MRData.MRTraits.positions.row(MRData.constIndices(i))=constPoses.row(i);
+      
+      MRData.MRTraits.CRFactor=MRCoeff;
+      MRData.MRTraits.FNFactor=ERCoeff;
+      MRData.MRLMSolver.solve(outputProgress);
+      
+      MRData.VDeform=MRData.MRTraits.positions;
+      
+      if (!MRData.persistentSolution){
+        MRData.VCR=MRData.MRTraits.crVectors;
+        MRData.FN=MRData.MRTraits.normals;
+      }
+    }
+#ifndef HEDRA_WITHOUT_CERES
+    else {
+      //composing initial solution
+      if ((!MRData.persistentSolution)||(!MRData.isSolverCurrent)){
+        MRData.CSolver.positions()=MRData.VDeform;
+        MRData.CSolver.cr_vectors()=MRData.VCR;
+        MRData.CSolver.normals()=MRData.FN;
+        MRData.isSolverCurrent=MRData.persistentSolution;
+      }
+      
+      for (int i=0;i<MRData.constIndices.size();i++)
+        MRData.CSolver.positions().row(MRData.constIndices(i))=constPoses.row(i);
+      
+      MRData.CSolver.solve(MRCoeff, ERCoeff, outputProgress);
+      
+      MRData.VDeform=MRData.CSolver.positions();
+      
+      if (!MRData.persistentSolution){
+        MRData.VCR=MRData.CSolver.cr_vectors();
+        MRData.FN=MRData.CSolver.normals();
+      }
+    }
+#endif
     VRegular = MRData.VDeform;
     
-    for (int i=0;i<MRData.QOrig.rows();i++)
-      MRData.VCR.row(i)<<MRData.CSolver.currSolution[3*MRData.QOrig.rows()+3*i],MRData.CSolver.currSolution[3*MRData.QOrig.rows()+3*i+1],MRData.CSolver.currSolution[3*MRData.QOrig.rows()+3*i+2];
-    
-    for (int i=0;i<MRData.F.rows();i++)
-      MRData.FN.row(i)<<MRData.CSolver.currSolution[3*MRData.QOrig.rows()+3*MRData.QOrig.rows()+3*i],MRData.CSolver.currSolution[3*MRData.QOrig.rows()+3*MRData.QOrig.rows()+3*i+1],MRData.CSolver.currSolution[3*MRData.QOrig.rows()+3*MRData.QOrig.rows()+3*i+2];
-    
     Coords2Quat(constPoses, MRData.quatConstPoses);
     Coords2Quat(MRData.VDeform, MRData.QDeform);
     
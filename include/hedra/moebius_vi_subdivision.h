@@ -10,6 +10,7 @@
 #include <igl/igl_inline.h>
 #include <hedra/quaternionic_operations.h>
 #include <hedra/vertex_valences.h>
+#include <hedra/build_connectivity.h>
 #include <hedra/moebius_refinement.h>
 #include <Eigen/Core>
 #include <string>
@@ -26,9 +27,7 @@ namespace hedra
     
     void setup(const Eigen::MatrixXd& _V, const Eigen::VectorXi& _D, const Eigen::MatrixXi& _F){
       V=_V; D=_D; F=_F;
-      hedra::polygonal_edge_topology(D, F, EV, FE, EF, EFi, FEs, innerEdges);
-      hedra::dcel(D, F, EV,EF,EFi,innerEdges,VH,EH,FH,HV,HE,HF,nextH, prevH,twinH);
-      hedra::vertex_stars(EV,VH,EH,FH,HV,HE,HF,nextH,prevH,twinH,vertexValences,starVertices,starHalfedges,ringFaces,isBoundaryVertex);
+      hedra::build_connectivity(D, F, EV, FE, EF, EFi, FEs, innerEdges, VH, EH, FH, HV, HE, HF, nextH, prevH, twinH, vertexValences, starVertices, starHalfedges, ringFaces, isBoundaryVertex);
       
       //creating Canonical Moebius forms
       //first creating the q_{ki}^{-1} form
@@ -0,0 +1,139 @@
+// This file is part of libhedra, a library for polyhedral mesh processing
+//
+// Copyright (C) 2016 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+#ifndef HEDRA_PARALLEL_FOR_H
+#define HEDRA_PARALLEL_FOR_H
+#include <igl/igl_inline.h>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <mutex>
+
+namespace hedra
+{
+    // The number of threads to use when none is given: the hardware concurrency, or 1 if it is unknown.
+    IGL_INLINE int default_num_threads()
+    {
+        unsigned int numThreads=std::thread::hardware_concurrency();
+        return (numThreads==0 ? 1 : (int)numThreads);
+    }
+
+    // Statically partitions [0,size) into (at most) numThreads contiguous chunks of equal size, and calls func(begin, end, threadIndex) on each of them in parallel. The first chunk runs in the calling thread.
+    // The partition only depends on size and numThreads, so any per-thread results can be combined deterministically in the order of threadIndex.
+    // Inputs:
+    //  size         the size of the range.
+    //  func         a callable with the signature void(int begin, int end, int threadIndex)
+    //  numThreads   the maximum number of threads; <=1 runs serially.
+    //  minParallel  ranges smaller than this run serially in the calling thread, as the threads would cost more than they save.
+    // Returns the number of chunks that were used.
+    template<typename Func>
+    int parallel_for(const int size,
+                     const Func& func,
+                     const int numThreads,
+                     const int minParallel=10000)
+    {
+        if (size<=0)
+            return 0;
+
+        int numChunks=std::min(numThreads, size);
+        if ((numChunks<=1)||(size<minParallel)){
+            func(0, size, 0);
+            return 1;
+        }
+
+        int chunkSize=(size+numChunks-1)/numChunks;
+        numChunks=(size+chunkSize-1)/chunkSize;
+        std::vector<std::thread> threads;
+        threads.reserve(numChunks-1);
+        for (int t=1;t<numChunks;t++)
+            threads.emplace_back(func, t*chunkSize, std::min(size, (t+1)*chunkSize), t);
+
+        func(0, chunkSize, 0);
+        for (size_t t=0;t<threads.size();t++)
+            threads[t].join();
+
+        return numChunks;
+    }
+
+    // Calls func(index, threadIndex) for every index in [0,size), with work stealing for items of uneven cost (e.g., whole optimizations of different sizes).
+    // Every thread starts with a contiguous chunk of (about) size/numThreads items, and takes its items from the front; a thread that runs out steals the back half of the items left in another thread. Neighbouring items thus tend to run in the same thread and in order.
+    // Inputs:
+    //  size         the number of items.
+    //  func         a callable with the signature void(int index, int threadIndex)
+    //  numThreads   the maximum number of threads; <=1 runs serially.
+    // Returns the number of threads that were used.
+    template<typename Func>
+    int parallel_for_stealing(const int size,
+                              const Func& func,
+                              const int numThreads)
+    {
+        if (size<=0)
+            return 0;
+
+        int numWorkers=std::min(numThreads, size);
+        if (numWorkers<=1){
+            for (int i=0;i<size;i++)
+                func(i, 0);
+            return 1;
+        }
+
+        //the items left in every thread are [begin[t], end[t])
+        std::vector<int> begin(numWorkers), end(numWorkers);
+        std::vector<std::mutex> locks(numWorkers);
+        for (int t=0;t<numWorkers;t++){
+            begin[t]=(int)(((long long)size*t)/numWorkers);
+            end[t]=(int)(((long long)size*(t+1))/numWorkers);
+        }
+
+        auto worker=[&](const int threadIndex){
+            while (true){
+                int index=-1;
+                {
+                    std::lock_guard<std::mutex> guard(locks[threadIndex]);
+                    if (begin[threadIndex]<end[threadIndex])
+                        index=begin[threadIndex]++;
+                }
+                if (index<0){
+                    //stealing from the next threads in turn
+                    for (int k=1;(k<numWorkers)&&(index<0);k++){
+                        int victim=(threadIndex+k)%numWorkers;
+                        int stolenBegin, stolenEnd;
+                        {
+                            std::lock_guard<std::mutex> guard(locks[victim]);
+                            int numLeft=end[victim]-begin[victim];
+                            if (numLeft<=0)
+                                continue;
+                            stolenEnd=end[victim];
+                            stolenBegin=stolenEnd-(numLeft+1)/2;
+                            end[victim]=stolenBegin;
+                        }
+                        std::lock_guard<std::mutex> guard(locks[threadIndex]);
+                        begin[threadIndex]=stolenBegin+1;
+                        end[threadIndex]=stolenEnd;
+                        index=stolenBegin;
+                    }
+                    if (index<0)
+                        return;  //no items are left anywhere, and none are added
+                }
+                func(index, threadIndex);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(numWorkers-1);
+        for (int t=1;t<numWorkers;t++)
+            threads.emplace_back(worker, t);
+        worker(0);
+        for (size_t t=0;t<threads.size();t++)
+            threads[t].join();
+
+        return numWorkers;
+    }
+}
+
+
+#endif
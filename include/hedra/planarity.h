@@ -8,6 +8,7 @@
 #ifndef HEDRA_PLANARITY_H
 #define HEDRA_PLANARITY_H
 #include <igl/igl_inline.h>
+#include <hedra/PolygonMesh.h>
 #include <Eigen/Core>
 #include <vector>
 #include <cmath> 
@@ -19,25 +20,25 @@ namespace hedra
     
     // Inputs:
     //  V           eigen double matrix     #V by 3 - mesh coordinates
-    //  D           eigen int matrix        #F by 1 - face degrees
-    //  F           eigen int matrix        #F by max(D)
+    //  P           PolygonMesh or PaddedPolygons (see PolygonMesh.h)
     // Outputs:
     //  planarity   eigen double matix      #F by 1
+    template<class Polygons>
     IGL_INLINE bool planarity(const Eigen::MatrixXd& V,
-                              const Eigen::VectorXi& D,
-                              const Eigen::MatrixXi& F,
+                              const Polygons& P,
                               Eigen::VectorXd& planarity)
     {
         using namespace Eigen;
-        planarity.resize(D.size());
+        planarity.resize(P.num_faces());
         
-        for (int i=0;i<D.rows();i++){
-            Eigen::VectorXd quadPlanarities(D(i));
-            for (int j=0;j<D(i);j++){
-                RowVector3d v1=V.row(F(i,j));
-                RowVector3d v2=V.row(F(i,(j+1)%D(i)));
-                RowVector3d v3=V.row(F(i,(j+2)%D(i)));
-                RowVector3d v4=V.row(F(i,(j+3)%D(i)));
+        for (int i=0;i<P.num_faces();i++){
+            const int d=P.degree(i);
+            Eigen::VectorXd quadPlanarities(d);
+            for (int j=0;j<d;j++){
+                RowVector3d v1=V.row(P.vertex(i,j));
+                RowVector3d v2=V.row(P.vertex(i,(j+1)%d));
+                RowVector3d v3=V.row(P.vertex(i,(j+2)%d));
+                RowVector3d v4=V.row(P.vertex(i,(j+3)%d));
                 RowVector3d diagCross=(v3-v1).cross(v4-v2);
                 double denom = diagCross.norm()*(((v3-v1).norm()+(v4-v2).norm())/2);
                 if (fabs(denom)<1e-8)
@@ -46,10 +47,24 @@ namespace hedra
                 else
                     quadPlanarities(j) = (diagCross.dot(v2-v1)/denom);  //percentage
             }
-            planarity(i)=100.0*sqrt(quadPlanarities.squaredNorm()/(double)D(i));
+            planarity(i)=100.0*sqrt(quadPlanarities.squaredNorm()/(double)d);
         }
         return true;
     }
+    
+    // Inputs:
+    //  V           eigen double matrix     #V by 3 - mesh coordinates
+    //  D           eigen int matrix        #F by 1 - face degrees
+    //  F           eigen int matrix        #F by max(D)
+    // Outputs:
+    //  planarity   eigen double matix      #F by 1
+    IGL_INLINE bool planarity(const Eigen::MatrixXd& V,
+                              const Eigen::VectorXi& D,
+                              const Eigen::MatrixXi& F,
+                              Eigen::VectorXd& planarity)
+    {
+        return hedra::planarity(V, PaddedPolygons(D,F), planarity);
+    }
 }
 
     
@@ -9,8 +9,11 @@
 #define HEDRA_POLYGONAL_EDGE_TOPOLOGY_H
 
 #include <igl/igl_inline.h>
+#include <hedra/PolygonMesh.h>
+#include <hedra/parallel_for.h>
 #include <Eigen/Core>
 #include <vector>
+#include <algorithm>
 
 
 namespace hedra
@@ -18,129 +21,196 @@ namespace hedra
     // Initialize Edges and their topological relations
     
     //input:
-    //  D  eigen int vector     #F by 1 - face degrees
-    //  F  eigen int matrix     #F by max(D) - vertex indices in face
+    //  P  PolygonMesh or PaddedPolygons (see PolygonMesh.h)
   
     // Output:
     // EV   #E by 2, Stores the edge description as pair of indices to vertices
-    // FE : #F by max(D), Stores the Face-Edge relation
+    // FE : per-corner (P.corner(f,j)) Face-Edge relation; #F by max(D) for PaddedPolygons, sum(D) by 1 for PolygonMesh
     // EF : #E by 2: Stores the Edge-Face relation
     // EFi: #E by 2: corresponding to EF and stores the relative position of the edge in the face (e.g., if the edge is (v1,v2) and the face has (vx,vy,v2,v1,vz,va), then the value is 3)
-    // EFs: #E by 2: if the edge is oriented positively or negatively in the face (e.g. in the example above we get -1)
+    // FEs: per-corner as FE: if the edge is oriented positively or negatively in the face (e.g. in the example above we get -1)
     // InnerEdges: indices into EV of which edges are internal (not boundary)
-
-    IGL_INLINE void polygonal_edge_topology(const Eigen::VectorXi& D,
-                                            const Eigen::MatrixXi& F,
+    // numThreads: every stage runs in parallel chunks, with results identical to the serial run.
+    template<class Polygons, typename DerivedFE, typename DerivedFEs>
+    IGL_INLINE void polygonal_edge_topology(const Polygons& P,
                                             Eigen::MatrixXi& EV,
-                                            Eigen::MatrixXi& FE,
+                                            Eigen::PlainObjectBase<DerivedFE>& FE,
                                             Eigen::MatrixXi& EF,
                                             Eigen::MatrixXi& EFi,
-                                            Eigen::MatrixXd& FEs,
-                                            Eigen::VectorXi& InnerEdges)
+                                            Eigen::PlainObjectBase<DerivedFEs>& FEs,
+                                            Eigen::VectorXi& InnerEdges,
+                                            const int numThreads=1)
     {
         // Only needs to be edge-manifold
-        std::vector<std::vector<int> > ETT;
-        for(int f=0;f<D.rows();++f)
-            for (int i=0;i<D(f);++i)
-            {
-                // v1 v2 f vi
-                int v1 = F(f,i);
-                int v2 = F(f,(i+1)%D(f));
-                if (v1 > v2) std::swap(v1,v2);
-                std::vector<int> r(4);
-                r[0] = v1; r[1] = v2;
-                r[2] = f;  r[3] = i;
-                ETT.push_back(r);
-            }
-        std::sort(ETT.begin(),ETT.end());
+        // One flat record per halfedge, sorted by (v1,v2) with a stable two-pass counting (LSD radix) sort. The records are generated in (f,i) order, so the result is in the same (v1,v2,f,i) order as a lexicographic sort, in O(sum(D)+#V).
+        struct EdgeRecord{
+            int v1, v2;   //v1<v2
+            int f, i;     //face and position in face
+            bool isPositive;  //if the halfedge goes v1->v2 in the face
+        };
         
-        // count the number of edges (assume manifoldness)
-        int En = 1; // the last is always counted
-        for(unsigned i=0;i<ETT.size()-1;++i)
-            if (!((ETT[i][0] == ETT[i+1][0]) && (ETT[i][1] == ETT[i+1][1])))
-                ++En;
+        const int numSlots=std::max(numThreads,1);
+        const int numFaces=P.num_faces();
+        std::vector<int> faceCorner(numFaces+1);
+        faceCorner[0]=0;
+        for(int f=0;f<numFaces;++f)
+            faceCorner[f+1]=faceCorner[f]+P.degree(f);
+        const int numCorners=faceCorner[numFaces];
         
-        EV = Eigen::MatrixXi::Constant((int)(En),2,-1);
-        FE = Eigen::MatrixXi::Constant((int)(F.rows()),(int)(F.cols()),-1);
-        EF = Eigen::MatrixXi::Constant((int)(En),2,-1);
-        En = 0;
+        std::vector<EdgeRecord> records(numCorners);
+        std::vector<int> threadNumV(numSlots,0);
+        hedra::parallel_for(numFaces, [&](const int begin, const int end, const int threadIndex){
+            for(int f=begin;f<end;++f)
+                for (int i=0;i<P.degree(f);++i)
+                {
+                    EdgeRecord& r=records[faceCorner[f]+i];
+                    r.v1 = P.vertex(f,i);
+                    r.v2 = P.vertex(f,(i+1)%P.degree(f));
+                    r.isPositive = (r.v1 <= r.v2);
+                    if (r.v1 > r.v2) std::swap(r.v1,r.v2);
+                    r.f = f;  r.i = i;
+                    threadNumV[threadIndex] = std::max(threadNumV[threadIndex], r.v2+1);
+                }
+        }, numThreads);
+        const int numV=*std::max_element(threadNumV.begin(), threadNumV.end());
         
-        for(unsigned i=0;i<ETT.size();++i)
-        {
-            if (i == ETT.size()-1 ||
-                !((ETT[i][0] == ETT[i+1][0]) && (ETT[i][1] == ETT[i+1][1]))
-                )
-            {
-                // Border edge
-                std::vector<int>& r1 = ETT[i];
-                EV(En,0)     = r1[0];
-                EV(En,1)     = r1[1];
-                EF(En,0)    = r1[2];
-                FE(r1[2],r1[3]) = En;
-            }
-            else
-            {
-                std::vector<int>& r1 = ETT[i];
-                std::vector<int>& r2 = ETT[i+1];
-                EV(En,0)     = r1[0];
-                EV(En,1)     = r1[1];
-                EF(En,0)    = r1[2];
-                EF(En,1)    = r2[2];
-                FE(r1[2],r1[3]) = En;
-                FE(r2[2],r2[3]) = En;
-                ++i; // skip the next one
-            }
-            ++En;
+        // every thread counts its chunk, and scatters it after the chunks of the previous threads in the same bucket, which keeps the sort stable
+        std::vector<EdgeRecord> sortedRecords(numCorners);
+        std::vector<std::vector<int> > threadBucketPos(numSlots, std::vector<int>(numV));
+        std::vector<int> bucketStart(numV+1);
+        for (int pass=0;pass<2;pass++){
+            const std::vector<EdgeRecord>& source=(pass==0 ? records : sortedRecords);
+            std::vector<EdgeRecord>& target=(pass==0 ? sortedRecords : records);
+            for (int t=0;t<numSlots;t++)
+                std::fill(threadBucketPos[t].begin(), threadBucketPos[t].end(), 0);
+            hedra::parallel_for(numCorners, [&](const int begin, const int end, const int threadIndex){
+                std::vector<int>& counts=threadBucketPos[threadIndex];
+                for (int k=begin;k<end;k++)
+                    counts[pass==0 ? source[k].v2 : source[k].v1]++;
+            }, numThreads);
+            hedra::parallel_for(numV, [&](const int begin, const int end, const int threadIndex){
+                for (int v=begin;v<end;v++){
+                    bucketStart[v+1]=0;
+                    for (int t=0;t<numSlots;t++)
+                        bucketStart[v+1]+=threadBucketPos[t][v];
+                }
+            }, numThreads);
+            bucketStart[0]=0;
+            for (int v=0;v<numV;v++)
+                bucketStart[v+1]+=bucketStart[v];
+            hedra::parallel_for(numV, [&](const int begin, const int end, const int threadIndex){
+                for (int v=begin;v<end;v++){
+                    int currPos=bucketStart[v];
+                    for (int t=0;t<numSlots;t++){
+                        int count=threadBucketPos[t][v];
+                        threadBucketPos[t][v]=currPos;
+                        currPos+=count;
+                    }
+                }
+            }, numThreads);
+            hedra::parallel_for(numCorners, [&](const int begin, const int end, const int threadIndex){
+                std::vector<int>& currPos=threadBucketPos[threadIndex];
+                for (int k=begin;k<end;k++)
+                    target[currPos[pass==0 ? source[k].v2 : source[k].v1]++]=source[k];
+            }, numThreads);
         }
+        const std::vector<EdgeRecord>& ETT=records;
         
-        // Sort the relation EF, accordingly to EV
-        // the first one is the face on the left of the edge
-        
-        for(unsigned i=0; i<EF.rows(); ++i)
-        {
-            int fid = EF(i,0);
-            bool flip = true;
-            // search for edge EV.row(i)
-            for (unsigned j=0; j<D(fid); ++j)
-            {
-                if ((F(fid,j) == EV(i,0)) && (F(fid,(j+1)%D(fid)) == EV(i,1)))
-                    flip = false;
-            }
-            
-            if (flip)
-            {
-                int tmp = EF(i,0);
-                EF(i,0) = EF(i,1);
-                EF(i,1) = tmp;
-            }
+        // chunks of whole (v1,v2) groups, which pair halfedges independently
+        const int numChunks=(numCorners<10000 ? 1 : numSlots);
+        std::vector<int> chunkStart(numChunks+1, numCorners);
+        chunkStart[0]=0;
+        for (int c=1;c<numChunks;c++){
+            int k=std::max(chunkStart[c-1], (int)(((long long)numCorners*c)/numChunks));
+            while ((k>0)&&(k<numCorners)&&(ETT[k].v1==ETT[k-1].v1)&&(ETT[k].v2==ETT[k-1].v2))
+                k++;
+            chunkStart[c]=k;
         }
         
-        
-        std::vector<int> InnerEdgesVec;
-        EFi=Eigen::MatrixXi::Constant(EF.rows(), 2,-1);
-        FEs=Eigen::MatrixXd::Zero(FE.rows(),FE.cols());
-        for (int i=0;i<EF.rows();i++)
-            for (int k=0;k<2;k++){
-                if (EF(i,k)==-1)
-                    continue;
-                    
-                for (int j=0;j<D(EF(i,k));j++)
-                    if (FE(EF(i,k),j)==i)
-                        EFi(i,k)=j;
+        // count the number of edges (assume manifoldness), pairing the halfedges exactly as below
+        std::vector<int> chunkEdgeStart(numChunks+1,0);
+        std::vector<std::vector<int> > chunkInnerEdges(numChunks);
+        hedra::parallel_for(numChunks, [&](const int begin, const int end, const int threadIndex){
+            for (int c=begin;c<end;c++){
+                int En = 0;
+                for(int k=chunkStart[c];k<chunkStart[c+1];++k,++En)
+                    if ((k < numCorners-1) && (ETT[k].v1 == ETT[k+1].v1) && (ETT[k].v2 == ETT[k+1].v2))
+                        ++k;
+                chunkEdgeStart[c+1]=En;
             }
+        }, numThreads, 2);
+        for (int c=0;c<numChunks;c++)
+            chunkEdgeStart[c+1]+=chunkEdgeStart[c];
         
-        for (int i=0;i<EF.rows();i++){
-            if (EFi(i,0)!=-1) FEs(EF(i,0),EFi(i,0))=1.0;
-            if (EFi(i,1)!=-1) FEs(EF(i,1),EFi(i,1))=-1.0;
-            if ((EF(i,0)!=-1)&&(EF(i,1)!=-1))
-                InnerEdgesVec.push_back(i);
-        }
+        EV.resize(chunkEdgeStart[numChunks],2);
+        FE.setConstant(P.corner_rows(),P.corner_cols(),-1);
+        EF = Eigen::MatrixXi::Constant(EV.rows(),2,-1);
+        EFi = Eigen::MatrixXi::Constant(EV.rows(),2,-1);
+        FEs.setZero(P.corner_rows(),P.corner_cols());
         
-        InnerEdges.resize(InnerEdgesVec.size());
-        for (int i=0;i<InnerEdgesVec.size();i++)
-            InnerEdges(i)=InnerEdgesVec[i];
+        // the first face in EF is the one on the left of the edge, where the halfedge goes EV(i,0)->EV(i,1)
+        hedra::parallel_for(numChunks, [&](const int begin, const int end, const int threadIndex){
+            for (int c=begin;c<end;c++){
+                int En = chunkEdgeStart[c];
+                for(int k=chunkStart[c];k<chunkStart[c+1];++k)
+                {
+                    const EdgeRecord& r1 = ETT[k];
+                    EV(En,0) = r1.v1;
+                    EV(En,1) = r1.v2;
+                    FE.coeffRef(P.corner(r1.f,r1.i)) = En;
+                    if (k == numCorners-1 ||
+                        !((ETT[k].v1 == ETT[k+1].v1) && (ETT[k].v2 == ETT[k+1].v2))
+                        )
+                    {
+                        // Border edge
+                        const int side=(r1.isPositive ? 0 : 1);
+                        EF(En,side) = r1.f;
+                        EFi(En,side) = r1.i;
+                        FEs.coeffRef(P.corner(r1.f,r1.i)) = (r1.isPositive ? 1.0 : -1.0);
+                    }
+                    else
+                    {
+                        const EdgeRecord& r2 = ETT[k+1];
+                        const EdgeRecord& left = (r1.isPositive ? r1 : r2);
+                        const EdgeRecord& right = (r1.isPositive ? r2 : r1);
+                        EF(En,0) = left.f;   EFi(En,0) = left.i;
+                        EF(En,1) = right.f;  EFi(En,1) = right.i;
+                        FE.coeffRef(P.corner(r2.f,r2.i)) = En;
+                        FEs.coeffRef(P.corner(left.f,left.i)) = 1.0;
+                        FEs.coeffRef(P.corner(right.f,right.i)) = -1.0;
+                        chunkInnerEdges[c].push_back(En);
+                        ++k; // skip the next one
+                    }
+                    ++En;
+                }
+            }
+        }, numThreads, 2);
         
-
+        int numInnerEdges=0;
+        for (int c=0;c<numChunks;c++)
+            numInnerEdges+=chunkInnerEdges[c].size();
+        InnerEdges.resize(numInnerEdges);
+        numInnerEdges=0;
+        for (int c=0;c<numChunks;c++)
+            for (size_t i=0;i<chunkInnerEdges[c].size();i++)
+                InnerEdges(numInnerEdges++)=chunkInnerEdges[c][i];
+    }
+    
+    //input:
+    //  D  eigen int vector     #F by 1 - face degrees
+    //  F  eigen int matrix     #F by max(D) - vertex indices in face
+    // Output:
+    //  as above, where FE and FEs are #F by max(D)
+    IGL_INLINE void polygonal_edge_topology(const Eigen::VectorXi& D,
+                                            const Eigen::MatrixXi& F,
+                                            Eigen::MatrixXi& EV,
+                                            Eigen::MatrixXi& FE,
+                                            Eigen::MatrixXi& EF,
+                                            Eigen::MatrixXi& EFi,
+                                            Eigen::MatrixXd& FEs,
+                                            Eigen::VectorXi& InnerEdges)
+    {
+        polygonal_edge_topology(PaddedPolygons(D,F), EV, FE, EF, EFi, FEs, InnerEdges);
     }
 }
 
@@ -8,6 +8,7 @@
 #ifndef HEDRA_POLYGONAL_FACE_CENTERS_H
 #define HEDRA_POLYGONAL_FACE_CENTERS_H
 #include <igl/igl_inline.h>
+#include <hedra/PolygonMesh.h>
 #include <Eigen/Core>
 #include <string>
 #include <vector>
@@ -18,26 +19,39 @@ namespace hedra
     // Computes barycenter of polygonal faces.
     // Inputs:
     //  V  eigen double matrix  #v by 3 vertex coordinates
-    //  D  eigen int vector     #F by 1 - face degrees
-    //  F  eigen int matrix     #F by max(D) - vertex indices in face
+    //  P  PolygonMesh or PaddedPolygons (see PolygonMesh.h)
     // Outputs:
     //  faceCenters eigen double matrix #F by 3 face barycenter coordinates
+    template<class Polygons>
     IGL_INLINE bool polygonal_face_centers(const Eigen::MatrixXd& V,
-                                           const Eigen::VectorXi& D,
-                                           const Eigen::MatrixXi& F,
+                                           const Polygons& P,
                                            Eigen::MatrixXd& faceCenters)
     {
         using namespace Eigen;
-        faceCenters=MatrixXd::Zero(F.rows(),3);
-        for (int i=0;i<D.rows();i++){
-            for (int j=0;j<D(i);j++)
-                faceCenters.row(i)+=V.row(F(i,j));
+        faceCenters=MatrixXd::Zero(P.num_faces(),3);
+        for (int i=0;i<P.num_faces();i++){
+            for (int j=0;j<P.degree(i);j++)
+                faceCenters.row(i)+=V.row(P.vertex(i,j));
                 
-            faceCenters.row(i)/=(double)D(i);
+            faceCenters.row(i)/=(double)P.degree(i);
         }
         
         return true;
     }
+    
+    // Inputs:
+    //  V  eigen double matrix  #v by 3 vertex coordinates
+    //  D  eigen int vector     #F by 1 - face degrees
+    //  F  eigen int matrix     #F by max(D) - vertex indices in face
+    // Outputs:
+    //  faceCenters eigen double matrix #F by 3 face barycenter coordinates
+    IGL_INLINE bool polygonal_face_centers(const Eigen::MatrixXd& V,
+                                           const Eigen::VectorXi& D,
+                                           const Eigen::MatrixXi& F,
+                                           Eigen::MatrixXd& faceCenters)
+    {
+        return polygonal_face_centers(V, PaddedPolygons(D,F), faceCenters);
+    }
 }
 
 
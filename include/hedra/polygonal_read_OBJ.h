@@ -0,0 +1,178 @@
+// This file is part of libhedra, a library for polyhedral mesh processing
+//
+// Copyright (C) 2016 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+#ifndef HEDRA_POLYGONAL_READ_OBJ_H
+#define HEDRA_POLYGONAL_READ_OBJ_H
+#include <igl/igl_inline.h>
+#include <hedra/ascii_parsing.h>
+#include <hedra/parallel_for.h>
+#include <Eigen/Core>
+#include <string>
+#include <vector>
+
+namespace hedra
+{
+    // parses one face corner "v", "v/vt", "v//vn" or "v/vt/vn" into zero-based indices (vt=-1 if there is none). Negative OBJ indices are relative to the numV (resp. numTC) elements defined before the face, and fail if they reach before the first one.
+    inline bool parse_OBJ_corner(const char*& p, const char* end, const int numV, const int numTC, int& v, int& vt)
+    {
+        int index;
+        if (!hedra::parse_int(p, end, index)||(index==0)||(index<-numV))
+            return false;
+        v=(index>0 ? index-1 : numV+index);
+        vt=-1;
+        if ((p<end)&&(*p=='/')){
+            p++;
+            if ((p<end)&&(*p!='/')){
+                if (!hedra::parse_int(p, end, index)||(index==0)||(index<-numTC))
+                    return false;
+                vt=(index>0 ? index-1 : numTC+index);
+            }
+            if ((p<end)&&(*p=='/')){
+                p++;
+                if (!hedra::parse_int(p, end, index))  //the normal is ignored
+                    return false;
+            }
+        }
+        return ((p==end)||(*p==' ')||(*p=='\t')||(*p=='\r')||(*p=='\n')||(*p=='#'));
+    }
+
+    // reads a polygonal mesh from an ascii OBJ file, with its texture coordinates
+    // The file is read into one buffer, and the "v", "vt" and "f" lines are parsed in parallel directly into the outputs. Normals, groups, materials and the other elements are skipped.
+    // Inputs:
+    //   str  path to .obj file
+    //   numThreads  the number of threads for parsing (serial by default)
+    // Outputs:
+    //  V    eigen double matrix  #V by 3 - vertex coordinates
+    //  TC   eigen double matrix  #TC by 2 - texture coordinates
+    //  D    eigen int vector     #F by 1 - face degrees
+    //  F    eigen int matrix     #F by max(D) - vertex indices in face
+    //  FTC  eigen int matrix     #F by max(D) - texture coordinate indices of the face corners, -1 where a corner has none (empty if there are no texture coordinates)
+    IGL_INLINE bool polygonal_read_OBJ(const std::string str,
+                                       Eigen::MatrixXd& V,
+                                       Eigen::MatrixXd& TC,
+                                       Eigen::VectorXi& D,
+                                       Eigen::MatrixXi& F,
+                                       Eigen::MatrixXi& FTC,
+                                       const int numThreads=1)
+    {
+        using namespace std;
+        vector<char> buffer;
+        if (!hedra::read_file_buffer(str, buffer))
+            return false;
+        const char* bufferEnd=buffer.data()+buffer.size()-1;
+
+        //classifying the lines; the faces keep the number of vertices and texture coordinates defined before them, for relative indices
+        vector<const char*> vertexLines, TCLines, faceLines;
+        vector<int> faceNumV, faceNumTC;
+        const char* p=buffer.data();
+        while (p<bufferEnd){
+            const char* q=hedra::skip_blanks(p, bufferEnd);
+            if ((q+1<bufferEnd)&&(q[0]=='v')&&((q[1]==' ')||(q[1]=='\t')))
+                vertexLines.push_back(q+1);
+            else if ((q+2<bufferEnd)&&(q[0]=='v')&&(q[1]=='t')&&((q[2]==' ')||(q[2]=='\t')))
+                TCLines.push_back(q+2);
+            else if ((q+1<bufferEnd)&&(q[0]=='f')&&((q[1]==' ')||(q[1]=='\t'))){
+                faceLines.push_back(q+1);
+                faceNumV.push_back(vertexLines.size());
+                faceNumTC.push_back(TCLines.size());
+            }
+            p=hedra::next_line(q, bufferEnd);
+        }
+
+        const int numV=vertexLines.size();
+        const int numTC=TCLines.size();
+        const int numF=faceLines.size();
+        V.resize(numV,3);
+        TC.resize(numTC,2);
+        D.resize(numF);
+        vector<int> threadSuccess(std::max(numThreads,1),1);
+        vector<int> threadMaxD(std::max(numThreads,1),0);
+
+        hedra::parallel_for(numV, [&](const int begin, const int end, const int threadIndex){
+            for (int i=begin;i<end;i++){
+                const char* q=vertexLines[i];
+                if (!(hedra::parse_double(q,bufferEnd,V(i,0))&&hedra::parse_double(q,bufferEnd,V(i,1))&&hedra::parse_double(q,bufferEnd,V(i,2))))
+                    threadSuccess[threadIndex]=0;
+            }
+        }, numThreads);
+
+        hedra::parallel_for(numTC, [&](const int begin, const int end, const int threadIndex){
+            for (int i=begin;i<end;i++){
+                const char* q=TCLines[i];
+                if (!(hedra::parse_double(q,bufferEnd,TC(i,0))&&hedra::parse_double(q,bufferEnd,TC(i,1))))
+                    threadSuccess[threadIndex]=0;
+            }
+        }, numThreads);
+
+        //face degrees, as the number of corners in the line
+        hedra::parallel_for(numF, [&](const int begin, const int end, const int threadIndex){
+            for (int i=begin;i<end;i++){
+                const char* q=hedra::skip_blanks(faceLines[i],bufferEnd);
+                D(i)=0;
+                while ((q<bufferEnd)&&(*q!='\n')&&(*q!='#')){
+                    while ((q<bufferEnd)&&(*q!=' ')&&(*q!='\t')&&(*q!='\r')&&(*q!='\n')&&(*q!='#'))
+                        q++;
+                    D(i)++;
+                    q=hedra::skip_blanks(q,bufferEnd);
+                }
+                threadMaxD[threadIndex]=std::max(threadMaxD[threadIndex], D(i));
+            }
+        }, numThreads);
+
+        int maxD=0;
+        for (size_t t=0;t<threadMaxD.size();t++)
+            maxD=std::max(maxD, threadMaxD[t]);
+        F.resize(numF,maxD);
+        FTC.resize(numTC>0 ? numF : 0, numTC>0 ? maxD : 0);
+
+        hedra::parallel_for(numF, [&](const int begin, const int end, const int threadIndex){
+            for (int i=begin;i<end;i++){
+                const char* q=faceLines[i];
+                for (int j=0;j<D(i);j++){
+                    int v, vt;
+                    if (!hedra::parse_OBJ_corner(q,bufferEnd,faceNumV[i],faceNumTC[i],v,vt)||(v<0)||(v>=numV)||(vt>=numTC)){
+                        threadSuccess[threadIndex]=0;
+                        break;
+                    }
+                    F(i,j)=v;
+                    if (numTC>0)
+                        FTC(i,j)=vt;
+                }
+                for (int j=D(i);j<maxD;j++){
+                    F(i,j)=-1;  //to "don't care" vertices
+                    if (numTC>0)
+                        FTC(i,j)=-1;
+                }
+            }
+        }, numThreads);
+
+        for (size_t t=0;t<threadSuccess.size();t++)
+            if (!threadSuccess[t])
+                return false;
+        return true;
+    }
+
+    // reads only the polygonal mesh from an ascii OBJ file
+    // Inputs:
+    //   str  path to .obj file
+    // Outputs:
+    //  V  eigen double matrix  #V by 3 - vertex coordinates
+    //  D  eigen int vector     #F by 1 - face degrees
+    //  F  eigen int matrix     #F by max(D) - vertex indices in face
+    IGL_INLINE bool polygonal_read_OBJ(const std::string str,
+                                       Eigen::MatrixXd& V,
+                                       Eigen::VectorXi& D,
+                                       Eigen::MatrixXi& F)
+    {
+        Eigen::MatrixXd TC;
+        Eigen::MatrixXi FTC;
+        return polygonal_read_OBJ(str, V, TC, D, F, FTC);
+    }
+}
+
+
+#endif
@@ -1,6 +1,6 @@
 // This file is part of libhedra, a library for polyhedral mesh processing
 //
-// Copyright (C) 2015 Amir Vaxman <avaxman@gmail.com>
+// Copyright (C) 2016 Amir Vaxman <avaxman@gmail.com>
 //
 // This Source Code Form is subject to the terms of the Mozilla Public License
 // v. 2.0. If a copy of the MPL was not distributed with this file, You can
@@ -8,6 +8,8 @@
 #ifndef HEDRA_POLYGONAL_READ_OFF_H
 #define HEDRA_POLYGONAL_READ_OFF_H
 #include <igl/igl_inline.h>
+#include <hedra/ascii_parsing.h>
+#include <hedra/parallel_for.h>
 #include <Eigen/Core>
 #include <string>
 #include <vector>
@@ -16,8 +18,12 @@
 namespace hedra
 {
     // reads mesh from an ascii OFF file of a polygonal mesh
+    // The file is read into one buffer, and the vertex and face lines are parsed in parallel directly into V, D and F. Comments ('#') and the [ST][C][N]OFF variants are supported; vertex normals, colors and texture coordinates, and face colors, are skipped.
+    // Files where a vertex or face spans several lines are parsed serially, token by token.
+    // Returns false (as for a syntax error) if a face has a vertex index outside [0,#V).
     // Inputs:
     //   str  path to .off file
+    //   numThreads  the number of threads for parsing (serial by default)
     // Outputs:
     //  V  eigen double matrix  #V by 3 - vertex coordinates
     //  D  eigen int vector     #F by 1 - face degrees
@@ -25,44 +31,151 @@ namespace hedra
     IGL_INLINE bool polygonal_read_OFF(const std::string str,
                                        Eigen::MatrixXd& V,
                                        Eigen::VectorXi& D,
-                                       Eigen::MatrixXi& F)
+                                       Eigen::MatrixXi& F,
+                                       const int numThreads=1)
     {
-        
+
         using namespace std;
-        ifstream FileHandle;
-        FileHandle.open(str);
-        if (!FileHandle.is_open())
+        vector<char> buffer;
+        if (!hedra::read_file_buffer(str, buffer))
+            return false;
+        const char* bufferEnd=buffer.data()+buffer.size()-1;
+
+        //the header: [ST][C][N]OFF, followed by #V #F #E
+        const char* p=hedra::next_token(buffer.data(), bufferEnd);
+        const char* keywordEnd=p;
+        while ((keywordEnd<bufferEnd)&&(*keywordEnd!=' ')&&(*keywordEnd!='\t')&&(*keywordEnd!='\r')&&(*keywordEnd!='\n')&&(*keywordEnd!='#'))
+            keywordEnd++;
+        string keyword(p, keywordEnd);
+        if ((keyword.size()<3)||(keyword.compare(keyword.size()-3, 3, "OFF")!=0)||(keyword.find_first_not_of("STCN")<keyword.size()-3))
             return false;
+        bool hasColors=(keyword.find('C')<keyword.size()-3);
+        int numExtraVertexValues=(keyword.find('N')<keyword.size()-3 ? 3 : 0)+(keyword.find("ST")<keyword.size()-3 ? 2 : 0);
+
         int NumofVertices, NumofFaces, NumofEdges;
-        char OFFString[6];
-        vector<vector<int> > RawFaces;
-        
-        FileHandle>>OFFString>>NumofVertices>>NumofFaces>>NumofEdges;
+        p=hedra::next_token(keywordEnd, bufferEnd);
+        if (!hedra::parse_int(p, bufferEnd, NumofVertices)) return false;
+        p=hedra::next_token(p, bufferEnd);
+        if (!hedra::parse_int(p, bufferEnd, NumofFaces)) return false;
+        p=hedra::next_token(p, bufferEnd);
+        if (!hedra::parse_int(p, bufferEnd, NumofEdges)) return false;
+        if ((NumofVertices<0)||(NumofFaces<0))
+            return false;
+        p=hedra::next_line(p, bufferEnd);
+
         V.resize(NumofVertices,3);
-        RawFaces.resize(NumofFaces);
         D.resize(NumofFaces,1);
-        for (int i=0;i<NumofVertices;i++)
-            FileHandle>>V(i,0)>>V(i,1)>>V(i,2);
-        
+
+        //the beginnings of the vertex and face lines
+        vector<const char*> lineStarts;
+        lineStarts.reserve(NumofVertices+NumofFaces);
+        while ((p<bufferEnd)&&(lineStarts.size()<(size_t)(NumofVertices+NumofFaces))){
+            if (!hedra::is_empty_line(p, bufferEnd))
+                lineStarts.push_back(p);
+            p=hedra::next_line(p, bufferEnd);
+        }
+
+        //one vertex or face per line, parsed in parallel
+        bool isLineBased=(lineStarts.size()==(size_t)(NumofVertices+NumofFaces));
+        vector<int> threadSuccess(std::max(numThreads,1),1);
+        vector<int> threadMaxD(std::max(numThreads,1),0);
+        if (isLineBased){
+            hedra::parallel_for(NumofVertices, [&](const int begin, const int end, const int threadIndex){
+                for (int i=begin;i<end;i++){
+                    const char* q=lineStarts[i];
+                    if (!(hedra::parse_double(q,bufferEnd,V(i,0))&&hedra::parse_double(q,bufferEnd,V(i,1))&&hedra::parse_double(q,bufferEnd,V(i,2))))
+                        threadSuccess[threadIndex]=0;
+                }
+            }, numThreads);
+
+            hedra::parallel_for(NumofFaces, [&](const int begin, const int end, const int threadIndex){
+                for (int i=begin;i<end;i++){
+                    const char* q=lineStarts[NumofVertices+i];
+                    if ((!hedra::parse_int(q,bufferEnd,D(i)))||(D(i)<0))
+                        threadSuccess[threadIndex]=0;
+                    else
+                        threadMaxD[threadIndex]=std::max(threadMaxD[threadIndex], D(i));
+                }
+            }, numThreads);
+
+            for (size_t t=0;t<threadSuccess.size();t++)
+                isLineBased=isLineBased&&threadSuccess[t];
+        }
+
+        if (isLineBased){
+            int maxD=0;
+            for (size_t t=0;t<threadMaxD.size();t++)
+                maxD=std::max(maxD, threadMaxD[t]);
+            F.resize(NumofFaces,maxD);
+            hedra::parallel_for(NumofFaces, [&](const int begin, const int end, const int threadIndex){
+                for (int i=begin;i<end;i++){
+                    const char* q=lineStarts[NumofVertices+i];
+                    int degree;
+                    hedra::parse_int(q,bufferEnd,degree);
+                    for (int j=0;j<D(i);j++)
+                        if ((!hedra::parse_int(q,bufferEnd,F(i,j)))||(F(i,j)<0)||(F(i,j)>=NumofVertices))
+                            threadSuccess[threadIndex]=0;
+                    for (int j=D(i);j<maxD;j++)
+                        F(i,j)=-1;  //to "don't care" vertices
+                }
+            }, numThreads);
+
+            for (size_t t=0;t<threadSuccess.size();t++)
+                isLineBased=isLineBased&&threadSuccess[t];
+        }
+
+        if (isLineBased)
+            return true;
+
+        //serial token-by-token fallback, for vertices and faces that span several lines. The number of color values is not known without the line structure.
+        if (hasColors)
+            return false;
+        p=(lineStarts.empty() ? bufferEnd : lineStarts[0]);
+        for (int i=0;i<NumofVertices;i++){
+            for (int k=0;k<3;k++){
+                p=hedra::next_token(p,bufferEnd);
+                if (!hedra::parse_double(p,bufferEnd,V(i,k)))
+                    return false;
+            }
+            double extraValue;
+            for (int k=0;k<numExtraVertexValues;k++){
+                p=hedra::next_token(p,bufferEnd);
+                if (!hedra::parse_double(p,bufferEnd,extraValue))
+                    return false;
+            }
+        }
+
+        vector<const char*> faceStarts(NumofFaces);
+        int maxD=0;
         for (int i=0;i<NumofFaces;i++){
-            FileHandle>>D(i);
-            RawFaces[i].resize(D(i));
-            for (int j=0;j<D(i);j++)
-                FileHandle>>RawFaces[i][j];
+            p=hedra::next_token(p,bufferEnd);
+            faceStarts[i]=p;
+            if ((!hedra::parse_int(p,bufferEnd,D(i)))||(D(i)<0))
+                return false;
+            maxD=std::max(maxD, D(i));
+            for (int j=0;j<D(i);j++){
+                int index;
+                p=hedra::next_token(p,bufferEnd);
+                if ((!hedra::parse_int(p,bufferEnd,index))||(index<0)||(index>=NumofVertices))
+                    return false;
+            }
         }
-        
-        F.resize(NumofFaces,D.maxCoeff());
+
+        F.resize(NumofFaces,maxD);
         F.setConstant(-1);  //to "don't care" vertices
-        for (int i=0;i<NumofFaces;i++)
-            for (int j=0;j<RawFaces[i].size();j++)
-                F(i,j)=RawFaces[i][j];
-        
-        FileHandle.close();
+        for (int i=0;i<NumofFaces;i++){
+            p=faceStarts[i];
+            int degree;
+            hedra::parse_int(p,bufferEnd,degree);
+            for (int j=0;j<D(i);j++){
+                p=hedra::next_token(p,bufferEnd);
+                hedra::parse_int(p,bufferEnd,F(i,j));
+            }
+        }
+
         return true;
     }
 }
 
 
 #endif
-
-
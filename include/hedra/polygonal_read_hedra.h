@@ -0,0 +1,66 @@
+// This file is part of libhedra, a library for polyhedral mesh processing
+//
+// Copyright (C) 2016 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+#ifndef HEDRA_POLYGONAL_READ_HEDRA_H
+#define HEDRA_POLYGONAL_READ_HEDRA_H
+#include <igl/igl_inline.h>
+#include <hedra/PolygonMesh.h>
+#include <hedra/MappedHedraMesh.h>
+#include <Eigen/Core>
+#include <string>
+
+namespace hedra
+{
+    // reads a mesh from a binary .hedra file into owned arrays. To use the file without any copy, open a MappedHedraMesh instead.
+    // Inputs:
+    //   str  path to .hedra file
+    // Outputs:
+    //  V  eigen double matrix  #V by 3 - vertex coordinates
+    //  P  the faces in CSR form
+    IGL_INLINE bool polygonal_read_hedra(const std::string str,
+                                         Eigen::MatrixXd& V,
+                                         hedra::PolygonMesh& P)
+    {
+        MappedHedraMesh mappedMesh;
+        if (!mappedMesh.open(str))
+            return false;
+        V=mappedMesh.V();
+        P.faceStart=mappedMesh.polygons().faceStart;
+        P.faceVertices=mappedMesh.polygons().faceVertices;
+        return true;
+    }
+
+    // Outputs:
+    //  V  eigen double matrix  #V by 3 - vertex coordinates
+    //  D  eigen int vector     #F by 1 - face degrees
+    //  F  eigen int matrix     #F by max(D) - vertex indices in face
+    IGL_INLINE bool polygonal_read_hedra(const std::string str,
+                                         Eigen::MatrixXd& V,
+                                         Eigen::VectorXi& D,
+                                         Eigen::MatrixXi& F)
+    {
+        MappedHedraMesh mappedMesh;
+        if (!mappedMesh.open(str))
+            return false;
+        V=mappedMesh.V();
+        PolygonMeshMap P=mappedMesh.polygons();
+        int maxDegree=0;
+        D.resize(P.num_faces());
+        for (int f=0;f<P.num_faces();f++){
+            D(f)=P.degree(f);
+            maxDegree=(D(f) > maxDegree ? D(f) : maxDegree);
+        }
+        F=Eigen::MatrixXi::Constant(P.num_faces(), maxDegree, -1);
+        for (int f=0;f<P.num_faces();f++)
+            for (int j=0;j<D(f);j++)
+                F(f,j)=P.vertex(f,j);
+        return true;
+    }
+}
+
+
+#endif
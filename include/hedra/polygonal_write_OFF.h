@@ -8,6 +8,8 @@
 #ifndef HEDRA_POLYGONAL_WRITE_OFF_H
 #define HEDRA_POLYGONAL_WRITE_OFF_H
 #include <igl/igl_inline.h>
+#include <hedra/PolygonMesh.h>
+#include <hedra/OFFStreamWriter.h>
 #include <Eigen/Core>
 #include <string>
 #include <vector>
@@ -16,6 +18,24 @@
 namespace hedra
 {
   // writes a polygonal mesh as an ascii OFF file
+  // The faces are written directly from P, through a buffered OFFStreamWriter; the vertex coordinates are written in shortest exact form.
+  // Inputs:
+  //   str  path to .off file
+  //  V  eigen double matrix  #V by 3 - vertex coordinates
+  //  P  PolygonMesh, PolygonMeshMap or PaddedPolygons (see PolygonMesh.h)
+  template<typename DerivedV, class Polygons>
+  IGL_INLINE bool polygonal_write_OFF(const std::string str,
+                                      const Eigen::MatrixBase<DerivedV>& V,
+                                      const Polygons& P)
+  {
+    OFFStreamWriter writer;
+    if (!writer.open(str, V.rows(), P.num_faces()))
+      return false;
+    writer.write_vertices(V);
+    writer.write_faces(P);
+    return writer.close();
+  }
+  
   // Inputs:
   //   str  path to .off file
   //  V  eigen double matrix  #V by 3 - vertex coordinates
@@ -26,25 +46,9 @@ namespace hedra
                                       const Eigen::VectorXi& D,
                                       const Eigen::MatrixXi& F)
   {
-    
-    using namespace std;
-    using namespace Eigen;
-    ofstream FileHandle;
-    FileHandle.open(str);
-    if (!FileHandle.is_open())
-      return false;
-    FileHandle<<"OFF"<<endl<<V.rows()<<" "<<F.rows()<<" 0"<<endl;
-    FileHandle<<V<<endl;
-    MatrixXi FD(D.rows(), D.cols()+F.cols());
-    FD<<D, F;
-    for (int i=0;i<F.rows();i++)
-      FileHandle<<FD.block(i,0,1,D(i)+1)<<endl;
-    FileHandle.close();
-    return true;
+    return polygonal_write_OFF(str, V, PaddedPolygons(D,F));
   }
 }
 
 
 #endif
-
-
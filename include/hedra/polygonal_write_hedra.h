@@ -0,0 +1,124 @@
+// This file is part of libhedra, a library for polyhedral mesh processing
+//
+// Copyright (C) 2016 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+#ifndef HEDRA_POLYGONAL_WRITE_HEDRA_H
+#define HEDRA_POLYGONAL_WRITE_HEDRA_H
+#include <igl/igl_inline.h>
+#include <hedra/PolygonMesh.h>
+#include <hedra/MappedHedraMesh.h>
+#include <hedra/polygonal_edge_topology.h>
+#include <hedra/dcel.h>
+#include <hedra/parallel_for.h>
+#include <Eigen/Core>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+
+namespace hedra
+{
+    // writes a polygonal mesh as a binary .hedra file (see MappedHedraMesh.h), to be loaded without parsing by MappedHedraMesh or polygonal_read_hedra
+    // Inputs:
+    //  str                  path to .hedra file
+    //  V                    eigen double matrix  #V by 3 - vertex coordinates
+    //  P                    PolygonMesh, PolygonMeshMap or PaddedPolygons (see PolygonMesh.h)
+    //  cacheConnectivity    also computes and stores the edge topology and the DCEL (on the CSR layout), so readers can skip them
+    template<class Polygons>
+    IGL_INLINE bool polygonal_write_hedra(const std::string str,
+                                          const Eigen::MatrixXd& V,
+                                          const Polygons& P,
+                                          const bool cacheConnectivity=false)
+    {
+        using namespace Eigen;
+
+        PolygonMesh csrMesh;
+        csrMesh.faceStart.resize(P.num_faces()+1);
+        csrMesh.faceStart(0)=0;
+        for (int f=0;f<P.num_faces();f++)
+            csrMesh.faceStart(f+1)=csrMesh.faceStart(f)+P.degree(f);
+        csrMesh.faceVertices.resize(csrMesh.faceStart(P.num_faces()));
+        for (int f=0;f<P.num_faces();f++)
+            for (int j=0;j<P.degree(f);j++)
+                csrMesh.faceVertices(csrMesh.faceStart(f)+j)=P.vertex(f,j);
+
+        HedraFileHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, "HEDRAMSH", 8);
+        header.version=HEDRA_FILE_VERSION;
+        header.endianTag=HEDRA_ENDIAN_TAG;
+        header.numV=V.rows();
+        header.numFaces=csrMesh.num_faces();
+        header.numCorners=csrMesh.num_corners();
+
+        MatrixXi EV, EF, EFi, EH;
+        VectorXi FE, innerEdges, VH, FH, HV, HE, HF, nextH, prevH, twinH;
+        VectorXd FEs;
+        if (cacheConnectivity){
+            int numThreads=hedra::default_num_threads();
+            hedra::polygonal_edge_topology(csrMesh, EV, FE, EF, EFi, FEs, innerEdges, numThreads);
+            hedra::dcel(csrMesh, EV, EF, EFi, innerEdges, VH, EH, FH, HV, HE, HF, nextH, prevH, twinH, numThreads);
+            //VH only covers the vertices up to the last referenced one
+            int numReferenced=VH.size();
+            VH.conservativeResize(V.rows());
+            for (int v=numReferenced;v<V.rows();v++)
+                VH(v)=-1;
+            header.flags=HEDRA_HAS_TOPOLOGY | HEDRA_HAS_DCEL;
+            header.numEdges=EV.rows();
+            header.numInnerEdges=innerEdges.size();
+            header.numHalfedges=HV.size();
+        }
+
+        const void* sectionData[HEDRA_NUM_SECTIONS]={V.data(), csrMesh.faceStart.data(), csrMesh.faceVertices.data(),
+            EV.data(), EF.data(), EFi.data(), FE.data(), FEs.data(), innerEdges.data(),
+            VH.data(), EH.data(), FH.data(), HV.data(), HE.data(), HF.data(), nextH.data(), prevH.data(), twinH.data()};
+        std::uint64_t sectionSize[HEDRA_NUM_SECTIONS]={(std::uint64_t)V.size()*sizeof(double), (std::uint64_t)csrMesh.faceStart.size()*sizeof(int), (std::uint64_t)csrMesh.faceVertices.size()*sizeof(int),
+            (std::uint64_t)EV.size()*sizeof(int), (std::uint64_t)EF.size()*sizeof(int), (std::uint64_t)EFi.size()*sizeof(int), (std::uint64_t)FE.size()*sizeof(int), (std::uint64_t)FEs.size()*sizeof(double), (std::uint64_t)innerEdges.size()*sizeof(int),
+            (std::uint64_t)VH.size()*sizeof(int), (std::uint64_t)EH.size()*sizeof(int), (std::uint64_t)FH.size()*sizeof(int), (std::uint64_t)HV.size()*sizeof(int), (std::uint64_t)HE.size()*sizeof(int), (std::uint64_t)HF.size()*sizeof(int), (std::uint64_t)nextH.size()*sizeof(int), (std::uint64_t)prevH.size()*sizeof(int), (std::uint64_t)twinH.size()*sizeof(int)};
+
+        const int numSections=(cacheConnectivity ? HEDRA_NUM_SECTIONS : HEDRA_FACE_VERTICES+1);
+        std::uint64_t currOffset=sizeof(HedraFileHeader);
+        for (int s=0;s<numSections;s++){
+            currOffset=(currOffset+63)/64*64;
+            header.sectionOffset[s]=currOffset;
+            header.sectionSize[s]=sectionSize[s];
+            currOffset+=sectionSize[s];
+        }
+
+        FILE* fileHandle=std::fopen(str.c_str(), "wb");
+        if (fileHandle==NULL)
+            return false;
+        bool success=(std::fwrite(&header, sizeof(header), 1, fileHandle)==1);
+        std::uint64_t writtenBytes=sizeof(header);
+        const char zeros[64]={0};
+        for (int s=0;(s<numSections)&&success;s++){
+            success=(std::fwrite(zeros, 1, header.sectionOffset[s]-writtenBytes, fileHandle)==header.sectionOffset[s]-writtenBytes);
+            if (sectionSize[s]>0)
+                success=success&&(std::fwrite(sectionData[s], 1, sectionSize[s], fileHandle)==sectionSize[s]);
+            writtenBytes=header.sectionOffset[s]+sectionSize[s];
+        }
+        success=(std::fclose(fileHandle)==0)&&success;
+        return success;
+    }
+
+    // Inputs:
+    //  str                  path to .hedra file
+    //  V                    eigen double matrix  #V by 3 - vertex coordinates
+    //  D                    eigen int vector     #F by 1 - face degrees
+    //  F                    eigen int matrix     #F by max(D) - vertex indices in face
+    //  cacheConnectivity    as above
+    IGL_INLINE bool polygonal_write_hedra(const std::string str,
+                                          const Eigen::MatrixXd& V,
+                                          const Eigen::VectorXi& D,
+                                          const Eigen::MatrixXi& F,
+                                          const bool cacheConnectivity=false)
+    {
+        return polygonal_write_hedra(str, V, PaddedPolygons(D,F), cacheConnectivity);
+    }
+}
+
+
+#endif
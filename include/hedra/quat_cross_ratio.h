@@ -29,15 +29,15 @@ namespace hedra
     {
         using namespace Eigen;
         cr.resize(Q.rows(),4);
-        for (int i=0;i<Q.rows();i++){
-            RowVector4d qi; qi<<0.0,V.row(Q(i,0));
-            RowVector4d qj; qj<<0.0,V.row(Q(i,1));
-            RowVector4d qk; qk<<0.0,V.row(Q(i,2));
-            RowVector4d ql; ql<<0.0,V.row(Q(i,3));
-            
-            cr.row(i)=QMult(QMult(qj-qi, QInv(qk-qj)),QMult(ql-qk, QInv(qi-ql)));
-            
+        QuatChunk qi, qj, qk, ql;
+        for (int start=0;start<Q.rows();start+=QuatChunk::MaxSize){
+            int size=QChunkSize(Q.rows(), start);
+            qi.gather_pure(V, Q.col(0), start, size);
+            qj.gather_pure(V, Q.col(1), start, size);
+            qk.gather_pure(V, Q.col(2), start, size);
+            ql.gather_pure(V, Q.col(3), start, size);
             
+            QMultChunk(QRatioChunk(qj, qi, qk, qj), QRatioChunk(ql, qk, qi, ql)).store(cr, start);
         }
         return true;
     }
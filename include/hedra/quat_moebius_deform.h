@@ -64,8 +64,10 @@ namespace hedra{
                                         const Eigen::MatrixXi& FE,
                                         const Eigen::MatrixXd& FEs,
                                         const Eigen::VectorXi& innerEdges,
-                                        struct QuatMoebiusData& qmdata)
+                                        struct QuatMoebiusData& qmdata,
+                                        const CeresSolveConfig& solveConfig=CeresSolveConfig())
   {
+    qmdata.solver.config=solveConfig;
     qmdata.F=F;
     qmdata.D=D;
     qmdata.origV=V;
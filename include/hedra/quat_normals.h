@@ -29,13 +29,16 @@ namespace hedra
   {
     using namespace Eigen;
     FN.resize(FaceTriads.rows(),4);
-    for (int i=0;i<FaceTriads.rows();i++){
-      RowVector4d qi=Vq.row(FaceTriads(i,0));
-      RowVector4d qj=Vq.row(FaceTriads(i,1));
-      RowVector4d qk=Vq.row(FaceTriads(i,2));
+    QuatChunk qi, qj, qk;
+    for (int start=0;start<FaceTriads.rows();start+=QuatChunk::MaxSize){
+      int size=QChunkSize(FaceTriads.rows(), start);
+      qi.gather(Vq, FaceTriads.col(0), start, size);
+      qj.gather(Vq, FaceTriads.col(1), start, size);
+      qk.gather(Vq, FaceTriads.col(2), start, size);
       
-      FN.row(i)=QMult(qj-qi, QInv(qk-qj));
+      QRatioChunk(qj, qi, qk, qj).store(FN, start);
     }
+    return true;
   }
   
 }
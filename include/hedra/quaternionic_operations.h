@@ -10,7 +10,244 @@
 #define HEDRA_QUATERNIONIC_OPERATIONS
 
 #include <iostream>
+#include <algorithm>
+#include <vector>
 #include <Eigen/Dense>
+#include <Eigen/Sparse>
+
+
+//Batches of quaternions are #q by 4 matrices, with the real part in the first column. In the default column-major storage, every component is a contiguous array (SoA), so the batch kernels below work on whole components with vectorized array operations.
+//They process the rows in chunks of QuatChunk, on fixed-size buffers on the stack, and write into a given result of the size of the batch, so that they never allocate, and the result may be one of the inputs.
+
+//A chunk of at most MaxSize quaternions, as four contiguous component arrays on the stack. Algorithms on batches can also load their inputs into chunks and compose the chunk kernels (e.g., QMultChunk()) directly, without any intermediate batches.
+struct QuatChunk{
+  enum {MaxSize=64};
+  typedef Eigen::Array<double, Eigen::Dynamic, 1, Eigen::ColMajor, MaxSize, 1> Component;
+  typedef Eigen::Array<bool, Eigen::Dynamic, 1, Eigen::ColMajor, MaxSize, 1> Mask;     //for per-quaternion cases with select()
+  Component r, x, y, z;
+
+  int size() const {return (int)r.size();}
+
+  //rows [start, start+size) of a batch
+  void load(const Eigen::Ref<const Eigen::MatrixXd>& q, const int start, const int size)
+  {
+    r=q.col(0).segment(start,size);
+    x=q.col(1).segment(start,size);
+    y=q.col(2).segment(start,size);
+    z=q.col(3).segment(start,size);
+  }
+
+  //rows [start, start+size) of #V by 3 coordinates, as pure quaternions
+  void load_pure(const Eigen::Ref<const Eigen::MatrixXd>& V, const int start, const int size)
+  {
+    r.setZero(size);
+    x=V.col(0).segment(start,size);
+    y=V.col(1).segment(start,size);
+    z=V.col(2).segment(start,size);
+  }
+
+  //the rows indices(start), ..., indices(start+size-1) of a batch (or, with gather_pure(), of #V by 3 coordinates)
+  void gather(const Eigen::MatrixXd& q, const Eigen::Ref<const Eigen::VectorXi>& indices, const int start, const int size)
+  {
+    r.resize(size); x.resize(size); y.resize(size); z.resize(size);
+    for (int i=0;i<size;i++){
+      r(i)=q(indices(start+i),0);
+      x(i)=q(indices(start+i),1);
+      y(i)=q(indices(start+i),2);
+      z(i)=q(indices(start+i),3);
+    }
+  }
+
+  void gather_pure(const Eigen::MatrixXd& V, const Eigen::Ref<const Eigen::VectorXi>& indices, const int start, const int size)
+  {
+    r.setZero(size); x.resize(size); y.resize(size); z.resize(size);
+    for (int i=0;i<size;i++){
+      x(i)=V(indices(start+i),0);
+      y(i)=V(indices(start+i),1);
+      z(i)=V(indices(start+i),2);
+    }
+  }
+
+  void store(Eigen::Ref<Eigen::MatrixXd> q, const int start) const
+  {
+    q.col(0).segment(start,size())=r.matrix();
+    q.col(1).segment(start,size())=x.matrix();
+    q.col(2).segment(start,size())=y.matrix();
+    q.col(3).segment(start,size())=z.matrix();
+  }
+
+  //only the imaginary part, into #V by 3 coordinates
+  void store_pure(Eigen::Ref<Eigen::MatrixXd> V, const int start) const
+  {
+    V.col(0).segment(start,size())=x.matrix();
+    V.col(1).segment(start,size())=y.matrix();
+    V.col(2).segment(start,size())=z.matrix();
+  }
+
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+//the size of the chunk of a batch of the given size that begins at start
+inline int QChunkSize(const int batchSize, const int start)
+{
+  return std::min((int)QuatChunk::MaxSize, batchSize-start);
+}
+
+inline QuatChunk operator+(const QuatChunk& a, const QuatChunk& b)
+{
+  QuatChunk c;
+  c.r=a.r+b.r; c.x=a.x+b.x; c.y=a.y+b.y; c.z=a.z+b.z;
+  return c;
+}
+
+inline QuatChunk operator-(const QuatChunk& a, const QuatChunk& b)
+{
+  QuatChunk c;
+  c.r=a.r-b.r; c.x=a.x-b.x; c.y=a.y-b.y; c.z=a.z-b.z;
+  return c;
+}
+
+inline QuatChunk operator-(const QuatChunk& a)
+{
+  QuatChunk c;
+  c.r=-a.r; c.x=-a.x; c.y=-a.y; c.z=-a.z;
+  return c;
+}
+
+inline QuatChunk operator*(const QuatChunk& a, const double s)
+{
+  QuatChunk c;
+  c.r=a.r*s; c.x=a.x*s; c.y=a.y*s; c.z=a.z*s;
+  return c;
+}
+
+inline QuatChunk QConjChunk(const QuatChunk& a)
+{
+  QuatChunk c;
+  c.r=a.r; c.x=-a.x; c.y=-a.y; c.z=-a.z;
+  return c;
+}
+
+inline QuatChunk QMultChunk(const QuatChunk& a, const QuatChunk& b)
+{
+  QuatChunk c;
+  c.r=a.r*b.r-a.x*b.x-a.y*b.y-a.z*b.z;
+  c.x=a.r*b.x+b.r*a.x+a.y*b.z-a.z*b.y;
+  c.y=a.r*b.y+b.r*a.y+a.z*b.x-a.x*b.z;
+  c.z=a.r*b.z+b.r*a.z+a.x*b.y-a.y*b.x;
+  return c;
+}
+
+inline QuatChunk QInvChunk(const QuatChunk& a)
+{
+  QuatChunk::Component squaredNorm=a.r*a.r+a.x*a.x+a.y*a.y+a.z*a.z;
+  QuatChunk c;
+  c.r=a.r/squaredNorm; c.x=-a.x/squaredNorm; c.y=-a.y/squaredNorm; c.z=-a.z/squaredNorm;
+  return c;
+}
+
+//(a-b)*(c-d)^-1, of which cross ratios and normals are made
+inline QuatChunk QRatioChunk(const QuatChunk& a, const QuatChunk& b, const QuatChunk& c, const QuatChunk& d)
+{
+  return QMultChunk(a-b, QInvChunk(c-d));
+}
+
+//with an imaginary part below 10e-6, the log is real
+inline QuatChunk QLogChunk(const QuatChunk& a)
+{
+  QuatChunk::Component nv=(a.x*a.x+a.y*a.y+a.z*a.z).sqrt();
+  QuatChunk::Component nq=(a.r*a.r+a.x*a.x+a.y*a.y+a.z*a.z).sqrt();
+  QuatChunk::Component vecCoeff=(nv<10e-6).select(0.0, (a.r/nq).acos()/nv);
+  QuatChunk c;
+  c.r=nq.log(); c.x=a.x*vecCoeff; c.y=a.y*vecCoeff; c.z=a.z*vecCoeff;
+  return c;
+}
+
+//with an imaginary part below 10e-6, the exponent is real
+inline QuatChunk QExpChunk(const QuatChunk& a)
+{
+  QuatChunk::Component nv=(a.x*a.x+a.y*a.y+a.z*a.z).sqrt();
+  QuatChunk::Component expr=a.r.exp();
+  QuatChunk::Component vecCoeff=(nv<10e-6).select(0.0, expr*nv.sin()/nv);
+  QuatChunk c;
+  c.r=(nv<10e-6).select(expr, expr*nv.cos()); c.x=a.x*vecCoeff; c.y=a.y*vecCoeff; c.z=a.z*vecCoeff;
+  return c;
+}
+
+//q^t=exp(t*log(q))
+inline QuatChunk QPowChunk(const QuatChunk& a, const double t)
+{
+  return QExpChunk(QLogChunk(a)*t);
+}
+
+//spherical linear interpolation a*(a^-1*b)^t
+inline QuatChunk QSlerpChunk(const QuatChunk& a, const QuatChunk& b, const double t)
+{
+  return QMultChunk(a, QPowChunk(QMultChunk(QInvChunk(a), b), t));
+}
+
+//conjugation only negates three columns, which Eigen already vectorizes over the whole batch; loading it into chunks would only add a copy
+inline void QConjBatch(const Eigen::Ref<const Eigen::MatrixXd>& q, Eigen::Ref<Eigen::MatrixXd> result)
+{
+  result.col(0)=q.col(0);
+  result.rightCols(3)=-q.rightCols(3);
+}
+
+inline void QMultBatch(const Eigen::Ref<const Eigen::MatrixXd>& q1, const Eigen::Ref<const Eigen::MatrixXd>& q2, Eigen::Ref<Eigen::MatrixXd> result)
+{
+  QuatChunk a, b;
+  for (int start=0;start<q1.rows();start+=QuatChunk::MaxSize){
+    a.load(q1, start, QChunkSize(q1.rows(), start));
+    b.load(q2, start, QChunkSize(q1.rows(), start));
+    QMultChunk(a, b).store(result, start);
+  }
+}
+
+inline void QInvBatch(const Eigen::Ref<const Eigen::MatrixXd>& q, Eigen::Ref<Eigen::MatrixXd> result)
+{
+  QuatChunk a;
+  for (int start=0;start<q.rows();start+=QuatChunk::MaxSize){
+    a.load(q, start, QChunkSize(q.rows(), start));
+    QInvChunk(a).store(result, start);
+  }
+}
+
+inline void QLogBatch(const Eigen::Ref<const Eigen::MatrixXd>& q, Eigen::Ref<Eigen::MatrixXd> result)
+{
+  QuatChunk a;
+  for (int start=0;start<q.rows();start+=QuatChunk::MaxSize){
+    a.load(q, start, QChunkSize(q.rows(), start));
+    QLogChunk(a).store(result, start);
+  }
+}
+
+inline void QExpBatch(const Eigen::Ref<const Eigen::MatrixXd>& q, Eigen::Ref<Eigen::MatrixXd> result)
+{
+  QuatChunk a;
+  for (int start=0;start<q.rows();start+=QuatChunk::MaxSize){
+    a.load(q, start, QChunkSize(q.rows(), start));
+    QExpChunk(a).store(result, start);
+  }
+}
+
+inline void QPowBatch(const Eigen::Ref<const Eigen::MatrixXd>& q, const double t, Eigen::Ref<Eigen::MatrixXd> result)
+{
+  QuatChunk a;
+  for (int start=0;start<q.rows();start+=QuatChunk::MaxSize){
+    a.load(q, start, QChunkSize(q.rows(), start));
+    QPowChunk(a, t).store(result, start);
+  }
+}
+
+inline void QSlerpBatch(const Eigen::Ref<const Eigen::MatrixXd>& q1, const Eigen::Ref<const Eigen::MatrixXd>& q2, const double t, Eigen::Ref<Eigen::MatrixXd> result)
+{
+  QuatChunk a, b;
+  for (int start=0;start<q1.rows();start+=QuatChunk::MaxSize){
+    a.load(q1, start, QChunkSize(q1.rows(), start));
+    b.load(q2, start, QChunkSize(q1.rows(), start));
+    QSlerpChunk(a, b, t).store(result, start);
+  }
+}
 
 
 inline Eigen::RowVector4d QConj(const Eigen::RowVector4d& q)
@@ -22,8 +259,8 @@ inline Eigen::RowVector4d QConj(const Eigen::RowVector4d& q)
 
 inline Eigen::MatrixXd QConjN(const Eigen::MatrixXd& q)
 {
-  Eigen::MatrixXd newq(q.rows(), q.cols());
-  newq<<q.col(0), -q.block(0,1,q.rows(),3);
+  Eigen::MatrixXd newq(q.rows(), 4);
+  QConjBatch(q, newq);
   return newq;
 }
 
@@ -39,35 +276,10 @@ inline Eigen::RowVector4d QMult(const Eigen::RowVector4d& q1, const Eigen::RowVe
     return newq;
 }
 
-
-/*{
-  Eigen::MatrixXd newq;
-  Eigen::VectorXd r1=q1.col(0);
-  Eigen::VectorXd r2=q2.col(0);
-  Eigen::MatrixXd v1=q1.block(0,1,q1.rows(),3);
-  Eigen::MatrixXd v2=q2.block(0,1,q2.rows(),3);
-  newq<<r1.array()*r2.array()-(v1.array()*v2.array()).rowwise().sum(), v2.rowwise()*r1.array()+v1.rowwise()*r2.array()+v1.rowwise().cross(v2);
-  return newq;
-}*/
-
 inline Eigen::MatrixXd QMultN(const Eigen::MatrixXd& q1, const Eigen::MatrixXd& q2)
 {
-  Eigen::MatrixXd newq(q1.rows(),4);
-  Eigen::VectorXd r1=q1.col(0);
-  Eigen::VectorXd r2=q2.col(0);
-  Eigen::MatrixXd v1=q1.block(0,1,q1.rows(), 3);
-  Eigen::MatrixXd v2=q2.block(0,1,q2.rows(), 3);
-  Eigen::MatrixXd r1mat; r1mat.resize(r1.rows(),3); r1mat<<r1, r1, r1;
-  Eigen::MatrixXd r2mat; r2mat.resize(r2.rows(),3); r2mat<<r2, r2, r2;
-  newq.col(0)=r1.cwiseProduct(r2)-(v1.cwiseProduct(v2)).rowwise().sum();
-  Eigen::MatrixXd v1cv2; v1cv2.resize(v1.rows(),3);
-  for (int i=0;i<v1.rows();i++){
-    Eigen::Vector3d vv1=v1.row(i);
-    Eigen::Vector3d vv2=v2.row(i);
-    v1cv2.row(i)=vv1.cross(vv2);
-    
-  }
-  newq.block(0,1,newq.rows(),newq.cols()-1)=v1.cwiseProduct(r2mat)+v2.cwiseProduct(r1mat)+v1cv2;
+  Eigen::MatrixXd newq(q1.rows(), 4);
+  QMultBatch(q1, q2, newq);
   return newq;
 }
 
@@ -78,40 +290,23 @@ inline Eigen::RowVector4d QInv(const Eigen::RowVector4d& q)
 
 inline Eigen::MatrixXd QInvN(const Eigen::MatrixXd& q)
 {
-  return(QConjN(q).cwiseQuotient(q.rowwise().squaredNorm().replicate(1,4)));
+  Eigen::MatrixXd newq(q.rows(), 4);
+  QInvBatch(q, newq);
+  return newq;
 }
 
 inline Eigen::MatrixXd QLogN(const Eigen::MatrixXd& q)
 {
-    Eigen::VectorXd nq=q.rowwise().norm();
-    Eigen::VectorXd nv=q.block(0,1,q.rows(),q.cols()-1).rowwise().norm();
-    Eigen::VectorXd acosqnq=acos((q.col(0).cwiseQuotient(nq)).array()).matrix().cwiseQuotient(nv);
-    Eigen::MatrixXd acosmat(acosqnq.rows(),3); acosmat<<acosqnq, acosqnq, acosqnq;
-    Eigen::MatrixXd logq(q.rows(),q.cols());
-    logq<<log(nq.array()), q.block(0,1,q.rows(),q.cols()-1).cwiseProduct(acosmat);
-    for (int i=0;i<logq.rows();i++)
-        if (nv(i)<10e-6)
-            logq.row(i)<<log(nq(i)),0.0,0.0,0.0;
-    
-    //cout<<"logq: "<<logq<<endl;
-    return logq;
+  Eigen::MatrixXd logq(q.rows(), 4);
+  QLogBatch(q, logq);
+  return logq;
 }
 
 inline Eigen::MatrixXd QExpN(const Eigen::MatrixXd& q)
 {
-    Eigen::VectorXd nv=q.block(0,1,q.rows(),q.cols()-1).rowwise().norm();
-    Eigen::VectorXd exp1=exp(q.col(0).array());
-    Eigen::MatrixXd exp1mat(exp1.rows(),4); exp1mat<<exp1,exp1,exp1,exp1;
-    Eigen::MatrixXd expq(q.rows(),q.cols());
-    Eigen::VectorXd sinnv=(sin(nv.array()).matrix()).cwiseQuotient(nv);
-    Eigen::MatrixXd sinnvmat(sinnv.rows(),3); sinnvmat<<sinnv,sinnv,sinnv;
-    expq<<cos(nv.array()), q.block(0,1,q.rows(),q.cols()-1).cwiseProduct(sinnvmat);
-    expq=expq.cwiseProduct(exp1mat);
-    for (int i=0;i<expq.rows();i++)
-        if (nv(i)<10e-6)
-            expq.row(i)<<exp1(i),0.0,0.0,0.0;
-    
-    return expq;
+  Eigen::MatrixXd expq(q.rows(), 4);
+  QExpBatch(q, expq);
+  return expq;
 }
 
 inline void Quat2Coords(const Eigen::MatrixXd& QV, Eigen::MatrixXd& V)
@@ -11,8 +11,10 @@
 #include <igl/igl_inline.h>
 #include <igl/setdiff.h>
 #include <igl/cat.h>
+#include <hedra/CholmodSolverWrapper.h>
 #include <Eigen/Core>
 #include <vector>
+#include <iostream>
 
 
 //These functions implements the following algorithm:
@@ -56,7 +58,7 @@ namespace hedra
         //relevant matrices
         Eigen::SparseMatrix<double> A, Q, C, E, At, W;
         
-        Eigen::SimplicialLLT<Eigen::SparseMatrix<double> > solver;
+        hedra::optimization::SparseLLTSolver solver;  //CHOLMOD with HEDRA_WITH_CHOLMOD (see CholmodSolverWrapper.h)
     };
 
     IGL_INLINE void shapeup_precompute(const Eigen::MatrixXd& V,
@@ -104,7 +106,7 @@ namespace hedra
         sudata.At=sudata.A.transpose();  //to save up this expensive computation.
         
         //weight matrix
-        vector<Triplet<double> > WTriplets;
+        std::vector<Triplet<double> > WTriplets;
         //std::cout<<"w: "<<w<<std::endl;
         currRow=0;
         for (int i=0;i<SD.rows();i++){
@@ -9,6 +9,7 @@
 #define HEDRA_SIMPLEST_SUBDIVISION_H
 #include <igl/igl_inline.h>
 #include <hedra/polygonal_face_centers.h>
+#include <hedra/PolygonMesh.h>
 #include <hedra/subdivision_basics.h>
 #include <hedra/moebius_simplest_subdivision.h>
 #include <hedra/linear_simplest_subdivision.h>
@@ -20,13 +21,12 @@
 namespace hedra
 {
   
-  IGL_INLINE bool simplest_subdivision(const Eigen::MatrixXd& V,
-                                       const Eigen::VectorXi& D,
-                                       const Eigen::MatrixXi& F,
-                                       OneRingSubdivisionData& sd,
-                                       Eigen::MatrixXd& fineV,
-                                       Eigen::VectorXi& fineD,
-                                       Eigen::MatrixXi& fineF)
+  // computes the vertices of the simplest subdivision, which are a point on each edge, by the order of sd.EV. The subdivision data is set up here.
+  IGL_INLINE bool simplest_subdivision_points(const Eigen::MatrixXd& V,
+                                              const Eigen::VectorXi& D,
+                                              const Eigen::MatrixXi& F,
+                                              OneRingSubdivisionData& sd,
+                                              Eigen::MatrixXd& fineV)
   {
     
     using namespace Eigen;
@@ -91,9 +91,24 @@ namespace hedra
     
     fineEdgePoints=sd.fourPointsInterpolation(a,b,c,d);
     
-    //constructing the topology
     fineV=fineEdgePoints;
+    return true;
+  }
+  
   
+  IGL_INLINE bool simplest_subdivision(const Eigen::MatrixXd& V,
+                                       const Eigen::VectorXi& D,
+                                       const Eigen::MatrixXi& F,
+                                       OneRingSubdivisionData& sd,
+                                       Eigen::MatrixXd& fineV,
+                                       Eigen::VectorXi& fineD,
+                                       Eigen::MatrixXi& fineF)
+  {
+    using namespace Eigen;
+    using namespace std;
+    simplest_subdivision_points(V, D, F, sd, fineV);
+    
+    //constructing the topology
     vector<int> emptyIntVector;
     vector< vector<int> > newFList;
     
@@ -131,6 +146,59 @@ namespace hedra
   }
   
   
+  //the same with the fine mesh as a PolygonMesh, whose faces are written directly in its CSR layout
+  IGL_INLINE bool simplest_subdivision(const Eigen::MatrixXd& V,
+                                       const Eigen::VectorXi& D,
+                                       const Eigen::MatrixXi& F,
+                                       OneRingSubdivisionData& sd,
+                                       Eigen::MatrixXd& fineV,
+                                       hedra::PolygonMesh& fineP)
+  {
+    using namespace Eigen;
+    simplest_subdivision_points(V, D, F, sd, fineV);
+    
+    //new faces from old faces, and then a face for every inner vertex, with its star edges
+    int numInnerVertices=sd.isBoundaryVertex.size()-sd.isBoundaryVertex.sum();
+    fineP.faceStart.resize(D.rows()+numInnerVertices+1);
+    fineP.faceStart(0)=0;
+    for (int i=0;i<D.rows();i++)
+      fineP.faceStart(i+1)=fineP.faceStart(i)+D(i);
+    int currFace=D.rows();
+    for (int i=0;i<sd.VH.rows();i++){
+      if (sd.isBoundaryVertex[i])
+        continue;  //at the moment, not making faces for boundary vertices
+      int degree=0;
+      int beginH=sd.VH(i);
+      int currH=beginH;
+      do{
+        degree++;
+        currH=sd.twinH(sd.prevH(currH));
+      }while((currH!=beginH)&&(currH!=-1));
+      fineP.faceStart(currFace+1)=fineP.faceStart(currFace)+degree;
+      currFace++;
+    }
+    
+    fineP.faceVertices.resize(fineP.faceStart(currFace));
+    int currCorner=0;
+    for (int i=0;i<D.rows();i++)
+      for (int j=0;j<D(i);j++)
+        fineP.faceVertices(currCorner++)=sd.FE(i,j);
+    
+    for (int i=0;i<sd.VH.rows();i++){
+      if (sd.isBoundaryVertex[i])
+        continue;
+      int beginH=sd.VH(i);
+      int currH=beginH;
+      do{
+        fineP.faceVertices(currCorner++)=sd.HE(currH);
+        currH=sd.twinH(sd.prevH(currH));
+      }while((currH!=beginH)&&(currH!=-1));
+    }
+    
+    return true;
+  }
+  
+  
   IGL_INLINE bool simplest_subdivision(const Eigen::MatrixXd& V,
                                        const Eigen::VectorXi& D,
                                        const Eigen::MatrixXi& F,
@@ -159,6 +227,30 @@ namespace hedra
     
     return true;
   }
+  
+  //PolygonMesh version (see PolygonMesh.h for what is copied)
+  IGL_INLINE bool simplest_subdivision(const Eigen::MatrixXd& V,
+                                       const hedra::PolygonMesh& P,
+                                       const int& st,
+                                       Eigen::MatrixXd& fineV,
+                                       hedra::PolygonMesh& fineP)
+  {
+    Eigen::VectorXi D;
+    Eigen::MatrixXi F;
+    P.to_padded(D,F);
+    switch (st){
+      case hedra::LINEAR_SUBDIVISION: {
+        hedra::LinearSimplestSubdivisionData lsd;
+        return simplest_subdivision(V, D, F, lsd, fineV, fineP);
+      }
+      case hedra::CANONICAL_MOEBIUS_SUBDIVISION: {
+        hedra::MoebiusSimplestSubdivisionData msd;
+        return simplest_subdivision(V, D, F, msd, fineV, fineP);
+      }
+      default: return false;
+    }
+  }
+  
 }
 
 
@@ -9,6 +9,7 @@
 #define HEDRA_SUBDIVISION_BASICS_H
 #include <igl/igl_inline.h>
 #include <hedra/vertex_valences.h>
+#include <hedra/parallel_for.h>
 #include <Eigen/Core>
 #include <string>
 #include <vector>
@@ -20,10 +21,11 @@ namespace hedra
   const int LINEAR_SUBDIVISION=0;
   const int CANONICAL_MOEBIUS_SUBDIVISION=1;
   
+  template<typename DerivedFH>
   IGL_INLINE bool vertex_stars(const Eigen::MatrixXi& EV,
                                const Eigen::VectorXi& VH,
                                const Eigen::MatrixXi& EH,
-                               const Eigen::MatrixXi& FH,
+                               const Eigen::PlainObjectBase<DerivedFH>& FH,
                                const Eigen::VectorXi& HV,
                                const Eigen::VectorXi& HE,
                                const Eigen::VectorXi& HF,
@@ -34,7 +36,8 @@ namespace hedra
                                Eigen::MatrixXi& starVertices,
                                Eigen::MatrixXi& starHalfedges,
                                Eigen::MatrixXi& ringFaces,
-                               Eigen::VectorXi& isBoundaryVertex)
+                               Eigen::VectorXi& isBoundaryVertex,
+                               const int numThreads=1)
   {
     
     using namespace Eigen;
@@ -46,30 +49,35 @@ namespace hedra
     ringFaces.conservativeResize(vertexValences.rows(),maxValence);
     isBoundaryVertex.conservativeResize(vertexValences.rows());
     
-    for (int i=0;i<vertexValences.rows();i++){
-      int beginH=VH(i);
-      int currH=beginH;
-      isBoundaryVertex(i)=1;
+    //the stars are independent, and are walked in parallel
+    hedra::parallel_for(vertexValences.rows(), [&](const int begin, const int end, const int threadIndex){
+      for (int i=begin;i<end;i++){
+        int beginH=VH(i);
+        int currH=beginH;
+        isBoundaryVertex(i)=1;
+        if (beginH==-1)  //an unreferenced vertex has an empty star
+          continue;
       
-      int currCounter=0;
-      while ((twinH(currH)!=-1)){
-        currH=nextH(twinH(currH));
-        if (currH==beginH) {isBoundaryVertex(i)=0; break;}
-      }
+        int currCounter=0;
+        while ((twinH(currH)!=-1)){
+          currH=nextH(twinH(currH));
+          if (currH==beginH) {isBoundaryVertex(i)=0; break;}
+        }
       
-      beginH=currH;
+        beginH=currH;
       
-      do{
-        starVertices(i,currCounter)=HV(nextH(currH));
-        ringFaces(i,currCounter)=HF(currH);
-        starHalfedges(i,currCounter++)=currH;
-        if(twinH(prevH(currH))==-1){  //last edge on the boundary should be accounted for
-          starVertices(i,currCounter)=HV(prevH(currH));
-          starHalfedges(i,currCounter++)=prevH(currH);
-        }
-        currH=twinH(prevH(currH));
-      }while ((beginH!=currH)&&(currH!=-1));
-    }
+        do{
+          starVertices(i,currCounter)=HV(nextH(currH));
+          ringFaces(i,currCounter)=HF(currH);
+          starHalfedges(i,currCounter++)=currH;
+          if(twinH(prevH(currH))==-1){  //last edge on the boundary should be accounted for
+            starVertices(i,currCounter)=HV(prevH(currH));
+            starHalfedges(i,currCounter++)=prevH(currH);
+          }
+          currH=twinH(prevH(currH));
+        }while ((beginH!=currH)&&(currH!=-1));
+      }
+    }, numThreads);
     
     return true;
   }
@@ -8,6 +8,7 @@
 #ifndef HEDRA_TRIANGULATE_MESH_H
 #define HEDRA_TRIANGULATE_MESH_H
 #include <igl/igl_inline.h>
+#include <hedra/PolygonMesh.h>
 #include <Eigen/Core>
 #include <string>
 #include <vector>
@@ -18,39 +19,46 @@ namespace hedra
     // returns a triangulated version of a polygonal mesh without adding steiner points (only diagonals)
     //TODO: smarter diagonalization with no self intersections.
     // Inputs:
-    //  D  eigen int vector     #F by 1 - face degrees
-    //  F  eigen int matrix     #F by max(D) - vertex indices in face
+    //  P  PolygonMesh or PaddedPolygons (see PolygonMesh.h)
     // Outputs:
     //  T  eigen int matrix     #T by 3 - triangles (T is actually sum(D)-rows(D))
     //  TF  eigen int vector    #T by 1 - the original polygonal face in F for each triangle
-    IGL_INLINE bool triangulate_mesh(const Eigen::VectorXi& D,
-                                     const Eigen::MatrixXi& F,
+    template<class Polygons>
+    IGL_INLINE bool triangulate_mesh(const Polygons& P,
                                      Eigen::MatrixXi& T,
                                      Eigen::VectorXi& TF)
     {
-        using namespace std;
-        vector<Eigen::Vector3i> NewTriangles;
-        vector<int> RawTF;
+        int numTriangles=0;
+        for (int i=0;i<P.num_faces();i++)
+            numTriangles+=(P.degree(i) > 2 ? P.degree(i)-2 : 0);
         
-        for (int i=0;i<D.rows();i++){
+        T.resize(numTriangles,3);
+        TF.resize(numTriangles);
+        int CurrTriangle=0;
+        for (int i=0;i<P.num_faces();i++){
         //triangulating the face greedily
-            for (int CurrIndex=1;CurrIndex<D(i)-1;CurrIndex++){
-                Eigen::Vector3i NewFace;
-                NewFace<<F(i,0),F(i,CurrIndex),F(i,CurrIndex+1);
-                RawTF.push_back(i);
-                NewTriangles.push_back(NewFace);
+            for (int CurrIndex=1;CurrIndex<P.degree(i)-1;CurrIndex++){
+                T.row(CurrTriangle)<<P.vertex(i,0),P.vertex(i,CurrIndex),P.vertex(i,CurrIndex+1);
+                TF(CurrTriangle++)=i;
             }
         }
         
-        T.resize(NewTriangles.size(),3);
-        TF.resize(RawTF.size());
-        for (int i=0;i<NewTriangles.size();i++){
-            T.row(i)=NewTriangles[i];
-            TF(i)=RawTF[i];
-        }
-        
         return true;
     }
+    
+    // Inputs:
+    //  D  eigen int vector     #F by 1 - face degrees
+    //  F  eigen int matrix     #F by max(D) - vertex indices in face
+    // Outputs:
+    //  T  eigen int matrix     #T by 3 - triangles (T is actually sum(D)-rows(D))
+    //  TF  eigen int vector    #T by 1 - the original polygonal face in F for each triangle
+    IGL_INLINE bool triangulate_mesh(const Eigen::VectorXi& D,
+                                     const Eigen::MatrixXi& F,
+                                     Eigen::MatrixXi& T,
+                                     Eigen::VectorXi& TF)
+    {
+        return triangulate_mesh(PaddedPolygons(D,F), T, TF);
+    }
 }
 
 
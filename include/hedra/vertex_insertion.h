@@ -9,6 +9,8 @@
 #define HEDRA_VERTEX_INSERTION_H
 #include <igl/igl_inline.h>
 #include <hedra/polygonal_face_centers.h>
+#include <hedra/PolygonMesh.h>
+#include <hedra/OFFStreamWriter.h>
 #include <hedra/subdivision_basics.h>
 #include <hedra/linear_vi_subdivision.h>
 #include <hedra/moebius_vi_subdivision.h>
@@ -19,24 +21,23 @@
 
 namespace hedra
 {
-  // returns a mesh after vertex insertion, which is basically vertex insertion in the barycenter of each face, connected with all midedges
+  // computes the new points of vertex insertion: the fine vertex points, a point on each edge, and a point in each face. The fine mesh vertices are [fineVertexPoints; fineEdgePoints; fineFacePoints].
   // Inputs:
   //  V  eigen double matrix     #V by 3 - vertex coordinates
   //  D  eigen int vector        #F by 1 - face degrees
   //  F  eigen int matrix        #F by max(D) - vertex indices in face
-  //  FE eign int matrix         #F by max(D) - edges by order in face
-  
+  //  sd                         the subdivision data, which is set up here
   // Outputs:
-  //  newV  eigen double matrix  new vertices
-  //  newD  eigen int vector    new valences
-  //  newF eigen int matrix     new faces
-  IGL_INLINE bool vertex_insertion(const Eigen::MatrixXd& V,
-                                   const Eigen::VectorXi& D,
-                                   const Eigen::MatrixXi& F,
-                                   OneRingSubdivisionData& sd,
-                                   Eigen::MatrixXd& fineV,
-                                   Eigen::VectorXi& fineD,
-                                   Eigen::MatrixXi& fineF)
+  //  fineVertexPoints  #V by 3
+  //  fineEdgePoints    #E by 3, by the order of sd.EV
+  //  fineFacePoints    #F by 3
+  IGL_INLINE bool vertex_insertion_points(const Eigen::MatrixXd& V,
+                                          const Eigen::VectorXi& D,
+                                          const Eigen::MatrixXi& F,
+                                          OneRingSubdivisionData& sd,
+                                          Eigen::MatrixXd& fineVertexPoints,
+                                          Eigen::MatrixXd& fineEdgePoints,
+                                          Eigen::MatrixXd& fineFacePoints)
   {
     
     
@@ -44,9 +45,9 @@ namespace hedra
     
     sd.setup(V,D,F);
     
-    Eigen::MatrixXd fineVertexPoints(V.rows(),3);
-    Eigen::MatrixXd fineFacePoints(F.rows(),3);
-    Eigen::MatrixXd fineEdgePoints(sd.EV.rows(),3);
+    fineVertexPoints.resize(V.rows(),3);
+    fineFacePoints.resize(F.rows(),3);
+    fineEdgePoints.resize(sd.EV.rows(),3);
     
     
     MatrixXd candidateFacePoints(F.rows(), D.maxCoeff()*3);
@@ -227,7 +228,33 @@ namespace hedra
       }
     }
     
-    std::cout<<"(fineVertexPoints-V).lpNorm<Infinity>()" <<(fineVertexPoints-V).lpNorm<Infinity>()<<std::endl;
+    return true;
+  }
+  
+  
+  // returns a mesh after vertex insertion, which is basically vertex insertion in the barycenter of each face, connected with all midedges
+  // Inputs:
+  //  V  eigen double matrix     #V by 3 - vertex coordinates
+  //  D  eigen int vector        #F by 1 - face degrees
+  //  F  eigen int matrix        #F by max(D) - vertex indices in face
+  //  FE eign int matrix         #F by max(D) - edges by order in face
+  
+  // Outputs:
+  //  newV  eigen double matrix  new vertices
+  //  newD  eigen int vector    new valences
+  //  newF eigen int matrix     new faces
+  IGL_INLINE bool vertex_insertion(const Eigen::MatrixXd& V,
+                                   const Eigen::VectorXi& D,
+                                   const Eigen::MatrixXi& F,
+                                   OneRingSubdivisionData& sd,
+                                   Eigen::MatrixXd& fineV,
+                                   Eigen::VectorXi& fineD,
+                                   Eigen::MatrixXi& fineF)
+  {
+    using namespace Eigen;
+    
+    MatrixXd fineVertexPoints, fineEdgePoints, fineFacePoints;
+    vertex_insertion_points(V, D, F, sd, fineVertexPoints, fineEdgePoints, fineFacePoints);
     
     fineV.conservativeResize(fineVertexPoints.rows()+fineFacePoints.rows()+fineEdgePoints.rows(),3);
     fineV<<fineVertexPoints, fineEdgePoints, fineFacePoints;
@@ -248,6 +275,71 @@ namespace hedra
   }
   
   
+  //the same with the fine mesh as a PolygonMesh, whose quads are written directly in its CSR layout
+  IGL_INLINE bool vertex_insertion(const Eigen::MatrixXd& V,
+                                   const Eigen::VectorXi& D,
+                                   const Eigen::MatrixXi& F,
+                                   OneRingSubdivisionData& sd,
+                                   Eigen::MatrixXd& fineV,
+                                   hedra::PolygonMesh& fineP)
+  {
+    using namespace Eigen;
+    
+    MatrixXd fineVertexPoints, fineEdgePoints, fineFacePoints;
+    vertex_insertion_points(V, D, F, sd, fineVertexPoints, fineEdgePoints, fineFacePoints);
+    
+    fineV.conservativeResize(fineVertexPoints.rows()+fineFacePoints.rows()+fineEdgePoints.rows(),3);
+    fineV<<fineVertexPoints, fineEdgePoints, fineFacePoints;
+    int numNewFaces=D.sum();
+    fineP.faceStart=VectorXi::LinSpaced(numNewFaces+1, 0, 4*numNewFaces);
+    fineP.faceVertices.resize(4*numNewFaces);
+    int currCorner=0;
+    for (int i=0;i<D.rows();i++){
+      for (int j=0;j<D(i);j++){
+        fineP.faceVertices(currCorner++)=F(i,j);
+        fineP.faceVertices(currCorner++)=V.rows()+sd.FE(i,j);
+        fineP.faceVertices(currCorner++)=V.rows()+fineEdgePoints.rows()+i;
+        fineP.faceVertices(currCorner++)=V.rows()+sd.FE(i,(j+D(i)-1)%D(i));
+      }
+    }
+    
+    return true;
+  }
+  
+  
+  //streaming version: the fine mesh is written directly to an open OFFStreamWriter, to which nothing has been written yet, without forming fineV and fineF. The quads are emitted face by face from the coarse mesh.
+  IGL_INLINE bool vertex_insertion(const Eigen::MatrixXd& V,
+                                   const Eigen::VectorXi& D,
+                                   const Eigen::MatrixXi& F,
+                                   OneRingSubdivisionData& sd,
+                                   hedra::OFFStreamWriter& fineWriter)
+  {
+    using namespace Eigen;
+    
+    MatrixXd fineVertexPoints, fineEdgePoints, fineFacePoints;
+    vertex_insertion_points(V, D, F, sd, fineVertexPoints, fineEdgePoints, fineFacePoints);
+    if ((!fineWriter.write_vertices(fineVertexPoints))||(!fineWriter.write_vertices(fineEdgePoints)))
+      return false;
+    fineVertexPoints.resize(0,3);
+    fineEdgePoints.resize(0,3);
+    if (!fineWriter.write_vertices(fineFacePoints))
+      return false;
+    
+    for (int i=0;i<D.rows();i++){
+      for (int j=0;j<D(i);j++){
+        int quad[4]={F(i,j),
+          (int)V.rows()+sd.FE(i,j),
+          (int)V.rows()+(int)sd.EV.rows()+i,
+          (int)V.rows()+sd.FE(i,(j+D(i)-1)%D(i))};
+        if (!fineWriter.write_face(4, quad))
+          return false;
+      }
+    }
+    
+    return true;
+  }
+  
+  
   //user version
   IGL_INLINE bool vertex_insertion(const Eigen::MatrixXd& V,
                                    const Eigen::VectorXi& D,
@@ -278,6 +370,48 @@ namespace hedra
     return true;
   }
   
+  //streaming user version
+  IGL_INLINE bool vertex_insertion(const Eigen::MatrixXd& V,
+                                   const Eigen::VectorXi& D,
+                                   const Eigen::MatrixXi& F,
+                                   const int& st,
+                                   hedra::OFFStreamWriter& fineWriter)
+  {
+    switch (st){
+      case hedra::LINEAR_SUBDIVISION: {
+        hedra::LinearVISubdivisionData lsd;
+        return vertex_insertion(V, D, F, lsd, fineWriter);
+      }
+      case hedra::CANONICAL_MOEBIUS_SUBDIVISION: {
+        hedra::MoebiusVISubdivisionData msd;
+        return vertex_insertion(V, D, F, msd, fineWriter);
+      }
+      default: return false;
+    }
+  }
+  
+  //PolygonMesh user version (see PolygonMesh.h for what is copied)
+  IGL_INLINE bool vertex_insertion(const Eigen::MatrixXd& V,
+                                   const hedra::PolygonMesh& P,
+                                   const int& st,
+                                   Eigen::MatrixXd& fineV,
+                                   hedra::PolygonMesh& fineP)
+  {
+    Eigen::VectorXi D;
+    Eigen::MatrixXi F;
+    P.to_padded(D,F);
+    switch (st){
+      case hedra::LINEAR_SUBDIVISION: {
+        hedra::LinearVISubdivisionData lsd;
+        return vertex_insertion(V, D, F, lsd, fineV, fineP);
+      }
+      case hedra::CANONICAL_MOEBIUS_SUBDIVISION: {
+        hedra::MoebiusVISubdivisionData msd;
+        return vertex_insertion(V, D, F, msd, fineV, fineP);
+      }
+      default: return false;
+    }
+  }
   
 }
 
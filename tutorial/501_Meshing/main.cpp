@@ -1,14 +1,14 @@
 #include <algorithm>
 #include <math.h>
 #include <igl/opengl/glfw/Viewer.h>
-#include <igl/readOBJ.h>
+#include <hedra/polygonal_read_OBJ.h>
 #include <hedra/polygonal_edge_topology.h>
 #include <hedra/copyleft/cgal/generate_mesh.h>
 #include <hedra/polygonal_write_OFF.h>
 
 Eigen::MatrixXd V, TV, newV;
 Eigen::MatrixXi F, newF, FTC;
-Eigen::VectorXi newD;
+Eigen::VectorXi D, newD;
 
 bool key_down(igl::opengl::glfw::Viewer& viewer, unsigned char key, int modifiers)
 {
@@ -26,18 +26,17 @@ int main(int argc, char *argv[])
   "3: Show final mesh"<<endl;
 
   Eigen::MatrixXd TC;
-  Eigen::MatrixXd N;
-  Eigen::MatrixXd FN, FEs;
+  Eigen::MatrixXd FEs;
   Eigen::MatrixXi EF, FE, EV, EFi;
   Eigen::VectorXi innerEdges;
-  igl::readOBJ(TUTORIAL_SHARED_PATH "/horsers-param-full-seamless.obj", V, TC, N, F, FTC, FN);
+  hedra::polygonal_read_OBJ(TUTORIAL_SHARED_PATH "/horsers-param-full-seamless.obj", V, TC, D, F, FTC);
   
   //OBJ values are skewed to fit PNG as follows
   //OutputCornerValues=[CornerValues(:,1)/3 CornerValues(:,2)/sqrt(3)];
   //TC.col(0).array()*=3;
   //TC.col(1).array()*=SQRT3;
   
-  hedra::polygonal_edge_topology(VectorXi::Constant(F.rows(),3), F,EV,FE,EF, EFi, FEs, innerEdges);
+  hedra::polygonal_edge_topology(D, F,EV,FE,EF, EFi, FEs, innerEdges);
   
   Eigen::RowVector3d spans=V.colwise().maxCoeff()-V.colwise().minCoeff();
   hedra::copyleft::cgal::generate_mesh(4, V, F, EV, FE, EF, EFi, innerEdges, TC, FTC, newV, newD, newF);